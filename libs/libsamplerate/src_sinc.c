@@ -13,6 +13,11 @@
 
 #include "common.h"
 
+#if !defined(HAVE_SSE2_INTRINSICS) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define HAVE_NEON_INTRINSICS
+#endif
+
 #define SINC_MAGIC_MARKER MAKE_MAGIC(' ', 's', 'i', 'n', 'c', ' ')
 
 //==============================================================================
@@ -37,6 +42,25 @@ typedef float coeff_t;
 // Sanity Check
 typedef int _CHECK_SHIFT_BITS[2 * (SHIFT_BITS < sizeof(increment_t) * 8 - 1) - 1];
 
+// Size of the polyphase table hash and the maximum number of phases
+// stored in it. A constant ratio between two common sample rates uses
+// at most a few hundred distinct phases (147 for 44100 -> 48000, 640
+// for 11025 -> 48000); other ratios fall back to the generic path once
+// the table is full.
+#define PHASE_TABLE_SIZE 2048
+#define PHASE_TABLE_MAX  1024
+
+// The interpolated coefficients for both halves of the filter at one
+// start_filter_index, laid out in input buffer order so that an output
+// sample is a single dot product.
+typedef struct
+{
+    increment_t start_filter_index;
+    int left;       // taps before b_current
+    int count;
+    float* coeffs;  // NULL if the slot is unused
+} SINC_PHASE;
+
 #ifdef ENABLE_SINC_FAST_CONVERTER
 #include "fastest_coeffs.h"
 #endif
@@ -74,6 +98,14 @@ typedef struct
     double right_calc[MAX_CHANNELS];
 
     float* buffer;
+
+    // Polyphase table for the mono converter, built lazily while the
+    // ratio is constant.
+    increment_t phase_increment;
+    int phase_count;
+    int phase_stride;
+    SINC_PHASE* phases;
+    float* phase_coeffs;
 } SINC_FILTER;
 
 static SRC_ERROR sinc_multichan_vari_process(SRC_STATE* state, SRC_DATA* data);
@@ -309,6 +341,12 @@ static SRC_STATE* sinc_copy(SRC_STATE* state) {
     }
     memcpy(to_filter->buffer, from_filter->buffer, sizeof(float) * (from_filter->b_len + state->channels));
 
+    // The copy builds its own polyphase table.
+    to_filter->phase_increment = 0;
+    to_filter->phase_count = 0;
+    to_filter->phases = NULL;
+    to_filter->phase_coeffs = NULL;
+
     to->private_data = to_filter;
 
     return to;
@@ -386,6 +424,129 @@ static inline double calc_output_single(const SINC_FILTER* filter,
     return (left + right);
 }
 
+static inline float
+#ifdef USE_TARGET_ATTRIBUTE
+    __attribute__((target("sse2")))
+#endif
+    dot_product(const float* a, const float* b, int count)
+{
+    int i = 0;
+    float result;
+
+#if defined(HAVE_SSE2_INTRINSICS)
+    __m128 sum0 = _mm_setzero_ps();
+    __m128 sum1 = _mm_setzero_ps();
+    for (; i + 8 <= count; i += 8) {
+        sum0 = _mm_add_ps(sum0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+        sum1 = _mm_add_ps(sum1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+    }
+    sum0 = _mm_add_ps(sum0, sum1);
+    sum0 = _mm_add_ps(sum0, _mm_movehl_ps(sum0, sum0));
+    sum0 = _mm_add_ss(sum0, _mm_shuffle_ps(sum0, sum0, 1));
+    result = _mm_cvtss_f32(sum0);
+#elif defined(HAVE_NEON_INTRINSICS)
+    float32x4_t sum0 = vdupq_n_f32(0.0f);
+    float32x4_t sum1 = vdupq_n_f32(0.0f);
+    for (; i + 8 <= count; i += 8) {
+        sum0 = vmlaq_f32(sum0, vld1q_f32(a + i), vld1q_f32(b + i));
+        sum1 = vmlaq_f32(sum1, vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
+    }
+    sum0 = vaddq_f32(sum0, sum1);
+    float32x2_t half = vadd_f32(vget_low_f32(sum0), vget_high_f32(sum0));
+    result = vget_lane_f32(vpadd_f32(half, half), 0);
+#else
+    result = 0.0f;
+#endif
+
+    for (; i < count; i++) {
+        result += a[i] * b[i];
+    }
+
+    return result;
+}
+
+static inline double interpolate_coeff(const SINC_FILTER* filter,
+                                       increment_t filter_index)
+{
+    double fraction = fp_to_double(filter_index);
+    int indx = fp_to_int(filter_index);
+    assert(indx >= 0 && indx + 1 < filter->coeff_half_len + 2);
+    return filter->coeffs[indx] + fraction * (filter->coeffs[indx + 1] - filter->coeffs[indx]);
+}
+
+// Returns the polyphase table entry for the given start_filter_index,
+// building it if needed, or NULL if the table is full.
+static const SINC_PHASE* sinc_get_phase(SINC_FILTER* filter,
+                                        increment_t increment,
+                                        increment_t start_filter_index)
+{
+    increment_t max_filter_index = int_to_fp(filter->coeff_half_len);
+
+    if (filter->phase_increment != increment) {
+        // The coefficients depend on the increment; start over.
+        int stride = 2 * (max_filter_index / increment) + 2;
+        float* coeffs = (float *) realloc(filter->phase_coeffs, (size_t) PHASE_TABLE_MAX * stride * sizeof(float));
+        if (!coeffs) {
+            return NULL;
+        }
+        filter->phase_coeffs = coeffs;
+        filter->phase_stride = stride;
+
+        if (!filter->phases) {
+            filter->phases = (SINC_PHASE *) malloc(PHASE_TABLE_SIZE * sizeof(SINC_PHASE));
+            if (!filter->phases) {
+                return NULL;
+            }
+        }
+        for (int i = 0; i < PHASE_TABLE_SIZE; i++) {
+            filter->phases[i].coeffs = NULL;
+        }
+        filter->phase_count = 0;
+        filter->phase_increment = increment;
+    }
+
+    unsigned int slot = ((uint32_t) start_filter_index * 2654435761u) % PHASE_TABLE_SIZE;
+    while (filter->phases[slot].coeffs != NULL) {
+        if (filter->phases[slot].start_filter_index == start_filter_index) {
+            return &filter->phases[slot];
+        }
+        slot = (slot + 1) % PHASE_TABLE_SIZE;
+    }
+
+    if (filter->phase_count == PHASE_TABLE_MAX) {
+        return NULL;
+    }
+
+    // These are the taps calc_output_single visits, with the left half
+    // reversed so that both halves run in buffer order.
+    SINC_PHASE* phase = &filter->phases[slot];
+    int left = (max_filter_index - start_filter_index) / increment;
+    int right = (max_filter_index - (increment - start_filter_index)) / increment;
+
+    phase->start_filter_index = start_filter_index;
+    phase->left = left;
+    phase->count = left + right + 2;
+    phase->coeffs = filter->phase_coeffs + filter->phase_count * filter->phase_stride;
+    filter->phase_count++;
+
+    for (int i = 0; i <= left; i++) {
+        phase->coeffs[i] = (float) interpolate_coeff(filter, start_filter_index + (left - i) * increment);
+    }
+    for (int i = 0; i <= right; i++) {
+        phase->coeffs[left + 1 + i] = (float) interpolate_coeff(filter, increment - start_filter_index + i * increment);
+    }
+
+    return phase;
+}
+
+static inline double calc_output_phase(const SINC_FILTER* filter,
+                                       const SINC_PHASE* phase)
+{
+    int data_index = filter->b_current - phase->left;
+    assert(data_index >= 0 && data_index + phase->count <= filter->b_end);
+    return dot_product(phase->coeffs, filter->buffer + data_index, phase->count);
+}
+
 static SRC_ERROR sinc_mono_vari_process(SRC_STATE* state, SRC_DATA* data) {
     SINC_FILTER* filter;
     double input_index;
@@ -436,6 +597,10 @@ static SRC_ERROR sinc_mono_vari_process(SRC_STATE* state, SRC_DATA* data) {
 
     terminate = 1.0 / src_ratio + 1e-20;
 
+    // With a constant ratio the same filter phases repeat, so their
+    // coefficients come from the polyphase table.
+    bool fixed_ratio = fabs(state->last_ratio - data->src_ratio) <= 1e-10;
+
     // Main processing loop.
     while (filter->out_gen < filter->out_count) {
         // Need to reload buffer?
@@ -469,7 +634,19 @@ static SRC_ERROR sinc_mono_vari_process(SRC_STATE* state, SRC_DATA* data) {
 
         start_filter_index = double_to_fp(input_index * float_increment);
 
-        data->data_out[filter->out_gen] = (float) ((float_increment / filter->index_inc) * calc_output_single(filter, increment, start_filter_index));
+        const SINC_PHASE* phase = NULL;
+        if (fixed_ratio) {
+            phase = sinc_get_phase(filter, increment, start_filter_index);
+        }
+
+        double output;
+        if (phase != NULL && filter->b_current >= phase->left) {
+            output = calc_output_phase(filter, phase);
+        } else {
+            output = calc_output_single(filter, increment, start_filter_index);
+        }
+
+        data->data_out[filter->out_gen] = (float) ((float_increment / filter->index_inc) * output);
         filter->out_gen++;
 
         // Figure out the next index.
@@ -1309,6 +1486,8 @@ static void sinc_close(SRC_STATE *state) {
             free(sinc->buffer);
             sinc->buffer = NULL;
         }
+        free(sinc->phases);
+        free(sinc->phase_coeffs);
         free(sinc);
         sinc = NULL;
     }
@@ -19,6 +19,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "SDL.h"
 
@@ -49,6 +50,7 @@ static opl_driver_t *driver = NULL;
 static int init_stage_reg_writes = 1;
 
 unsigned int opl_sample_rate = 22050;
+int opl_render_mode = 0;
 
 //
 // Init/shutdown code.
@@ -126,6 +128,17 @@ opl_init_result_t OPL_Init(unsigned int port_base)
 
     driver_name = getenv("OPL_DRIVER");
 
+    // Only the software emulator can render on demand.
+
+    if (opl_render_mode)
+    {
+#ifndef DISABLE_SDL2MIXER
+        return InitDriver(&opl_sdl_driver, port_base);
+#else
+        return OPL_INIT_NONE;
+#endif
+    }
+
     if (driver_name != NULL)
     {
         // Search the list until we find the driver with this name.
@@ -176,6 +189,24 @@ void OPL_SetSampleRate(unsigned int rate)
     opl_sample_rate = rate;
 }
 
+void OPL_SetRenderMode(int render)
+{
+    opl_render_mode = render;
+}
+
+void OPL_Render(int16_t *buffer, unsigned int nsamples)
+{
+#ifndef DISABLE_SDL2MIXER
+    if (driver == &opl_sdl_driver && opl_render_mode)
+    {
+        OPL_SDL_Render(buffer, nsamples);
+        return;
+    }
+#endif
+
+    memset(buffer, 0, nsamples * 4);
+}
+
 void OPL_WritePort(opl_port_t port, unsigned int value)
 {
     if (driver != NULL)
@@ -471,6 +502,27 @@ void OPL_Delay(uint64_t us)
         return;
     }
 
+    // In render mode nothing else is advancing time, so run the
+    // emulator forward and throw the output away.
+
+    if (opl_render_mode)
+    {
+        int16_t buffer[256 * 2];
+        uint64_t nsamples;
+
+        nsamples = (us * opl_sample_rate + OPL_SECOND - 1) / OPL_SECOND;
+
+        while (nsamples > 0)
+        {
+            unsigned int n = nsamples < 256 ? (unsigned int) nsamples : 256;
+
+            OPL_Render(buffer, n);
+            nsamples -= n;
+        }
+
+        return;
+    }
+
     // Create a callback that will signal this thread after the
     // specified time.
 
@@ -84,6 +84,17 @@ void OPL_Shutdown(void);
 
 void OPL_SetSampleRate(unsigned int rate);
 
+// Enable render mode, where the software emulator is not connected
+// to an audio device and output is pulled with OPL_Render() instead.
+// Must be set before OPL_Init().
+
+void OPL_SetRenderMode(int render);
+
+// In render mode, generate the next nsamples stereo samples into
+// buffer, invoking callbacks as emulated time passes.
+
+void OPL_Render(int16_t *buffer, unsigned int nsamples);
+
 // Write to one of the OPL I/O ports:
 
 void OPL_WritePort(opl_port_t port, unsigned int value);
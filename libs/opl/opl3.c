@@ -1041,6 +1041,17 @@ static Bit16s OPL3_ClipSample(Bit32s sample)
     return (Bit16s)sample;
 }
 
+// Clock one slot. The slots must be processed in order, because the
+// phase generator steps the shared noise generator.
+
+static void OPL3_ProcessSlot(opl3_slot *slot)
+{
+    OPL3_SlotCalcFB(slot);
+    OPL3_EnvelopeCalc(slot);
+    OPL3_PhaseGenerate(slot);
+    OPL3_SlotGenerate(slot);
+}
+
 void OPL3_Generate(opl3_chip *chip, Bit16s *buf)
 {
     Bit8u ii;
@@ -1052,10 +1063,7 @@ void OPL3_Generate(opl3_chip *chip, Bit16s *buf)
 
     for (ii = 0; ii < 15; ii++)
     {
-        OPL3_SlotCalcFB(&chip->slot[ii]);
-        OPL3_EnvelopeCalc(&chip->slot[ii]);
-        OPL3_PhaseGenerate(&chip->slot[ii]);
-        OPL3_SlotGenerate(&chip->slot[ii]);
+        OPL3_ProcessSlot(&chip->slot[ii]);
     }
 
     chip->mixbuff[0] = 0;
@@ -1071,20 +1079,14 @@ void OPL3_Generate(opl3_chip *chip, Bit16s *buf)
 
     for (ii = 15; ii < 18; ii++)
     {
-        OPL3_SlotCalcFB(&chip->slot[ii]);
-        OPL3_EnvelopeCalc(&chip->slot[ii]);
-        OPL3_PhaseGenerate(&chip->slot[ii]);
-        OPL3_SlotGenerate(&chip->slot[ii]);
+        OPL3_ProcessSlot(&chip->slot[ii]);
     }
 
     buf[0] = OPL3_ClipSample(chip->mixbuff[0]);
 
     for (ii = 18; ii < 33; ii++)
     {
-        OPL3_SlotCalcFB(&chip->slot[ii]);
-        OPL3_EnvelopeCalc(&chip->slot[ii]);
-        OPL3_PhaseGenerate(&chip->slot[ii]);
-        OPL3_SlotGenerate(&chip->slot[ii]);
+        OPL3_ProcessSlot(&chip->slot[ii]);
     }
 
     chip->mixbuff[1] = 0;
@@ -1100,10 +1102,7 @@ void OPL3_Generate(opl3_chip *chip, Bit16s *buf)
 
     for (ii = 33; ii < 36; ii++)
     {
-        OPL3_SlotCalcFB(&chip->slot[ii]);
-        OPL3_EnvelopeCalc(&chip->slot[ii]);
-        OPL3_PhaseGenerate(&chip->slot[ii]);
-        OPL3_SlotGenerate(&chip->slot[ii]);
+        OPL3_ProcessSlot(&chip->slot[ii]);
     }
 
     if ((chip->timer & 0x3f) == 0x3f)
@@ -1129,10 +1128,16 @@ void OPL3_Generate(opl3_chip *chip, Bit16s *buf)
     chip->eg_add = 0;
     if (chip->eg_timer)
     {
+        // eg_timer is 36 bits wide, so the lowest set bit is always
+        // found before the limit.
+#if defined(__GNUC__)
+        shift = (Bit8u)__builtin_ctzll(chip->eg_timer);
+#else
         while (shift < 36 && ((chip->eg_timer >> shift) & 1) == 0)
         {
             shift++;
         }
+#endif
         if (shift > 12)
         {
             chip->eg_add = 0;
@@ -1363,13 +1368,97 @@ void OPL3_WriteRegBuffered(opl3_chip *chip, Bit16u reg, Bit8u v)
     chip->writebuf_last = (chip->writebuf_last + 1) % OPL_WRITEBUF_SIZE;
 }
 
-void OPL3_GenerateStream(opl3_chip *chip, Bit16s *sndptr, Bit32u numsamples)
+void OPL3_GenerateBlock(opl3_chip *chip, Bit16s *sndptr, Bit32u numsamples)
 {
     Bit32u i;
 
-    for(i = 0; i < numsamples; i++)
+    for (i = 0; i < numsamples; i++)
     {
-        OPL3_GenerateResampled(chip, sndptr);
+        OPL3_Generate(chip, sndptr);
         sndptr += 2;
     }
 }
+
+//
+// Resampled output is produced in blocks: first count how many native
+// samples the block needs, render them with OPL3_GenerateBlock, then
+// interpolate. OPL3_Generate is called in the same order as by
+// OPL3_GenerateResampled, so the output is identical.
+//
+
+#define RSM_BLOCK   256
+
+void OPL3_GenerateStream(opl3_chip *chip, Bit16s *sndptr, Bit32u numsamples)
+{
+    Bit16s native[(RSM_BLOCK + 1) * 2];
+    Bit32s samplecnt;
+    Bit32u count, needed;
+    Bit32u i, n;
+
+    while (numsamples > 0)
+    {
+        // Work out how many output samples fit in one block of native
+        // samples.
+
+        samplecnt = chip->samplecnt;
+        needed = 0;
+
+        for (count = 0; count < numsamples; count++)
+        {
+            n = 0;
+            while (samplecnt >= chip->rateratio)
+            {
+                samplecnt -= chip->rateratio;
+                n++;
+            }
+            if (needed + n > RSM_BLOCK)
+            {
+                break;
+            }
+            needed += n;
+            samplecnt += 1 << RSM_FRAC;
+        }
+
+        // A single output sample needing more than a whole block only
+        // happens with absurdly low output rates.
+
+        if (count == 0)
+        {
+            OPL3_GenerateResampled(chip, sndptr);
+            sndptr += 2;
+            numsamples--;
+            continue;
+        }
+
+        // native[0..1] holds the last sample generated before the block.
+
+        native[0] = chip->samples[0];
+        native[1] = chip->samples[1];
+        OPL3_GenerateBlock(chip, native + 2, needed);
+
+        n = 0;
+        for (i = 0; i < count; i++)
+        {
+            while (chip->samplecnt >= chip->rateratio)
+            {
+                n++;
+                chip->samplecnt -= chip->rateratio;
+            }
+            if (n > 0)
+            {
+                chip->oldsamples[0] = native[(n - 1) * 2];
+                chip->oldsamples[1] = native[(n - 1) * 2 + 1];
+                chip->samples[0] = native[n * 2];
+                chip->samples[1] = native[n * 2 + 1];
+            }
+            sndptr[0] = (Bit16s)((chip->oldsamples[0] * (chip->rateratio - chip->samplecnt)
+                                + chip->samples[0] * chip->samplecnt) / chip->rateratio);
+            sndptr[1] = (Bit16s)((chip->oldsamples[1] * (chip->rateratio - chip->samplecnt)
+                                + chip->samples[1] * chip->samplecnt) / chip->rateratio);
+            chip->samplecnt += 1 << RSM_FRAC;
+            sndptr += 2;
+        }
+
+        numsamples -= count;
+    }
+}
@@ -54,6 +54,11 @@ typedef struct
 
 extern unsigned int opl_sample_rate;
 
+// If non-zero, the software emulator renders on demand; see
+// OPL_SetRenderMode().
+
+extern int opl_render_mode;
+
 
 #if (defined(__i386__) || defined(__x86_64__)) && defined(HAVE_IOPERM)
 extern opl_driver_t opl_linux_driver;
@@ -66,6 +71,8 @@ extern opl_driver_t opl_win32_driver;
 #endif
 extern opl_driver_t opl_sdl_driver;
 
+void OPL_SDL_Render(int16_t *buffer, unsigned int nsamples);
+
 
 #endif /* #ifndef OPL_INTERNAL_H */
 
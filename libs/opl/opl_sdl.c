@@ -47,8 +47,51 @@ typedef struct
     uint64_t expire_time;     // Calculated time that timer will expire.
 } opl_timer_t;
 
+// Commands sent from other threads to the thread that generates
+// the sound. That thread owns the emulator and the callback queue, and
+// applies queued commands before generating each block of samples.
+
+typedef enum
+{
+    OPL_CMD_WRITE_REGISTER,
+    OPL_CMD_SET_CALLBACK,
+    OPL_CMD_CLEAR_CALLBACKS,
+    OPL_CMD_ADJUST_CALLBACKS,
+    OPL_CMD_SET_PAUSED,
+} opl_command_type_t;
+
+typedef struct
+{
+    opl_command_type_t type;
+    unsigned int reg_num;
+    unsigned int value;         // Register value, or paused flag.
+    uint64_t us;                // Delay from when the command is applied.
+    opl_callback_t callback;
+    void *data;
+    float factor;
+} opl_command_t;
+
+// Single producer, single consumer ring of commands. Must be a power
+// of two, large enough for the register writes of OPL_InitRegisters.
+
+#define COMMAND_RING_SIZE 4096
+
+static opl_command_t command_ring[COMMAND_RING_SIZE];
+
+// Index of the next command to be written by the producer, and of the
+// next command to be read by the consumer.
+
+static SDL_atomic_t command_head;
+static SDL_atomic_t command_tail;
+
+// Thread that last generated sound. Calls made on this thread (i.e.
+// from callbacks) are applied directly instead of being queued.
+
+static void *callback_thread = NULL;
+
 // When the callback mutex is locked using OPL_Lock, callback functions
-// are not invoked.
+// are not invoked. The audio thread only ever tries to take it; if the
+// lock is held, callbacks are deferred to the next block instead.
 
 static SDL_mutex *callback_mutex = NULL;
 
@@ -56,10 +99,6 @@ static SDL_mutex *callback_mutex = NULL;
 
 static opl_callback_queue_t *callback_queue;
 
-// Mutex used to control access to the callback queue.
-
-static SDL_mutex *callback_queue_mutex = NULL;
-
 // Current time, in us since startup:
 
 static uint64_t current_time;
@@ -81,9 +120,11 @@ static opl3_chip opl_chip;
 
 static uint8_t *mix_buffer = NULL;
 
-// Register number that was written.
+// Register number that was written, by the audio thread and by other
+// threads.
 
 static int register_num = 0;
+static int queued_register_num = 0;
 
 // Timers; DBOPL does not do timer stuff itself.
 
@@ -104,16 +145,89 @@ static int SDLIsInitialized(void)
     return Mix_QuerySpec(&freq, &format, &channels);
 }
 
+static void WriteRegister(unsigned int reg_num, unsigned int value);
+
+// Returns true if called from the thread that generates the sound.
+
+static int IsCallbackThread(void)
+{
+    return opl_render_mode
+        || SDL_AtomicGetPtr(&callback_thread)
+            == (void *) (uintptr_t) SDL_ThreadID();
+}
+
+// Queue a command for the audio thread. This only waits if the ring is
+// full, which means the audio thread has stalled; the audio thread
+// itself never waits for the producer.
+
+static void SendCommand(const opl_command_t *command)
+{
+    unsigned int head = (unsigned int) SDL_AtomicGet(&command_head);
+
+    while (head - (unsigned int) SDL_AtomicGet(&command_tail)
+           >= COMMAND_RING_SIZE)
+    {
+        SDL_Delay(1);
+    }
+
+    command_ring[head % COMMAND_RING_SIZE] = *command;
+    SDL_AtomicSet(&command_head, (int) (head + 1));
+}
+
+static void ApplyCommand(const opl_command_t *command)
+{
+    switch (command->type)
+    {
+        case OPL_CMD_WRITE_REGISTER:
+            WriteRegister(command->reg_num, command->value);
+            break;
+
+        case OPL_CMD_SET_CALLBACK:
+            OPL_Queue_Push(callback_queue, command->callback, command->data,
+                           current_time - pause_offset + command->us);
+            break;
+
+        case OPL_CMD_CLEAR_CALLBACKS:
+            OPL_Queue_Clear(callback_queue);
+            break;
+
+        case OPL_CMD_ADJUST_CALLBACKS:
+            OPL_Queue_AdjustCallbacks(callback_queue, current_time,
+                                      command->factor);
+            break;
+
+        case OPL_CMD_SET_PAUSED:
+            opl_sdl_paused = command->value;
+            break;
+    }
+}
+
+// Apply all commands queued by other threads.
+
+static void ProcessCommands(void)
+{
+    unsigned int tail = (unsigned int) SDL_AtomicGet(&command_tail);
+    unsigned int head = (unsigned int) SDL_AtomicGet(&command_head);
+
+    while (tail != head)
+    {
+        ApplyCommand(&command_ring[tail % COMMAND_RING_SIZE]);
+        ++tail;
+    }
+
+    SDL_AtomicSet(&command_tail, (int) tail);
+}
+
 // Advance time by the specified number of samples, invoking any
-// callback functions as appropriate.
+// callback functions as appropriate. Returns zero if callbacks are due
+// but could not be invoked because the control thread holds OPL_Lock.
 
-static void AdvanceTime(unsigned int nsamples)
+static int AdvanceTime(unsigned int nsamples)
 {
     opl_callback_t callback;
     void *callback_data;
     uint64_t us;
-
-    SDL_LockMutex(callback_queue_mutex);
+    int locked = 0;
 
     // Advance time.
 
@@ -131,6 +245,26 @@ static void AdvanceTime(unsigned int nsamples)
     while (!OPL_Queue_IsEmpty(callback_queue)
         && current_time >= OPL_Queue_Peek(callback_queue) + pause_offset)
     {
+        // Callbacks must not run while the control thread holds
+        // OPL_Lock(), but we must not wait for it either.
+
+        if (!locked)
+        {
+            if (SDL_TryLockMutex(callback_mutex) != 0)
+            {
+                return 0;
+            }
+
+            locked = 1;
+
+            // Apply anything queued while the lock was held (such as
+            // OPL_ClearCallbacks() when a song is stopped) before
+            // invoking any callbacks.
+
+            ProcessCommands();
+            continue;
+        }
+
         // Pop the callback from the queue to invoke it.
 
         if (!OPL_Queue_Pop(callback_queue, &callback, &callback_data))
@@ -138,23 +272,15 @@ static void AdvanceTime(unsigned int nsamples)
             break;
         }
 
-        // The mutex stuff here is a bit complicated.  We must
-        // hold callback_mutex when we invoke the callback (so that
-        // the control thread can use OPL_Lock() to prevent callbacks
-        // from being invoked), but we must not be holding
-        // callback_queue_mutex, as the callback must be able to
-        // call OPL_SetCallback to schedule new callbacks.
-
-        SDL_UnlockMutex(callback_queue_mutex);
-
-        SDL_LockMutex(callback_mutex);
         callback(callback_data);
-        SDL_UnlockMutex(callback_mutex);
+    }
 
-        SDL_LockMutex(callback_queue_mutex);
+    if (locked)
+    {
+        SDL_UnlockMutex(callback_mutex);
     }
 
-    SDL_UnlockMutex(callback_queue_mutex);
+    return 1;
 }
 
 // Call the OPL emulator code to fill the specified buffer.
@@ -173,30 +299,34 @@ static void FillBuffer(uint8_t *buffer, unsigned int nsamples)
                        SDL_MIX_MAXVOLUME);
 }
 
-// Callback function to fill a new sound buffer:
+// Generate buffer_samples samples, invoking callbacks at the right
+// points in time. The output is mixed into the buffer, or written
+// directly when rendering.
 
-static void OPL_Mix_Callback(int chan, void *stream, int len, void *udata)
+static void GenerateSamples(Uint8 *buffer, unsigned int buffer_samples)
 {
-    unsigned int filled, buffer_samples;
-    Uint8 *buffer = (Uint8*)stream;
+    unsigned int filled;
+    int deferred = 0;
+
+    SDL_AtomicSetPtr(&callback_thread, (void *) (uintptr_t) SDL_ThreadID());
 
     // Repeatedly call the OPL emulator update function until the buffer is
     // full.
     filled = 0;
-    buffer_samples = len / 4;
 
     while (filled < buffer_samples)
     {
         uint64_t next_callback_time;
         uint64_t nsamples;
 
-        SDL_LockMutex(callback_queue_mutex);
+        ProcessCommands();
 
         // Work out the time until the next callback waiting in
         // the callback queue must be invoked.  We can then fill the
-        // buffer with this many samples.
+        // buffer with this many samples.  If callbacks have been
+        // deferred, fill the rest of the buffer.
 
-        if (opl_sdl_paused || OPL_Queue_IsEmpty(callback_queue))
+        if (opl_sdl_paused || deferred || OPL_Queue_IsEmpty(callback_queue))
         {
             nsamples = buffer_samples - filled;
         }
@@ -213,22 +343,49 @@ static void OPL_Mix_Callback(int chan, void *stream, int len, void *udata)
             }
         }
 
-        SDL_UnlockMutex(callback_queue_mutex);
-
         // Add emulator output to buffer.
 
-        FillBuffer(buffer + filled * 4, nsamples);
+        if (opl_render_mode)
+        {
+            OPL3_GenerateStream(&opl_chip, (Bit16s *) (buffer + filled * 4),
+                                nsamples);
+        }
+        else
+        {
+            FillBuffer(buffer + filled * 4, nsamples);
+        }
         filled += nsamples;
 
         // Invoke callbacks for this point in time.
 
-        AdvanceTime(nsamples);
+        deferred = !AdvanceTime(nsamples);
     }
 }
 
+// Callback function to fill a new sound buffer:
+
+static void OPL_Mix_Callback(int chan, void *stream, int len, void *udata)
+{
+    GenerateSamples((Uint8 *) stream, len / 4);
+}
+
+void OPL_SDL_Render(int16_t *buffer, unsigned int nsamples)
+{
+    GenerateSamples((Uint8 *) buffer, nsamples);
+}
+
 static void OPL_SDL_Shutdown(void)
 {
-    Mix_HookMusic(NULL, NULL);
+    if (opl_render_mode)
+    {
+        OPL_Queue_Destroy(callback_queue);
+        free(mix_buffer);
+        mix_buffer = NULL;
+    }
+    else
+    {
+        Mix_HookMusic(NULL, NULL);
+    }
 
     if (sdl_was_initialized)
     {
@@ -253,11 +410,7 @@ static void OPL_SDL_Shutdown(void)
         callback_mutex = NULL;
     }
 
-    if (callback_queue_mutex != NULL)
-    {
-        SDL_DestroyMutex(callback_queue_mutex);
-        callback_queue_mutex = NULL;
-    }
+    SDL_AtomicSetPtr(&callback_thread, NULL);
 }
 
 static unsigned int GetSliceSize(void)
@@ -289,7 +442,13 @@ static int OPL_SDL_Init(unsigned int port_base)
     // Check if SDL_mixer has been opened already
     // If not, we must initialize it now
 
-    if (!SDLIsInitialized())
+    if (opl_render_mode)
+    {
+        // No audio device; output is pulled with OPL_SDL_Render().
+
+        sdl_was_initialized = 0;
+    }
+    else if (!SDLIsInitialized())
     {
         if (SDL_Init(SDL_INIT_AUDIO) < 0)
         {
@@ -325,9 +484,21 @@ static int OPL_SDL_Init(unsigned int port_base)
     callback_queue = OPL_Queue_Create();
     current_time = 0;
 
+    SDL_AtomicSet(&command_head, 0);
+    SDL_AtomicSet(&command_tail, 0);
+
     // Get the mixer frequency, format and number of channels.
 
-    Mix_QuerySpec(&mixing_freq, &mixing_format, &mixing_channels);
+    if (opl_render_mode)
+    {
+        mixing_freq = opl_sample_rate;
+        mixing_format = AUDIO_S16SYS;
+        mixing_channels = 2;
+    }
+    else
+    {
+        Mix_QuerySpec(&mixing_freq, &mixing_format, &mixing_channels);
+    }
 
     // Only supports AUDIO_S16SYS
 
@@ -349,12 +520,14 @@ static int OPL_SDL_Init(unsigned int port_base)
     OPL3_Reset(&opl_chip, mixing_freq);
 
     callback_mutex = SDL_CreateMutex();
-    callback_queue_mutex = SDL_CreateMutex();
 
     // Set postmix that adds the OPL music. This is deliberately done
     // as a postmix and not using Mix_HookMusic() as the latter disables
     // normal SDL_mixer music mixing.
-    Mix_RegisterEffect(MIX_CHANNEL_POST, OPL_Mix_Callback, NULL, NULL);
+    if (!opl_render_mode)
+    {
+        Mix_RegisterEffect(MIX_CHANNEL_POST, OPL_Mix_Callback, NULL, NULL);
+    }
 
     return 1;
 }
@@ -443,34 +616,71 @@ static void WriteRegister(unsigned int reg_num, unsigned int value)
 
 static void OPL_SDL_PortWrite(opl_port_t port, unsigned int value)
 {
+    int on_audio_thread = IsCallbackThread();
+    int *reg = on_audio_thread ? &register_num : &queued_register_num;
+    opl_command_t command;
+
     if (port == OPL_REGISTER_PORT)
     {
-        register_num = value;
+        *reg = value;
     }
     else if (port == OPL_REGISTER_PORT_OPL3)
     {
-        register_num = value | 0x100;
+        *reg = value | 0x100;
     }
     else if (port == OPL_DATA_PORT)
     {
-        WriteRegister(register_num, value);
+        // The timers are only emulated for OPL_Detect(), which reads
+        // them back immediately, so they are written directly.
+
+        if (on_audio_thread || *reg == OPL_REG_TIMER1
+         || *reg == OPL_REG_TIMER2 || *reg == OPL_REG_TIMER_CTRL)
+        {
+            WriteRegister(*reg, value);
+        }
+        else
+        {
+            command.type = OPL_CMD_WRITE_REGISTER;
+            command.reg_num = *reg;
+            command.value = value;
+            SendCommand(&command);
+        }
+    }
+}
+
+// Apply a command directly when called from a callback, or queue it
+// for the audio thread otherwise.
+
+static void RunCommand(const opl_command_t *command)
+{
+    if (IsCallbackThread())
+    {
+        ApplyCommand(command);
+    }
+    else
+    {
+        SendCommand(command);
     }
 }
 
 static void OPL_SDL_SetCallback(uint64_t us, opl_callback_t callback,
                                 void *data)
 {
-    SDL_LockMutex(callback_queue_mutex);
-    OPL_Queue_Push(callback_queue, callback, data,
-                   current_time - pause_offset + us);
-    SDL_UnlockMutex(callback_queue_mutex);
+    opl_command_t command;
+
+    command.type = OPL_CMD_SET_CALLBACK;
+    command.us = us;
+    command.callback = callback;
+    command.data = data;
+    RunCommand(&command);
 }
 
 static void OPL_SDL_ClearCallbacks(void)
 {
-    SDL_LockMutex(callback_queue_mutex);
-    OPL_Queue_Clear(callback_queue);
-    SDL_UnlockMutex(callback_queue_mutex);
+    opl_command_t command;
+
+    command.type = OPL_CMD_CLEAR_CALLBACKS;
+    RunCommand(&command);
 }
 
 static void OPL_SDL_Lock(void)
@@ -485,14 +695,20 @@ static void OPL_SDL_Unlock(void)
 
 static void OPL_SDL_SetPaused(int paused)
 {
-    opl_sdl_paused = paused;
+    opl_command_t command;
+
+    command.type = OPL_CMD_SET_PAUSED;
+    command.value = paused;
+    RunCommand(&command);
 }
 
 static void OPL_SDL_AdjustCallbacks(float factor)
 {
-    SDL_LockMutex(callback_queue_mutex);
-    OPL_Queue_AdjustCallbacks(callback_queue, current_time, factor);
-    SDL_UnlockMutex(callback_queue_mutex);
+    opl_command_t command;
+
+    command.type = OPL_CMD_ADJUST_CALLBACKS;
+    command.factor = factor;
+    RunCommand(&command);
 }
 
 opl_driver_t opl_sdl_driver =
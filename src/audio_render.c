@@ -0,0 +1,583 @@
+//
+// Copyright(C) 1993-1996 Id Software, Inc.
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	Offline music and sound effect renderer.
+//
+//	Renders music lumps through the OPL emulator (or FluidSynth) and
+//	sound effect lumps through the game's sound effect conversion to
+//	WAV files, using the same code paths as the game but without
+//	opening an audio device, so that rendering runs as fast as the CPU
+//	allows.
+//
+//	The executable is PACKAGE_TARNAME with a -render suffix, broom-render.
+//
+
+#include "config.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "SDL.h"
+
+#ifdef HAVE_FLUIDSYNTH
+#include <fluidsynth.h>
+#endif
+
+#include "doomtype.h"
+#include "i_sound.h"
+#include "i_swap.h"
+#include "i_system.h"
+#include "m_argv.h"
+#include "m_config.h"
+#include "m_misc.h"
+#include "memio.h"
+#include "mus2mid.h"
+#include "opl.h"
+#include "w_main.h"
+#include "w_wad.h"
+#include "z_zone.h"
+
+// Number of sample frames rendered per iteration.
+#define RENDER_BLOCK 4096
+
+// Seconds rendered after the end of a song, so that the release of
+// the last notes is not cut off.
+#define MUSIC_TAIL 2
+
+// Songs that never end (e.g. with a loop that never reaches the end
+// of track) are cut off after this many seconds by default.
+#define MUSIC_MAX_LENGTH 600
+
+typedef struct
+{
+    FILE *stream;
+    int channels;
+    uint32_t frames;
+} wav_file_t;
+
+static int render_rate = 44100;
+static int max_length = MUSIC_MAX_LENGTH;
+static const char *output_dir = ".";
+static const char *soundfont = NULL;
+
+static bool opl_initialized = false;
+
+#ifdef HAVE_FLUIDSYNTH
+static fluid_settings_t *fl_settings = NULL;
+static fluid_synth_t *fl_synth = NULL;
+#endif
+
+//
+// WAV output
+//
+
+static void WriteInt(FILE *stream, uint32_t value, int size)
+{
+    for (int i = 0; i < size; i++)
+    {
+        fputc((value >> (i * 8)) & 0xff, stream);
+    }
+}
+
+static void WriteHeader(wav_file_t *wav)
+{
+    uint32_t data_size = wav->frames * wav->channels * 2;
+
+    fwrite("RIFF", 1, 4, wav->stream);
+    WriteInt(wav->stream, 36 + data_size, 4);
+    fwrite("WAVEfmt ", 1, 8, wav->stream);
+    WriteInt(wav->stream, 16, 4);                            // chunk size
+    WriteInt(wav->stream, 1, 2);                             // PCM
+    WriteInt(wav->stream, wav->channels, 2);
+    WriteInt(wav->stream, render_rate, 4);
+    WriteInt(wav->stream, render_rate * wav->channels * 2, 4); // byte rate
+    WriteInt(wav->stream, wav->channels * 2, 2);             // block align
+    WriteInt(wav->stream, 16, 2);                            // bits
+    fwrite("data", 1, 4, wav->stream);
+    WriteInt(wav->stream, data_size, 4);
+}
+
+static bool OpenWav(wav_file_t *wav, const char *name, int channels)
+{
+    char *filename = M_StringJoin(output_dir, DIR_SEPARATOR_S, name, ".wav",
+                                  NULL);
+
+    wav->stream = M_fopen(filename, "wb");
+    wav->channels = channels;
+    wav->frames = 0;
+
+    if (wav->stream == NULL)
+    {
+        fprintf(stderr, "Failed to open %s for writing\n", filename);
+        free(filename);
+        return false;
+    }
+
+    printf("%s\n", filename);
+    free(filename);
+
+    // The sizes are filled in when the file is closed.
+    WriteHeader(wav);
+    return true;
+}
+
+static void WriteWav(wav_file_t *wav, int16_t *samples, uint32_t frames)
+{
+    uint32_t count = frames * wav->channels;
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        samples[i] = SHORT(samples[i]);
+    }
+
+    fwrite(samples, sizeof(int16_t), count, wav->stream);
+    wav->frames += frames;
+}
+
+static void CloseWav(wav_file_t *wav)
+{
+    fseek(wav->stream, 0, SEEK_SET);
+    WriteHeader(wav);
+    fclose(wav->stream);
+    wav->stream = NULL;
+}
+
+// Lump names are not NUL terminated when they are eight characters long.
+static void LumpName(char *name, int lumpnum)
+{
+    memcpy(name, lumpinfo[lumpnum]->name, 8);
+    name[8] = '\0';
+}
+
+//
+// Music
+//
+
+// Returns the lump as a MIDI file, converting it from MUS if needed.
+// The result must be freed with free().
+static byte *LoadMidi(int lumpnum, size_t *len)
+{
+    byte *data = W_CacheLumpNum(lumpnum, PU_STATIC);
+    int lumplen = W_LumpLength(lumpnum);
+    byte *result = NULL;
+
+    if (lumplen > 4 && !memcmp(data, "MThd", 4))
+    {
+        result = malloc(lumplen);
+        memcpy(result, data, lumplen);
+        *len = lumplen;
+    }
+    else
+    {
+        MEMFILE *instream = mem_fopen_read(data, lumplen);
+        MEMFILE *outstream = mem_fopen_write();
+
+        if (!mus2mid(instream, outstream))
+        {
+            void *outbuf;
+
+            mem_get_buf(outstream, &outbuf, len);
+            result = malloc(*len);
+            memcpy(result, outbuf, *len);
+        }
+
+        mem_fclose(instream);
+        mem_fclose(outstream);
+    }
+
+    W_ReleaseLumpNum(lumpnum);
+    return result;
+}
+
+static bool RenderOPL(const char *name, byte *midi, size_t len)
+{
+    static int16_t buffer[RENDER_BLOCK * 2];
+
+    if (!opl_initialized)
+    {
+        snd_samplerate = render_rate;
+        OPL_SetRenderMode(1);
+
+        if (!music_opl_module.Init())
+        {
+            I_Error("Failed to initialize the OPL emulator");
+        }
+
+        music_opl_module.SetMusicVolume(127);
+        opl_initialized = true;
+    }
+
+    void *handle = music_opl_module.RegisterSong(midi, len);
+    if (handle == NULL)
+    {
+        return false;
+    }
+
+    wav_file_t wav;
+    if (!OpenWav(&wav, name, 2))
+    {
+        music_opl_module.UnRegisterSong(handle);
+        return false;
+    }
+
+    music_opl_module.PlaySong(handle, false);
+
+    uint32_t max_frames = (uint32_t) max_length * render_rate;
+
+    while (music_opl_module.MusicIsPlaying() && wav.frames < max_frames)
+    {
+        OPL_Render(buffer, RENDER_BLOCK);
+        WriteWav(&wav, buffer, RENDER_BLOCK);
+    }
+
+    music_opl_module.StopSong();
+
+    for (int remaining = MUSIC_TAIL * render_rate; remaining > 0;
+         remaining -= RENDER_BLOCK)
+    {
+        OPL_Render(buffer, RENDER_BLOCK);
+        WriteWav(&wav, buffer, RENDER_BLOCK);
+    }
+
+    music_opl_module.UnRegisterSong(handle);
+    CloseWav(&wav);
+    return true;
+}
+
+#ifdef HAVE_FLUIDSYNTH
+
+static bool RenderFluidSynth(const char *name, byte *midi, size_t len)
+{
+    static int16_t buffer[RENDER_BLOCK * 2];
+
+    if (fl_synth == NULL)
+    {
+        fl_settings = new_fluid_settings();
+        fluid_settings_setnum(fl_settings, "synth.sample-rate", render_rate);
+        fl_synth = new_fluid_synth(fl_settings);
+
+        if (fluid_synth_sfload(fl_synth, soundfont, true) == FLUID_FAILED)
+        {
+            I_Error("Failed to load soundfont %s", soundfont);
+        }
+    }
+
+    fluid_player_t *player = new_fluid_player(fl_synth);
+
+    if (fluid_player_add_mem(player, midi, len) != FLUID_OK)
+    {
+        delete_fluid_player(player);
+        return false;
+    }
+
+    wav_file_t wav;
+    if (!OpenWav(&wav, name, 2))
+    {
+        delete_fluid_player(player);
+        return false;
+    }
+
+    fluid_player_play(player);
+
+    uint32_t max_frames = (uint32_t) max_length * render_rate;
+
+    while (fluid_player_get_status(player) == FLUID_PLAYER_PLAYING
+           && wav.frames < max_frames)
+    {
+        fluid_synth_write_s16(fl_synth, RENDER_BLOCK, buffer, 0, 2,
+                              buffer, 1, 2);
+        WriteWav(&wav, buffer, RENDER_BLOCK);
+    }
+
+    fluid_player_stop(player);
+    delete_fluid_player(player);
+    fluid_synth_all_notes_off(fl_synth, -1);
+
+    for (int remaining = MUSIC_TAIL * render_rate; remaining > 0;
+         remaining -= RENDER_BLOCK)
+    {
+        fluid_synth_write_s16(fl_synth, RENDER_BLOCK, buffer, 0, 2,
+                              buffer, 1, 2);
+        WriteWav(&wav, buffer, RENDER_BLOCK);
+    }
+
+    fluid_synth_system_reset(fl_synth);
+    CloseWav(&wav);
+    return true;
+}
+
+#endif
+
+static void RenderMusic(int lumpnum)
+{
+    char name[9];
+
+    LumpName(name, lumpnum);
+
+    size_t len;
+    byte *midi = LoadMidi(lumpnum, &len);
+    bool result = false;
+
+    if (midi != NULL)
+    {
+#ifdef HAVE_FLUIDSYNTH
+        if (soundfont != NULL)
+        {
+            result = RenderFluidSynth(name, midi, len);
+        }
+        else
+#endif
+        {
+            result = RenderOPL(name, midi, len);
+        }
+
+        free(midi);
+    }
+
+    if (!result)
+    {
+        fprintf(stderr, "%s: not a valid music lump\n", name);
+    }
+}
+
+//
+// Sound effects
+//
+
+static void RenderSfx(int lumpnum)
+{
+    sfxinfo_t sfxinfo = {0};
+    int16_t *samples;
+    uint32_t num_frames;
+
+    LumpName(sfxinfo.name, lumpnum);
+    sfxinfo.lumpnum = lumpnum;
+
+    // Convert it exactly as the game does for its mixer, so the header
+    // checks, the trimmed padding and the converter selected by
+    // use_libsamplerate all match.
+
+    if (!I_SDL_ConvertSfx(&sfxinfo, render_rate, &samples, &num_frames))
+    {
+        fprintf(stderr, "%s: not a valid sound lump\n", sfxinfo.name);
+        return;
+    }
+
+    // Both channels are the same; keep the left one.
+
+    for (uint32_t i = 0; i < num_frames; ++i)
+    {
+        samples[i] = samples[i * 2];
+    }
+
+    wav_file_t wav;
+    if (OpenWav(&wav, sfxinfo.name, 1))
+    {
+        WriteWav(&wav, samples, num_frames);
+        CloseWav(&wav);
+    }
+
+    free(samples);
+}
+
+//
+// Lump selection
+//
+
+// Renders the lumps named on the command line after the given
+// parameter, up to the next parameter.
+static void RenderNamed(const char *parm, void (*render)(int lumpnum))
+{
+    int p = M_CheckParmWithArgs(parm, 1);
+
+    if (p == 0)
+    {
+        return;
+    }
+
+    for (p = p + 1; p < myargc && myargv[p][0] != '-'; ++p)
+    {
+        int lumpnum = W_CheckNumForName(myargv[p]);
+
+        if (lumpnum < 0)
+        {
+            fprintf(stderr, "%s: lump not found\n", myargv[p]);
+            continue;
+        }
+
+        render(lumpnum);
+    }
+}
+
+// Renders every lump whose name starts with the given prefix. Lumps
+// replaced by a later WAD are skipped.
+static void RenderAll(const char *prefix, void (*render)(int lumpnum))
+{
+    size_t prefix_len = strlen(prefix);
+
+    for (unsigned int i = 0; i < numlumps; ++i)
+    {
+        const char *name = lumpinfo[i]->name;
+
+        if (strncasecmp(name, prefix, prefix_len) != 0
+            || W_CheckNumForName(name) != (int) i)
+        {
+            continue;
+        }
+
+        render(i);
+    }
+}
+
+static void PrintUsage(const char *program)
+{
+    printf(PACKAGE_TARNAME "-render: render music and sound effects to WAV\n"
+           "\n"
+           "Usage: %s -iwad <wad> [-file <wads>...] [options]\n"
+           "\n"
+           "  -music <lumps>...    Render the named music lumps\n"
+           "  -allmusic            Render every music (D_*) lump\n"
+           "  -sfx <lumps>...      Render the named sound effect lumps\n"
+           "  -allsfx              Render every sound effect (DS*) lump\n"
+           "  -output <dir>        Write WAV files to this directory\n"
+           "  -samplerate <rate>   Output sample rate (default 44100)\n"
+           "  -maxlength <secs>    Cut off songs after this many seconds\n"
+           "  -opl3                Use OPL3 instead of OPL2 for music\n"
+#ifdef HAVE_FLUIDSYNTH
+           "  -soundfont <file>    Render music with FluidSynth\n"
+#endif
+           , program);
+}
+
+int main(int argc, char **argv)
+{
+    // save arguments
+
+    myargc = argc;
+    myargv = malloc(argc * sizeof(char *));
+    assert(myargv != NULL);
+
+    for (int i = 0; i < argc; i++)
+    {
+        myargv[i] = M_StringDuplicate(argv[i]);
+    }
+
+    M_FindResponseFile();
+    M_SetExeDir();
+
+    int p = M_CheckParmWithArgs("-iwad", 1);
+
+    if (p == 0)
+    {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    Z_Init();
+
+    if (W_AddFile(myargv[p + 1]) == NULL)
+    {
+        I_Error("Failed to load %s", myargv[p + 1]);
+    }
+
+    W_ParseCommandLine();
+    W_GenerateHashTable();
+
+    // Sound settings such as use_libsamplerate come from the game's
+    // configuration, so that the output matches what the game plays.
+
+    M_SetConfigDir(NULL);
+    M_SetConfigFilenames("default.cfg", PACKAGE_TARNAME ".cfg");
+    I_BindSoundVariables();
+    M_LoadDefaults();
+
+    p = M_CheckParmWithArgs("-output", 1);
+    if (p > 0)
+    {
+        output_dir = myargv[p + 1];
+        M_MakeDirectory(output_dir);
+    }
+
+    p = M_CheckParmWithArgs("-samplerate", 1);
+    if (p > 0)
+    {
+        render_rate = atoi(myargv[p + 1]);
+
+        if (render_rate < 8000 || render_rate > 192000)
+        {
+            I_Error("Invalid sample rate: %s", myargv[p + 1]);
+        }
+    }
+
+    p = M_CheckParmWithArgs("-maxlength", 1);
+    if (p > 0)
+    {
+        char *end;
+        long length = strtol(myargv[p + 1], &end, 10);
+
+        // The length in frames must fit in 32 bits.
+        if (end == myargv[p + 1] || *end != '\0' || length <= 0
+         || length > UINT32_MAX / (uint32_t) render_rate)
+        {
+            I_Error("Invalid maximum length: %s", myargv[p + 1]);
+        }
+
+        max_length = (int) length;
+    }
+
+    if (M_ParmExists("-opl3"))
+    {
+        snd_dmxoption = "-opl3";
+    }
+
+    p = M_CheckParmWithArgs("-soundfont", 1);
+    if (p > 0)
+    {
+#ifdef HAVE_FLUIDSYNTH
+        soundfont = myargv[p + 1];
+#else
+        I_Error("-soundfont requires FluidSynth support");
+#endif
+    }
+
+    RenderNamed("-music", RenderMusic);
+    if (M_ParmExists("-allmusic"))
+    {
+        RenderAll("D_", RenderMusic);
+    }
+
+    RenderNamed("-sfx", RenderSfx);
+    if (M_ParmExists("-allsfx"))
+    {
+        RenderAll("DS", RenderSfx);
+    }
+
+    if (opl_initialized)
+    {
+        music_opl_module.Shutdown();
+    }
+
+#ifdef HAVE_FLUIDSYNTH
+    if (fl_synth != NULL)
+    {
+        delete_fluid_synth(fl_synth);
+        delete_fluid_settings(fl_settings);
+    }
+#endif
+
+    return 0;
+}
@@ -76,11 +76,6 @@
 // scale on entry
 #define INITSCALEMTOF (.2 * FRACUNIT)
 
-// how much the automap moves window per tic in frame-buffer
-// coordinates moves 140 pixels in 1 second
-#define F_PANINC 4
-
-
 // translates between frame-buffer and map coordinates
 #define CXMTOF(x) (f_x + MTOF((x) - m_x))
 #define CYMTOF(y) (f_y + (f_h - MTOF((y) - m_y)))
@@ -138,8 +133,6 @@ int cheating = 0;
 int grid = 0;
 
 bool automapactive = false;
-static int finit_width = SCREENWIDTH;
-static int finit_height = SCREENHEIGHT - ST_HEIGHT;
 
 // location of window on screen
 static int f_x;
@@ -151,6 +144,7 @@ static int f_h;
 
 static int lightlev; // used for funky strobing effect
 static pixel_t *fb;  // pseudo-frame buffer
+static bool vislines_valid = false; // cached wall lines match the window
 
 mpoint_t m_paninc;    // how far the window pans each tic (map coords)
 fixed_t mtof_zoommul; // how far the window zooms in each tic (map coords)
@@ -430,8 +424,8 @@ static int lastepisode = -1;
 static void AM_LevelInit() {
     f_x = 0;
     f_y = 0;
-    f_w = finit_width;
-    f_h = finit_height;
+    f_w = SCREENWIDTH;
+    f_h = SCREENHEIGHT - ST_HEIGHT * render_scale;
 
     AM_clearMarks();
     AM_findMinMaxBoundaries();
@@ -459,6 +453,7 @@ void AM_Start() {
     }
     AM_initVariables();
     AM_loadPics();
+    vislines_valid = false;
 }
 
 //
@@ -661,25 +656,24 @@ static bool AM_clipMline(mline_t* ml, fline_t* fl) {
 }
 
 
-static void AM_WritePixel(int x, int y, int color) {
-    int spot = x + (y * f_w);
-    fb[spot]= (pixel_t) color;
-}
-
+//
+// The line plotters step a pointer through the frame buffer rather than
+// recomputing the offset of every pixel.
+//
 static void AM_PlotLineLow(fpoint_t start, fpoint_t end, int color) {
     int dx = end.x - start.x;
     int dy = end.y - start.y;
-    int yi = 1;
+    int yi = f_w;
     if (dy < 0) {
-        yi = -1;
+        yi = -f_w;
         dy = -dy;
     }
     int d = dy - dx/2;
-    int y = start.y;
+    pixel_t* dest = &fb[start.x + (start.y * f_w)];
     for (int x = start.x; x <= end.x; x++) {
-        AM_WritePixel(x, y, color);
+        *dest++ = (pixel_t) color;
         if (d >= 0) {
-            y += yi;
+            dest += yi;
             d += (2 * (dy - dx));
         } else {
             d += (2 * dy);
@@ -696,11 +690,12 @@ static void AM_PlotLineHigh(fpoint_t start, fpoint_t end, int color) {
         dx = -dx;
     }
     int d = dx - dy/2;
-    int x = start.x;
+    pixel_t* dest = &fb[start.x + (start.y * f_w)];
     for (int y = start.y; y <= end.y; y++) {
-        AM_WritePixel(x, y, color);
+        *dest = (pixel_t) color;
+        dest += f_w;
         if (d >= 0) {
-            x += xi;
+            dest += xi;
             d += (2 * (dx - dy));
         } else {
             d += (2 * dx);
@@ -887,23 +882,129 @@ static int AM_GetLineColor(line_t* line) {
     return -1;
 }
 
+//
+// Lines inside the window, already clipped to frame buffer coordinates.
+// They only change when the window is panned or zoomed, so they are
+// kept between frames and only the colors are worked out each frame.
+//
+typedef struct {
+    line_t* line;
+    fline_t fl;
+} am_visline_t;
+
+typedef struct {
+    fixed_t x;
+    fixed_t y;
+    fixed_t scale;
+    int w;
+    int h;
+    line_t* lines;
+    int numlines;
+    int episode;
+    int map;
+} am_viewkey_t;
+
+static am_visline_t* vislines = NULL;
+static int vislines_max = 0;
+static int num_vislines;
+static am_viewkey_t visline_key;
+
+static am_viewkey_t AM_GetViewKey() {
+    am_viewkey_t key = {
+        .x = m_x,
+        .y = m_y,
+        .scale = scale_mtof,
+        .w = f_w,
+        .h = f_h,
+        .lines = lines,
+        .numlines = numlines,
+        .episode = gameepisode,
+        .map = gamemap,
+    };
+    return key;
+}
+
+static bool AM_ViewKeyEqual(const am_viewkey_t* a, const am_viewkey_t* b) {
+    return a->x == b->x && a->y == b->y && a->scale == b->scale
+        && a->w == b->w && a->h == b->h
+        && a->lines == b->lines && a->numlines == b->numlines
+        && a->episode == b->episode && a->map == b->map;
+}
+
+static bool AM_CollectLine(line_t* line) {
+    mline_t ml = {
+        .a = { line->v1->x, line->v1->y },
+        .b = { line->v2->x, line->v2->y },
+    };
+    fline_t fl;
+
+    if (AM_clipMline(&ml, &fl)) {
+        vislines[num_vislines].line = line;
+        vislines[num_vislines].fl = fl;
+        num_vislines++;
+    }
+    return true;
+}
+
+static int AM_CompareVislines(const void* a, const void* b) {
+    const am_visline_t* va = a;
+    const am_visline_t* vb = b;
+    return (int) (va->line - vb->line);
+}
+
+//
+// Find the lines inside the window from the blockmap cells it covers.
+//
+static void AM_CollectVisibleLines() {
+    if (vislines_max < numlines) {
+        if (vislines != NULL) {
+            Z_Free(vislines);
+        }
+        vislines = Z_Malloc(numlines * sizeof(*vislines), PU_STATIC, NULL);
+        vislines_max = numlines;
+    }
+    num_vislines = 0;
+
+    int x1 = (m_x - bmaporgx) >> MAPBLOCKSHIFT;
+    int x2 = (m_x2 - bmaporgx) >> MAPBLOCKSHIFT;
+    int y1 = (m_y - bmaporgy) >> MAPBLOCKSHIFT;
+    int y2 = (m_y2 - bmaporgy) >> MAPBLOCKSHIFT;
+
+    x1 = x1 < 0 ? 0 : x1;
+    y1 = y1 < 0 ? 0 : y1;
+    x2 = x2 >= bmapwidth ? bmapwidth - 1 : x2;
+    y2 = y2 >= bmapheight ? bmapheight - 1 : y2;
+
+    validcount++;
+    for (int y = y1; y <= y2; y++) {
+        for (int x = x1; x <= x2; x++) {
+            P_BlockLinesIterator(x, y, AM_CollectLine);
+        }
+    }
+
+    // Keep the LineDef order, so overlapping lines are drawn as before.
+    qsort(vislines, num_vislines, sizeof(*vislines), AM_CompareVislines);
+
+    visline_key = AM_GetViewKey();
+    vislines_valid = true;
+}
+
 //
 // Determines visible lines, draws them.
 // This is LineDef based, not LineSeg based.
 //
 static void AM_drawWalls() {
-    static mline_t l;
+    am_viewkey_t key = AM_GetViewKey();
+
+    if (!vislines_valid || !AM_ViewKeyEqual(&key, &visline_key)) {
+        AM_CollectVisibleLines();
+    }
 
-    for (int i = 0; i < numlines; i++) {
-        line_t* line = &lines[i];
-        int line_color = AM_GetLineColor(line);
+    for (int i = 0; i < num_vislines; i++) {
+        int line_color = AM_GetLineColor(vislines[i].line);
 
         if (line_color != -1) {
-            l.a.x = line->v1->x;
-            l.a.y = line->v1->y;
-            l.b.x = line->v2->x;
-            l.b.y = line->v2->y;
-            AM_drawMline(&l, line_color);
+            AM_drawFline(&vislines[i].fl, line_color);
         }
     }
 }
@@ -1030,8 +1131,9 @@ static void AM_drawMarks(void) {
         int h = 6; // because something's wrong with the wad, i guess
         int fx = CXMTOF(markpoints[i].x);
         int fy = CYMTOF(markpoints[i].y);
-        if (fx >= f_x && fx <= f_w - w && fy >= f_y && fy <= f_h - h) {
-            V_DrawPatch(fx, fy, marknums[i]);
+        if (fx >= f_x && fx <= f_w - w * render_scale
+         && fy >= f_y && fy <= f_h - h * render_scale) {
+            V_DrawPatch(fx / render_scale, fy / render_scale, marknums[i]);
         }
     }
 }
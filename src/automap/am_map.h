@@ -43,7 +43,7 @@
 
 // how much the automap moves window per tic in frame-buffer
 // coordinates moves 140 pixels in 1 second
-#define F_PANINC  4
+#define F_PANINC  (4 * render_scale)
 
 typedef struct
 {
@@ -38,6 +38,7 @@
 #include "i_swap.h"
 
 #include "p_setup.h"
+#include "p_keyframe.h"
 #include "p_saveg.h"
 #include "p_tick.h"
 
@@ -65,6 +66,9 @@
 #include "r_data.h"
 #include "r_sky.h"
 
+#include "w_file.h"
+#include "w_wad.h"
+
 
 
 #include "g_game.h"
@@ -155,6 +159,22 @@ static byte *demo_p;
 static byte *demoend;
 bool singledemo; // quit after playing a demo from cmdline
 
+//
+// Demo keyframe index (-indexdemo) and demo seeking (-seekdemo).
+//
+#define KEYFRAME_TICS (20 * TICRATE)
+
+static bool indexdemo;
+static int keyframetics = KEYFRAME_TICS;
+static int numkeyframes;
+static int demoseektic = -1;
+static bool demoseeking;
+// Saved while fast-forwarding to demoseektic.
+static bool seek_singletics;
+static bool seek_nodrawers;
+// Number of demo tics read so far.
+static int demotic;
+
 bool precache = true; // if true, load all graphics at start
 
 bool testcontrols = false; // Invoked by setup to test controls
@@ -242,8 +262,6 @@ static bool *joybuttons = &joyarray[1]; // allow [-1]
 static int savegameslot;
 static char savedescription[32];
 
-#define BODYQUESIZE 32
-
 mobj_t *bodyque[BODYQUESIZE];
 int bodyqueslot;
 
@@ -1040,6 +1058,34 @@ static void G_DoScreenShot() {
     gameaction = ga_nothing;
 }
 
+static void G_FinishDemoSeek() {
+    singletics = seek_singletics;
+    nodrawers = seek_nodrawers;
+    demoseeking = false;
+    demoseektic = -1;
+    printf("Reached demo tic %i.\n", demotic);
+}
+
+//
+// Keyframes are taken right before a demo tic is read, once any pending
+// game action has been processed, so restoring one resumes playback at
+// the same point of G_Ticker.
+//
+static void G_UpdateDemoKeyframes() {
+    if (!demoplayback) {
+        return;
+    }
+    if (indexdemo && demotic > 0 && demotic % keyframetics == 0
+        && gamestate == GS_LEVEL) {
+        P_WriteKeyframe(demotic, demo_p - demobuffer);
+        numkeyframes++;
+    }
+    if (demoseeking && demotic >= demoseektic) {
+        G_FinishDemoSeek();
+    }
+    demotic++;
+}
+
 //
 // Do things to change the game state.
 //
@@ -1097,6 +1143,7 @@ static void G_RebornPlayers() {
 void G_Ticker() {
     G_RebornPlayers();
     G_RunGameActions();
+    G_UpdateDemoKeyframes();
     G_UpdateNetConsistency();
     G_CheckSpecialButtons();
     if (G_HasFinishedWI()) {
@@ -2185,6 +2232,79 @@ static const char *DemoVersionDescription(int version)
     }
 }
 
+//
+// The keyframe index of a demo read from a .lmp file is stored next to
+// it, otherwise in the current directory, named after the demo lump.
+//
+static char* G_DemoIndexFileName(int lumpnum) {
+    const char* path = lumpinfo[lumpnum]->wad_file->path;
+    char* lower = M_StringDuplicate(path);
+    M_ForceLowercase(lower);
+    bool lmp = M_StringEndsWith(lower, ".lmp");
+    free(lower);
+
+    if (lmp) {
+        char* filename = M_StringDuplicate(path);
+        M_StringCopy(filename + strlen(filename) - 4, ".dki", 5);
+        return filename;
+    }
+    return M_StringJoin(defdemoname, ".dki", NULL);
+}
+
+static void G_StartDemoIndex(int lumpnum) {
+    char* filename = G_DemoIndexFileName(lumpnum);
+    if (!P_CreateKeyframeIndex(filename, demobuffer, W_LumpLength(lumpnum))) {
+        I_Error("G_StartDemoIndex: Could not create %s", filename);
+    }
+    printf("Indexing demo into %s, a keyframe every %i tics.\n",
+           filename, keyframetics);
+    free(filename);
+    numkeyframes = 0;
+}
+
+static void G_RestoreDemoKeyframe(const keyframe_t* keyframe) {
+    if (keyframe->episode != gameepisode || keyframe->map != gamemap) {
+        gameepisode = keyframe->episode;
+        gamemap = keyframe->map;
+        precache = false;
+        G_DoLoadLevel();
+        precache = true;
+    }
+    if (!P_ReadKeyframe(keyframe)) {
+        I_Error("G_RestoreDemoKeyframe: Bad keyframe at tic %i",
+                keyframe->tic);
+    }
+    demo_p = demobuffer + keyframe->demo_offset;
+    demotic = keyframe->tic;
+    printf("Restored demo keyframe at tic %i.\n", demotic);
+}
+
+static void G_StartDemoSeek(int lumpnum) {
+    char* filename = G_DemoIndexFileName(lumpnum);
+    keyframe_t keyframe;
+
+    if (P_OpenKeyframeIndex(filename, demobuffer, W_LumpLength(lumpnum))) {
+        if (P_FindKeyframe(demoseektic, &keyframe)) {
+            G_RestoreDemoKeyframe(&keyframe);
+        } else {
+            printf("No usable keyframe before tic %i in %s, "
+                   "simulating from the start.\n", demoseektic, filename);
+        }
+        P_CloseKeyframeIndex();
+    } else {
+        printf("No keyframe index for this demo in %s, "
+               "simulating from the start.\n", filename);
+    }
+    free(filename);
+
+    // Run the remaining tics as fast as possible, without drawing.
+    seek_singletics = singletics;
+    seek_nodrawers = nodrawers;
+    singletics = true;
+    nodrawers = true;
+    demoseeking = true;
+}
+
 void G_DoPlayDemo (void)
 {
     skill_t skill;
@@ -2269,6 +2389,16 @@ void G_DoPlayDemo (void)
 
     usergame = false; 
     demoplayback = true; 
+    demotic = 0;
+
+    if (indexdemo)
+    {
+        G_StartDemoIndex(lumpnum);
+    }
+    else if (demoseektic > 0)
+    {
+        G_StartDemoSeek(lumpnum);
+    }
 } 
 
 //
@@ -2291,6 +2421,45 @@ void G_TimeDemo (char* name)
     defdemoname = name; 
     gameaction = ga_playdemo; 
 } 
+
+//
+// G_IndexDemo
+// Play back a demo as fast as possible without drawing, storing
+// keyframes into its index file for later use by G_SeekDemo.
+//
+void G_IndexDemo(char* name) {
+    //!
+    // @arg <n>
+    // @category demo
+    //
+    // When indexing a demo with -indexdemo, store a keyframe every n
+    // tics (rounded up to a multiple of 4). The default is 700.
+    //
+    int p = M_CheckParmWithArgs("-keyframetics", 1);
+    if (p) {
+        keyframetics = (atoi(myargv[p + 1]) + 3) & ~3;
+        if (keyframetics < 4) {
+            keyframetics = 4;
+        }
+    }
+
+    indexdemo = true;
+    singledemo = true;
+    singletics = true;
+    nodrawers = true;
+
+    defdemoname = name;
+    gameaction = ga_playdemo;
+}
+
+//
+// G_SeekDemo
+// Start the next demo played back at the given tic, restoring the
+// nearest keyframe of its index and simulating forward from it.
+//
+void G_SeekDemo(int tic) {
+    demoseektic = tic;
+}
  
  
 /* 
@@ -2326,6 +2495,13 @@ bool G_CheckDemoStatus (void)
 	 
     if (demoplayback) 
     { 
+        if (indexdemo)
+        {
+            P_CloseKeyframeIndex();
+            printf("Demo indexed: %i keyframes over %i tics.\n",
+                   numkeyframes, demotic);
+        }
+
         W_ReleaseLumpName(defdemoname);
 	demoplayback = false; 
 	netdemo = false;
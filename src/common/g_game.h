@@ -57,6 +57,8 @@ void G_RecordDemo(const char *name);
 void G_BeginRecording(void);
 
 void G_TimeDemo(char* name);
+void G_IndexDemo(char* name);
+void G_SeekDemo(int tic);
 bool G_CheckDemoStatus();
 
 void G_ExitLevel();
@@ -531,6 +531,15 @@ static default_t	doom_defaults_list[] =
 
     CONFIG_VARIABLE_INT(snd_channels),
 
+    //!
+    // If non-zero, a new sound that finds no free channel replaces the
+    // lowest numbered channel playing a sound of equal or lower
+    // priority, as in Vanilla.  If zero, it replaces the lowest
+    // priority sound playing, and the oldest one among equals.
+    //
+
+    CONFIG_VARIABLE_INT(vanilla_sound_channels),
+
     //!
     // Music output device.  A non-zero value gives MIDI sound output,
     // while a value of zero disables music.
@@ -786,6 +795,24 @@ static default_t extra_defaults_list[] =
 
     CONFIG_VARIABLE_INT(max_scaling_buffer_pixels),
 
+    //!
+    // If non-zero, the integer upscale is done on the CPU in the same pass
+    // that expands the palette, writing straight into the upscaled texture.
+    // This saves a render-to-texture pass, which can help with the software
+    // renderer or slow integrated GPUs, at the cost of more CPU time on
+    // large windows.
+    //
+
+    CONFIG_VARIABLE_INT(cpu_upscaling),
+
+    //!
+    // Internal rendering resolution, as a multiple of the original 320x200
+    // (1 to 8). The 3D view is rendered at the full resolution; the status
+    // bar, menus and other 2D graphics are scaled up to match.
+    //
+
+    CONFIG_VARIABLE_INT(render_scale),
+
     //!
     // Number of milliseconds to wait on startup after the video mode
     // has been set, before the game will start.  This allows the
@@ -842,6 +869,16 @@ static default_t extra_defaults_list[] =
 
     CONFIG_VARIABLE_INT(snd_cachesize),
 
+    //!
+    // If non-zero, sound effects are played through a native software
+    // mixer that resamples them on the fly from the original lumps,
+    // instead of through SDL_mixer channels. No converted sound data
+    // is cached, so snd_cachesize does not apply. Combine with a low
+    // snd_maxslicetime_ms for lower latency.
+    //
+
+    CONFIG_VARIABLE_INT(snd_nativemixer),
+
     //!
     // Maximum size of the output sound buffer size in milliseconds.
     // Sound output is generated periodically in slices. Higher values
@@ -911,6 +948,16 @@ static default_t extra_defaults_list[] =
 
     CONFIG_VARIABLE_FLOAT(libsamplerate_scale),
 
+    //!
+    // If non-zero, sound effects converted with libsamplerate are
+    // stored in the sfxcache directory of the configuration directory,
+    // so that they only need to be converted once. Cached sounds are
+    // keyed by the lump contents, the output format and the
+    // libsamplerate settings.
+    //
+
+    CONFIG_VARIABLE_INT(snd_diskcache),
+
     //!
     // Full path to a directory in which WAD files and dehacked patches
     // can be placed to be automatically loaded on startup. A subdirectory
@@ -1093,6 +1140,18 @@ static default_t extra_defaults_list[] =
 
     CONFIG_VARIABLE_INT(vanilla_demo_limit),
 
+    //!
+    // @game doom
+    //
+    // If non-zero, the Vanilla renderer limits are enforced; the game
+    // exits with an error when a scene needs more than 128 visplanes
+    // or overflows the openings array, and walls past the 256th drawseg
+    // are not drawn at all.  If this has a value of zero, these limits
+    // grow as needed.
+    //
+
+    CONFIG_VARIABLE_INT(vanilla_render_limits),
+
     //!
     // If non-zero, the game behaves like Vanilla Doom, always assuming
     // an American keyboard mapping.  If this has a value of zero, the
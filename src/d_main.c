@@ -41,6 +41,7 @@
 #include "w_main.h"
 #include "w_wad.h"
 #include "s_sound.h"
+#include "v_capture.h"
 #include "v_diskicon.h"
 #include "v_video.h"
 
@@ -176,8 +177,9 @@ void D_ProcessEvents(void) {
 gamestate_t wipegamestate = GS_DEMOSCREEN;
 
 static void D_DrawPausePic() {
-    int x = viewwindowx + (scaledviewwidth - 68) / 2;
-    int y = automapactive ? 4 : viewwindowy + 4;
+    int x = (viewwindowx + (scaledviewwidth - 68 * render_scale) / 2)
+            / render_scale;
+    int y = automapactive ? 4 : viewwindowy / render_scale + 4;
 
     const char* lump_name = DEH_String("M_PAUSE");
     patch_t* patch = (patch_t *) W_CacheLumpName(lump_name, PU_CACHE);
@@ -316,8 +318,8 @@ static void EnableLoadingDisk(void)
         }
 
         V_EnableLoadingDisk(disk_lump_name,
-                            SCREENWIDTH - LOADING_DISK_W,
-                            SCREENHEIGHT - LOADING_DISK_H);
+                            ORIGWIDTH - LOADING_DISK_W,
+                            ORIGHEIGHT - LOADING_DISK_H);
     }
 }
 
@@ -372,8 +374,10 @@ void D_BindVariables(void)
     M_BindIntVariable("screenblocks",           &screenblocks);
     M_BindIntVariable("detaillevel",            &detailLevel);
     M_BindIntVariable("snd_channels",           &snd_channels);
+    M_BindIntVariable("vanilla_sound_channels", &vanilla_sound_channels);
     M_BindIntVariable("vanilla_savegame_limit", &vanilla_savegame_limit);
     M_BindIntVariable("vanilla_demo_limit",     &vanilla_demo_limit);
+    M_BindIntVariable("vanilla_render_limits",  &vanilla_render_limits);
     M_BindIntVariable("show_endoom",            &show_endoom);
     M_BindIntVariable("show_diskicon",          &show_diskicon);
 
@@ -423,7 +427,11 @@ static void D_DoWipe() {
     do {
         nowtime = I_GetTime();
         tics = nowtime - wipestart;
-        I_Sleep(1);
+        // Use the wait for the next tic to read in the new level's
+        // graphics, and only sleep once there are none left.
+        if (!R_PrecacheStep()) {
+            I_Sleep(1);
+        }
     } while (tics <= 0);
     wipe = !wipe_ScreenWipe(tics);
     wipestart = nowtime;
@@ -467,6 +475,8 @@ static void D_RunFrame() {
         D_DoWipe();
         return;
     }
+    // Anything the melt did not get to is read before the level runs.
+    R_FinishPrecache();
     // Will run at least one tic.
     TryRunTics();
     // Move positional sounds.
@@ -502,6 +512,7 @@ void D_DoomLoop() {
     I_GraphicsCheckCommandLine();
     I_SetGrabMouseCallback(D_GrabMouseCallback);
     I_InitGraphics();
+    V_InitCapture();
     EnableLoadingDisk();
 
     TryRunTics();
@@ -1171,6 +1182,7 @@ static bool D_CanShowEndoom() {
     return show_endoom
            && main_loop_started
            && !screensaver_mode
+           && !headless_mode
            && M_CheckParm("-testcontrols") == 0;
 }
 
@@ -1484,6 +1496,7 @@ void D_DoomMain() {
     M_SetConfigFilenames("default.cfg", PACKAGE_TARNAME ".cfg");
     D_BindVariables();
     M_LoadDefaults();
+    I_InitRenderScale();
 
     // Save configuration at exit.
     I_AtExit(M_SaveDefaults, false);
@@ -1653,6 +1666,18 @@ void D_DoomMain() {
 
     }
 
+    if (!p)
+    {
+        //!
+        // @arg <demo>
+        // @category demo
+        //
+        // Play back the demo named demo.lmp as fast as possible, storing
+        // keyframes into demo.dki for use with -seekdemo.
+        //
+        p = M_CheckParmWithArgs("-indexdemo", 1);
+    }
+
     if (p)
     {
         char *uc_filename = strdup(myargv[p + 1]);
@@ -1965,6 +1990,21 @@ void D_DoomMain() {
 	autostart = true;
     }
 
+    //!
+    // @arg <tic>
+    // @category demo
+    //
+    // When playing back a demo with -playdemo or -timedemo, skip ahead to
+    // the given tic, starting from the nearest keyframe stored by
+    // -indexdemo if there is one.
+    //
+
+    p = M_CheckParmWithArgs("-seekdemo", 1);
+    if (p)
+    {
+        G_SeekDemo(atoi(myargv[p + 1]));
+    }
+
     p = M_CheckParmWithArgs("-playdemo", 1);
     if (p)
     {
@@ -1980,6 +2020,13 @@ void D_DoomMain() {
 	D_DoomLoop ();  // never returns
     }
 
+    p = M_CheckParmWithArgs("-indexdemo", 1);
+    if (p)
+    {
+        G_IndexDemo(demolumpname);
+        D_DoomLoop();  // never returns
+    }
+
     if (startloadgame >= 0) {
         M_StringCopy(file, P_SaveGameFile(startloadgame), sizeof(file));
 	G_LoadGame(file);
@@ -232,9 +232,8 @@ void F_Ticker() {
 void F_TextWrite (void)
 {
     byte*	src;
-    pixel_t*	dest;
     
-    int		x,y,w;
+    int		w;
     signed int	count;
     const char *ch;
     int		c;
@@ -243,21 +242,7 @@ void F_TextWrite (void)
     
     // erase the entire screen to a tiled background
     src = W_CacheLumpName ( finaleflat , PU_CACHE);
-    dest = I_VideoBuffer;
-	
-    for (y=0 ; y<SCREENHEIGHT ; y++)
-    {
-	for (x=0 ; x<SCREENWIDTH/64 ; x++)
-	{
-	    memcpy (dest, src+((y&63)<<6), 64);
-	    dest += 64;
-	}
-	if (SCREENWIDTH&63)
-	{
-	    memcpy (dest, src+((y&63)<<6), SCREENWIDTH&63);
-	    dest += (SCREENWIDTH&63);
-	}
-    }
+    V_FillFlat(ORIGHEIGHT, src);
     
     // draw some of the text onto the screen
     cx = 10;
@@ -287,7 +272,7 @@ void F_TextWrite (void)
 	}
 		
 	w = SHORT (hu_font[c]->width);
-	if (cx+w > SCREENWIDTH)
+	if (cx+w > ORIGWIDTH)
 	    break;
 	V_DrawPatch(cx, cy, hu_font[c]);
 	cx+=w;
@@ -514,7 +499,7 @@ void F_CastPrint (const char *text)
     }
     
     // draw it
-    cx = SCREENWIDTH/2-width/2;
+    cx = ORIGWIDTH/2-width/2;
     ch = text;
     while (ch)
     {
@@ -561,9 +546,9 @@ void F_CastDrawer (void)
 			
     patch = W_CacheLumpNum (lump+firstspritelump, PU_CACHE);
     if (flip)
-	V_DrawPatchFlipped(SCREENWIDTH/2, 170, patch);
+	V_DrawPatchFlipped(ORIGWIDTH/2, 170, patch);
     else
-	V_DrawPatch(SCREENWIDTH/2, 170, patch);
+	V_DrawPatch(ORIGWIDTH/2, 170, patch);
 }
 
 
@@ -571,18 +556,7 @@ void F_CastDrawer (void)
 // F_DrawPatchCol
 //
 static void F_DrawPatchCol(int x, patch_t *patch, int col) {
-    column_t* column = GET_COLUMN(patch, col);
-
-    // step through the posts in a column
-    while (column->topdelta != END_COLUMN) {
-        for (int row = 0; row < column->length; row++) {
-            int screen_y = row + column->topdelta;
-            int screen_spot = x + (screen_y * SCREENWIDTH);
-            I_VideoBuffer[screen_spot] = column->data[row];
-        }
-
-        column = NEXT_COLUMN(column);
-    }
+    V_DrawPatchColumn(x, 0, patch, col);
 }
 
 
@@ -602,26 +576,26 @@ static void F_BunnyScroll (void)
     p1 = W_CacheLumpName (DEH_String("PFUB2"), PU_LEVEL);
     p2 = W_CacheLumpName (DEH_String("PFUB1"), PU_LEVEL);
 	
-    scrolled = (SCREENWIDTH - ((signed int) finalecount-230)/2);
-    if (scrolled > SCREENWIDTH)
-	scrolled = SCREENWIDTH;
+    scrolled = (ORIGWIDTH - ((signed int) finalecount-230)/2);
+    if (scrolled > ORIGWIDTH)
+	scrolled = ORIGWIDTH;
     if (scrolled < 0)
 	scrolled = 0;
 		
-    for ( x=0 ; x<SCREENWIDTH ; x++)
+    for ( x=0 ; x<ORIGWIDTH ; x++)
     {
-	if (x+scrolled < SCREENWIDTH)
+	if (x+scrolled < ORIGWIDTH)
 	    F_DrawPatchCol (x, p1, x+scrolled);
 	else
-	    F_DrawPatchCol (x, p2, x+scrolled - SCREENWIDTH);		
+	    F_DrawPatchCol (x, p2, x+scrolled - ORIGWIDTH);		
     }
 	
     if (finalecount < 1130)
 	return;
     if (finalecount < 1180)
     {
-        V_DrawPatch((SCREENWIDTH - 13 * 8) / 2,
-                    (SCREENHEIGHT - 8 * 8) / 2, 
+        V_DrawPatch((ORIGWIDTH - 13 * 8) / 2,
+                    (ORIGHEIGHT - 8 * 8) / 2, 
                     W_CacheLumpName(DEH_String("END0"), PU_CACHE));
 	laststage = 0;
 	return;
@@ -637,8 +611,8 @@ static void F_BunnyScroll (void)
     }
 	
     DEH_snprintf(name, 10, "END%i", stage);
-    V_DrawPatch((SCREENWIDTH - 13 * 8) / 2, 
-                (SCREENHEIGHT - 8 * 8) / 2, 
+    V_DrawPatch((ORIGWIDTH - 13 * 8) / 2, 
+                (ORIGHEIGHT - 8 * 8) / 2, 
                 W_CacheLumpName (name,PU_CACHE));
 }
 
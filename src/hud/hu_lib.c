@@ -81,7 +81,7 @@ void HUlib_drawTextLine(hu_textline_t *l, bool drawcursor) {
         if (c != ' ' && c >= l->sc && c <= '_')
         {
             w = SHORT(l->f[c - l->sc]->width);
-            if (x + w > SCREENWIDTH)
+            if (x + w > ORIGWIDTH)
                 break;
             V_DrawPatch(x, l->y, l->f[c - l->sc]);
             x += w;
@@ -89,13 +89,13 @@ void HUlib_drawTextLine(hu_textline_t *l, bool drawcursor) {
         else
         {
             x += 4;
-            if (x >= SCREENWIDTH)
+            if (x >= ORIGWIDTH)
                 break;
         }
     }
 
     // draw the cursor if requested
-    if (drawcursor && x + SHORT(l->f['_' - l->sc]->width) <= SCREENWIDTH)
+    if (drawcursor && x + SHORT(l->f['_' - l->sc]->width) <= ORIGWIDTH)
     {
         V_DrawPatch(x, l->y, l->f['_' - l->sc]);
     }
@@ -115,7 +115,9 @@ void HUlib_eraseTextLine(hu_textline_t *l) {
     if (!automapactive && viewwindowx && l->needsupdate)
     {
         lh = SHORT(l->f[0]->height) + 1;
-        for (y = l->y, yoffset = y * SCREENWIDTH; y < l->y + lh;
+        // Lines are positioned in original resolution pixels.
+        for (y = l->y * render_scale, yoffset = y * SCREENWIDTH;
+             y < (l->y + lh) * render_scale;
              y++, yoffset += SCREENWIDTH)
         {
             if (y < viewwindowy || y >= viewwindowy + viewheight)
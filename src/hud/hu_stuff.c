@@ -385,7 +385,7 @@ static void StartChatInput(int dest)
     HUlib_resetIText(&w_chat);
     HU_queueChatChar(HU_BROADCAST);
 
-    I_StartTextInput(0, 8, SCREENWIDTH, 16);
+    I_StartTextInput(0, 8, ORIGWIDTH, 16);
 }
 
 static void StopChatInput(void)
@@ -656,6 +656,45 @@ static void P_AssignLinesToSectors() {
     }
 }
 
+//
+// Build the sector adjacency graph from the sector line lists. Only lines
+// sound can ever cross are kept: two-sided lines joining distinct sectors.
+//
+static void P_BuildSectorAdjacency() {
+    int total = 0;
+
+    for (int i = 0; i < numlines; i++) {
+        const line_t* li = &lines[i];
+        if ((li->flags & ML_TWOSIDED) && li->backsector
+            && li->backsector != li->frontsector) {
+            total += 2;
+        }
+    }
+
+    size_t size = total * sizeof(sectoradj_t);
+    sectoradj_t* adjbuffer = Z_Malloc((int) size, PU_LEVEL, NULL);
+
+    for (int i = 0; i < numsectors; i++) {
+        sector_t* sector = &sectors[i];
+        sector->adjacent = adjbuffer;
+        sector->adjcount = 0;
+
+        for (int j = 0; j < sector->linecount; j++) {
+            const line_t* li = sector->lines[j];
+            if (!(li->flags & ML_TWOSIDED) || !li->backsector
+                || li->backsector == li->frontsector) {
+                continue;
+            }
+            sectoradj_t* adj = &sector->adjacent[sector->adjcount];
+            adj->sector = (sector == li->frontsector) ? li->backsector
+                                                      : li->frontsector;
+            adj->soundblock = (li->flags & ML_SOUNDBLOCK) != 0;
+            sector->adjcount++;
+        }
+        adjbuffer += sector->adjcount;
+    }
+}
+
 static void P_BuildSectorLineTable() {
     size_t size = totallines * sizeof(line_t *);
     line_t** linebuffer = Z_Malloc((int) size, PU_LEVEL, NULL);
@@ -701,7 +740,8 @@ static void P_LinkSubSectorsToSectors() {
 
 //
 // P_GroupLines
-// Builds sector line lists and subsector sector numbers.
+// Builds sector line lists, the sector adjacency graph
+// and subsector sector numbers.
 // Finds block bounding boxes for sectors.
 //
 static void P_GroupLines() {
@@ -709,6 +749,7 @@ static void P_GroupLines() {
     P_CountSectorLines();
     P_BuildSectorLineTable();
     P_AssignLinesToSectors();
+    P_BuildSectorAdjacency();
     P_SetSectorsBoundingBox();
 }
 
@@ -880,7 +921,7 @@ void P_SetupLevel(int episode, int map) {
     // set up world state
     P_SpawnSpecials();
     if (precache) {
-        // preload graphics
+        // queue graphics to preload during the screen melt
         R_PrecacheLevel();
     }
 }
@@ -0,0 +1,181 @@
+//
+// Copyright(C) 1993-1996 Id Software, Inc.
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	Slab allocator for fixed size objects.
+//
+
+
+#include "z_slab.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "doomtype.h"
+#include "i_system.h"
+
+
+// Define to poison freed objects, and check the poison is intact
+// when they are handed out again, to catch writes after free.
+// #define SLAB_DEBUG
+
+#define SLAB_POISON 0xdb
+
+// Blocks in a chunk.
+#define SLAB_CHUNK_BLOCKS 128
+
+
+//
+// Every object is preceded by a block header, so Z_SlabFree
+// can find the slab it belongs to.
+//
+typedef struct slabblock_s
+{
+    slab_t* slab;
+    // Next block in the free list.
+    struct slabblock_s* next;
+} slabblock_t;
+
+typedef struct slabchunk_s
+{
+    struct slabchunk_s* next;
+} slabchunk_t;
+
+// Headers are padded to this, keeping objects suitably aligned.
+#define SLAB_ALIGN sizeof(slabblock_t)
+
+
+static byte* Z_ChunkBlocks(slabchunk_t* chunk) {
+    return (byte*) chunk + SLAB_ALIGN;
+}
+
+static void* Z_BlockObject(slabblock_t* block) {
+    return (byte*) block + SLAB_ALIGN;
+}
+
+#ifdef SLAB_DEBUG
+
+static bool Z_IsPoisoned(const slabblock_t* block) {
+    const byte* obj = (const byte*) block + SLAB_ALIGN;
+    for (size_t i = 0; i < block->slab->size; i++) {
+        if (obj[i] != SLAB_POISON) {
+            return false;
+        }
+    }
+    return true;
+}
+
+#endif
+
+
+//
+// Z_SlabInit
+//
+void Z_SlabInit(slab_t* slab, const char* name, size_t size) {
+    memset(slab, 0, sizeof(*slab));
+    slab->name = name;
+    slab->size = size;
+    slab->blocksize = SLAB_ALIGN + (size + SLAB_ALIGN - 1) / SLAB_ALIGN
+                                   * SLAB_ALIGN;
+}
+
+static void Z_AddSlabChunk(slab_t* slab) {
+    size_t size = SLAB_ALIGN + slab->blocksize * SLAB_CHUNK_BLOCKS;
+    slabchunk_t* chunk = malloc(size);
+    if (chunk == NULL) {
+        I_Error("Z_SlabAlloc: failed on allocation of %zu bytes for %s",
+                size, slab->name);
+    }
+    chunk->next = NULL;
+
+    if (slab->current) {
+        slab->current->next = chunk;
+    } else {
+        slab->chunks = chunk;
+    }
+    slab->current = chunk;
+    slab->carved = 0;
+}
+
+//
+// Z_SlabAlloc
+// The object is not cleared.
+//
+void* Z_SlabAlloc(slab_t* slab) {
+    slabblock_t* block;
+
+    if (slab->freelist) {
+        block = slab->freelist;
+        slab->freelist = block->next;
+#ifdef SLAB_DEBUG
+        if (!Z_IsPoisoned(block)) {
+            I_Error("Z_SlabAlloc: %s object %p was written after free",
+                    slab->name, Z_BlockObject(block));
+        }
+#endif
+        return Z_BlockObject(block);
+    }
+
+    if (slab->current == NULL || slab->carved == SLAB_CHUNK_BLOCKS) {
+        if (slab->current && slab->current->next) {
+            // Reuse a chunk kept from before the last reset.
+            slab->current = slab->current->next;
+            slab->carved = 0;
+        } else {
+            Z_AddSlabChunk(slab);
+        }
+    }
+
+    block = (slabblock_t*) (Z_ChunkBlocks(slab->current)
+                            + slab->carved * slab->blocksize);
+    block->slab = slab;
+    slab->carved++;
+    return Z_BlockObject(block);
+}
+
+//
+// Z_SlabFree
+//
+void Z_SlabFree(void* ptr) {
+    slabblock_t* block = (slabblock_t*) ((byte*) ptr - SLAB_ALIGN);
+    slab_t* slab = block->slab;
+
+#ifdef SLAB_DEBUG
+    if (Z_IsPoisoned(block)) {
+        I_Error("Z_SlabFree: %s object %p freed twice", slab->name, ptr);
+    }
+    memset(ptr, SLAB_POISON, slab->size);
+#endif
+
+    block->next = slab->freelist;
+    slab->freelist = block;
+}
+
+//
+// Z_SlabReset
+// Frees every object of the slab at once.
+// The chunks are kept to be reused.
+//
+void Z_SlabReset(slab_t* slab) {
+    slab->freelist = NULL;
+    slab->current = slab->chunks;
+    slab->carved = 0;
+
+#ifdef SLAB_DEBUG
+    size_t size = slab->blocksize * SLAB_CHUNK_BLOCKS;
+    for (slabchunk_t* chunk = slab->chunks; chunk; chunk = chunk->next) {
+        memset(Z_ChunkBlocks(chunk), SLAB_POISON, size);
+    }
+#endif
+}
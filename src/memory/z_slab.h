@@ -0,0 +1,63 @@
+//
+// Copyright(C) 1993-1996 Id Software, Inc.
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//      Slab allocator for fixed size objects.
+//
+
+
+#ifndef __Z_SLAB__
+#define __Z_SLAB__
+
+#include <stddef.h>
+
+//
+// SLAB MEMORY
+// Objects of a single size, carved out of large chunks kept outside
+// the zone heap. Allocating and freeing an object is O(1), and all
+// the objects of a slab are released at once with Z_SlabReset.
+//
+
+struct slabblock_s;
+struct slabchunk_s;
+
+typedef struct slab_s
+{
+    // For error messages.
+    const char* name;
+
+    // Size of the objects, and of the blocks holding them.
+    size_t size;
+    size_t blocksize;
+
+    // Blocks freed with Z_SlabFree, reused first.
+    struct slabblock_s* freelist;
+
+    // All the chunks of the slab, oldest first. Chunks are kept
+    // across Z_SlabReset and filled again from the first one.
+    struct slabchunk_s* chunks;
+    struct slabchunk_s* current;
+
+    // Blocks carved so far out of the current chunk.
+    int carved;
+} slab_t;
+
+
+void Z_SlabInit(slab_t* slab, const char* name, size_t size);
+void* Z_SlabAlloc(slab_t* slab);
+void Z_SlabFree(void* ptr);
+void Z_SlabReset(slab_t* slab);
+
+
+#endif
@@ -111,6 +111,7 @@ char savegamestrings[10][SAVESTRINGSIZE];
 char endstring[160];
 
 static bool opldev;
+static bool sfxcachedev;
 
 short itemOn;           // menu item skull is on
 short skullAnimCounter; // skull animation counter
@@ -971,7 +972,7 @@ void M_WriteText(int x, int y, const char* string) {
         }
 
         int w = SHORT(hu_font[c]->width);
-        if (cx + w > SCREENWIDTH) {
+        if (cx + w > ORIGWIDTH) {
             break;
         }
         V_DrawPatch(cx, cy, hu_font[c]);
@@ -997,15 +998,13 @@ void M_StartControlPanel() {
     itemOn = currentMenu->lastOn;
 }
 
-// Display OPL debug messages - hack for GENMIDI development.
+// Display sound debug messages, one line per row from the top left.
 
-static void M_DrawOPLDev(void)
+static void M_DrawDevMessages(char *debug)
 {
-    char debug[1024];
     char *curr, *p;
     int line;
 
-    I_OPL_DevMessages(debug, sizeof(debug));
     curr = debug;
     line = 0;
 
@@ -1058,7 +1057,7 @@ void M_Drawer() {
     // Horiz. & Vertically center string and print it.
     if (messageToPrint) {
         start = 0;
-        y = SCREENHEIGHT / 2 - M_StringHeight(messageString) / 2;
+        y = ORIGHEIGHT / 2 - M_StringHeight(messageString) / 2;
 
         while (messageString[start] != '\0') {
             bool foundnewline = false;
@@ -1080,7 +1079,7 @@ void M_Drawer() {
                 start += strlen(string);
             }
 
-            x = SCREENWIDTH / 2 - M_StringWidth(string) / 2;
+            x = ORIGWIDTH / 2 - M_StringWidth(string) / 2;
             M_WriteText(x, y, string);
             y += SHORT(hu_font[0]->height);
         }
@@ -1088,8 +1087,16 @@ void M_Drawer() {
         return;
     }
 
+    // OPL debug messages - hack for GENMIDI development.
     if (opldev) {
-        M_DrawOPLDev();
+        char debug[1024];
+        I_OPL_DevMessages(debug, sizeof(debug));
+        M_DrawDevMessages(debug);
+    }
+    else if (sfxcachedev) {
+        char debug[256];
+        I_SfxCacheDevMessages(debug, sizeof(debug));
+        M_DrawDevMessages(debug);
     }
 
     if (!menuactive) {
@@ -1206,5 +1213,13 @@ void M_Init (void)
     }
 
     opldev = M_CheckParm("-opldev") > 0;
+
+    //!
+    // @category obscure
+    //
+    // Show statistics of the converted sound effect cache.
+    //
+
+    sfxcachedev = M_CheckParm("-sfxcachedev") > 0;
 }
 
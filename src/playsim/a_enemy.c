@@ -80,29 +80,50 @@ static dirtype_t diags[] = {
 // Most monsters are spawned unaware of all players,
 // but some can be made pre-aware.
 //
-
-
-//
+// P_FloodSound
 // Called by P_NoiseAlert.
-// Recursively traverse adjacent sectors,
+// Traverse adjacent sectors with an explicit stack,
 // sound blocking lines cut off traversal.
 //
+typedef struct {
+    sector_t* sector;
+    int soundblocks;
+} soundnode_t;
+
 static mobj_t *soundtarget;
 
-static bool P_CanPropagateSound(const line_t* line, int sound_blocks) {
-    if (!(line->flags & ML_TWOSIDED)) {
-        // Solid walls block all sound.
-        return false;
-    }
-    P_LineOpening(line);
-    if (openrange <= 0) {
+static soundnode_t* soundstack;
+static int soundstacksize;
+static int soundstackdepth;
+
+static void P_PushSound(sector_t* sec, int soundblocks) {
+    if (soundstackdepth == soundstacksize) {
+        soundstacksize = soundstacksize ? 2 * soundstacksize : 256;
+        soundstack =
+            I_Realloc(soundstack, soundstacksize * sizeof(*soundstack));
+    }
+    soundstack[soundstackdepth].sector = sec;
+    soundstack[soundstackdepth].soundblocks = soundblocks;
+    soundstackdepth++;
+}
+
+static bool P_CanPropagateSound(const sector_t* sec,
+                                const sectoradj_t* adj,
+                                int soundblocks) {
+    // Same opening as P_LineOpening, without touching its globals.
+    const sector_t* other = adj->sector;
+    fixed_t top = (sec->ceilingheight < other->ceilingheight)
+                    ? sec->ceilingheight : other->ceilingheight;
+    fixed_t bottom = (sec->floorheight > other->floorheight)
+                       ? sec->floorheight : other->floorheight;
+    if (top - bottom <= 0) {
         // Closed doors block all sound.
         return false;
     }
-    if (line->flags & ML_SOUNDBLOCK) {
+    if (adj->soundblock) {
         // Line is set to block sounds. Only allow propagation
         // if this is the first line to block the sound.
-        return sound_blocks == 0;
+        return soundblocks == 0;
     }
     return true;
 }
@@ -117,32 +138,43 @@ static bool P_CanFloodSector(const sector_t* sec, int soundblocks) {
     return soundblocks + 1 < sec->soundtraversed;
 }
 
-static void P_RecursiveSound(sector_t* sec, int soundblocks) {
-    if (!P_CanFloodSector(sec, soundblocks)) {
-        return;
-    }
+//
+// Every sector ends up with the fewest sound-blocking lines (0 or 1)
+// on any open path from the origin, so the result does not depend on
+// the order sectors are visited in and matches the original recursive
+// traversal exactly. Solid walls are not part of the adjacency graph.
+//
+static void P_FloodSound(sector_t* origin) {
+    soundstackdepth = 0;
+    P_PushSound(origin, 0);
 
-    sec->validcount = validcount;
-    sec->soundtraversed = soundblocks + 1;
-    // Wake up all monsters in this sector.
-    sec->soundtarget = soundtarget;
+    while (soundstackdepth > 0) {
+        soundstackdepth--;
+        sector_t* sec = soundstack[soundstackdepth].sector;
+        int soundblocks = soundstack[soundstackdepth].soundblocks;
 
-    for (int i = 0; i < sec->linecount; i++) {
-        const line_t* line = sec->lines[i];
-        if (!P_CanPropagateSound(line, soundblocks)) {
+        if (!P_CanFloodSector(sec, soundblocks)) {
             continue;
         }
-        sector_t* other =
-            (sec == line->frontsector) ? line->backsector : line->frontsector;
-        if (line->flags & ML_SOUNDBLOCK) {
-            // This is a sound-blocking line, but we do not block sound here.
-            // Instead, we recursively call the function for the next
-            // sound-blocking line to block the sound, and so simulate
-            // sound attenuation. This makes the monsters' reactions to the
+
+        sec->validcount = validcount;
+        sec->soundtraversed = soundblocks + 1;
+        // Wake up all monsters in this sector.
+        sec->soundtarget = soundtarget;
+
+        for (int i = 0; i < sec->adjcount; i++) {
+            const sectoradj_t* adj = &sec->adjacent[i];
+            if (!P_CanPropagateSound(sec, adj, soundblocks)) {
+                continue;
+            }
+            // A sound-blocking line does not block sound here. Instead,
+            // the next sound-blocking line blocks it, to simulate sound
+            // attenuation. This makes the monsters' reactions to the
             // player more organic and realistic (checkout Doom 2 MAP01).
-            P_RecursiveSound(other, 1);
-        } else {
-            P_RecursiveSound(other, soundblocks);
+            int next = adj->soundblock ? 1 : soundblocks;
+            if (P_CanFloodSector(adj->sector, next)) {
+                P_PushSound(adj->sector, next);
+            }
         }
     }
 }
@@ -155,7 +187,7 @@ static void P_RecursiveSound(sector_t* sec, int soundblocks) {
 void P_NoiseAlert(mobj_t* target, mobj_t* emitter) {
     soundtarget = target;
     validcount++;
-    P_RecursiveSound(emitter->subsector->sector, 0);
+    P_FloodSound(emitter->subsector->sector);
 }
 
 
@@ -1727,9 +1759,12 @@ void A_BabyMetal(mobj_t* mo) {
 }
 
 
-static mobj_t* braintargets[32];
-static int numbraintargets;
-static int braintargeton = 0;
+mobj_t* braintargets[MAXBRAINTARGETS];
+int numbraintargets;
+int braintargeton = 0;
+// Toggled on every spit; on easy skills only every other one fires.
+// Like vanilla, it is never reset between levels.
+int brainspiteasy = 0;
 
 void A_BrainAwake(const mobj_t* mo) {
     // Find all the target spots.
@@ -1799,10 +1834,9 @@ void A_BrainDie(const mobj_t* mo) {
 }
 
 void A_BrainSpit(mobj_t* mo) {
-    static int easy = 0;
-    easy ^= 1;
+    brainspiteasy ^= 1;
 
-    if (gameskill <= sk_easy && (!easy)) {
+    if (gameskill <= sk_easy && (!brainspiteasy)) {
         return;
     }
     if (numbraintargets == 0) {
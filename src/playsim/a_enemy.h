@@ -24,6 +24,14 @@
 #include "d_player.h"
 #include "p_mobj.h"
 
+#define MAXBRAINTARGETS 32
+
+// Boss brain spawn spots, found by A_BrainAwake.
+extern mobj_t* braintargets[MAXBRAINTARGETS];
+extern int numbraintargets;
+extern int braintargeton;
+extern int brainspiteasy;
+
 void A_KeenDie(mobj_t* actor);
 void A_Look(mobj_t* actor);
 void A_Chase(mobj_t* actor);
@@ -61,6 +61,24 @@
 extern thinker_t thinkercap;
 
 
+// Thinker types, each allocated from its own slab.
+typedef enum
+{
+    tt_mobj,
+    tt_door,
+    tt_plat,
+    tt_floor,
+    tt_ceiling,
+    tt_flash,
+    tt_strobe,
+    tt_glow,
+    tt_fireflicker,
+    NUMTHINKERTYPES
+} thinkertype_t;
+
+void* P_AllocThinker(thinkertype_t type, size_t size);
+void P_DeallocThinker(thinker_t* thinker);
+
 void P_InitThinkers();
 void P_AddThinker(thinker_t *thinker);
 void P_RemoveThinker(thinker_t *thinker);
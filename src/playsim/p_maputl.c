@@ -25,6 +25,7 @@
 
 #include "m_bbox.h"
 #include "m_misc.h"
+#include "i_system.h"
 
 #include "doomstat.h"
 #include "p_local.h"
@@ -408,8 +409,12 @@ bool P_BlockThingsIterator(int x, int y, bool (*func)(mobj_t *)) {
 //
 // INTERCEPT ROUTINES
 //
-static intercept_t intercepts[MAXINTERCEPTS];
+// Grown as needed, so long traces never run off the end.
+static intercept_t* intercepts;
 static intercept_t* intercept_p;
+static int maxintercepts;
+// Scratch space for merging, maxintercepts long.
+static intercept_t* sortintercepts;
 
 static bool earlyout;
 divline_t trace;
@@ -515,6 +520,22 @@ static void InterceptsOverrun(int num_intercepts, intercept_t* intercept) {
     InterceptsMemoryOverrun(location + 8, (intptr_t) intercept->d.thing);
 }
 
+//
+// Make room for one more intercept. The overrun emulation above only
+// depends on the intercept count, not on where the buffer lives.
+//
+static void P_CheckInterceptSpace() {
+    int count = intercept_p - intercepts;
+    if (count < maxintercepts) {
+        return;
+    }
+    maxintercepts = maxintercepts ? 2 * maxintercepts : MAXINTERCEPTS;
+    intercepts = I_Realloc(intercepts, maxintercepts * sizeof(*intercepts));
+    sortintercepts = I_Realloc(sortintercepts,
+                               maxintercepts * sizeof(*sortintercepts));
+    intercept_p = intercepts + count;
+}
+
 static bool PIT_LineInterceptTrace(const line_t* ld, fixed_t* frac) {
     int s1;
     int s2;
@@ -564,6 +585,7 @@ static bool PIT_AddLineIntercepts(line_t* ld) {
         return false;
     }
     // add new intercept line
+    P_CheckInterceptSpace();
     intercept_p->frac = frac;
     intercept_p->isaline = true;
     intercept_p->d.line = ld;
@@ -620,6 +642,7 @@ static bool PIT_AddThingIntercepts(mobj_t* thing) {
     fixed_t frac;
     if (PIT_ThingInterceptTrace(thing, &frac)) {
         // add new intercept line
+        P_CheckInterceptSpace();
         intercept_p->frac = frac;
         intercept_p->isaline = false;
         intercept_p->d.thing = thing;
@@ -631,15 +654,83 @@ static bool PIT_AddThingIntercepts(mobj_t* thing) {
 }
 
 
-static fixed_t P_FindMinDistance(intercept_t** in) {
-    fixed_t dist = INT_MAX;
-    for (intercept_t* scan = intercepts; scan < intercept_p; scan++) {
-        if (scan->frac < dist) {
-            dist = scan->frac;
-            *in = scan;
+// Runs this long are insertion sorted before being merged.
+#define INTERCEPT_SORT_RUN 16
+
+static void P_InsertionSortIntercepts(intercept_t* first, int count) {
+    for (int i = 1; i < count; i++) {
+        intercept_t key = first[i];
+        int j = i;
+        while (j > 0 && first[j - 1].frac > key.frac) {
+            first[j] = first[j - 1];
+            j--;
         }
+        first[j] = key;
+    }
+}
+
+//
+// Merge the sorted ranges src[lo, mid) and src[mid, hi) into dst,
+// taking from the left range on ties.
+//
+static void P_MergeIntercepts(const intercept_t* src, intercept_t* dst,
+                              int lo, int mid, int hi) {
+    if (src[mid - 1].frac <= src[mid].frac) {
+        // Already in order, as is usual along a trace.
+        memcpy(&dst[lo], &src[lo], (hi - lo) * sizeof(*dst));
+        return;
+    }
+    int i = lo;
+    int j = mid;
+    int k = lo;
+    while (i < mid && j < hi) {
+        dst[k++] = (src[j].frac < src[i].frac) ? src[j++] : src[i++];
+    }
+    while (i < mid) {
+        dst[k++] = src[i++];
+    }
+    while (j < hi) {
+        dst[k++] = src[j++];
+    }
+}
+
+//
+// Sort the intercepts by distance. Vanilla picked the closest intercept
+// with a linear scan each step, taking the first one on ties, so the sort
+// must be stable. Short runs are insertion sorted, since intercepts are
+// gathered block by block along the trace and are nearly sorted already,
+// then merged bottom up so long traces stay O(n log n).
+//
+static void P_SortIntercepts() {
+    int count = intercept_p - intercepts;
+    for (int lo = 0; lo < count; lo += INTERCEPT_SORT_RUN) {
+        int n = count - lo;
+        P_InsertionSortIntercepts(&intercepts[lo],
+                                  n < INTERCEPT_SORT_RUN ? n : INTERCEPT_SORT_RUN);
+    }
+    if (count <= INTERCEPT_SORT_RUN) {
+        return;
+    }
+
+    intercept_t* src = intercepts;
+    intercept_t* dst = sortintercepts;
+    for (int width = INTERCEPT_SORT_RUN; width < count; width *= 2) {
+        for (int lo = 0; lo < count; lo += 2 * width) {
+            int mid = lo + width;
+            int hi = lo + 2 * width;
+            if (mid >= count) {
+                memcpy(&dst[lo], &src[lo], (count - lo) * sizeof(*dst));
+                break;
+            }
+            P_MergeIntercepts(src, dst, lo, mid, hi < count ? hi : count);
+        }
+        intercept_t* swap = src;
+        src = dst;
+        dst = swap;
+    }
+    if (src != intercepts) {
+        memcpy(intercepts, src, count * sizeof(*intercepts));
     }
-    return dist;
 }
 
 //
@@ -647,12 +738,10 @@ static fixed_t P_FindMinDistance(intercept_t** in) {
 // Returns true if the traverser function returns true for all lines.
 //
 static bool P_TraverseIntercepts(traverser_t func, fixed_t max_frac) {
-    int count = intercept_p - intercepts;
-    intercept_t* in = NULL;
+    P_SortIntercepts();
 
-    while (count--) {
-        fixed_t dist = P_FindMinDistance(&in);
-        if (dist > max_frac) {
+    for (intercept_t* in = intercepts; in < intercept_p; in++) {
+        if (in->frac > max_frac) {
             // Checked everything in range.
             return true;
         }
@@ -660,7 +749,6 @@ static bool P_TraverseIntercepts(traverser_t func, fixed_t max_frac) {
             // Don't bother going farther.
             return false;
         }
-        in->frac = INT_MAX;
     }
 
     // Everything was traversed.
@@ -600,7 +600,7 @@ static void P_SetMobjTypeData(mobj_t* mobj, mobjtype_t type) {
 // P_SpawnMobj
 //
 mobj_t* P_SpawnMobj(fixed_t x, fixed_t y, fixed_t z, mobjtype_t type) {
-    mobj_t* mobj = Z_Malloc(sizeof(*mobj), PU_LEVEL, NULL);
+    mobj_t* mobj = P_AllocThinker(tt_mobj, sizeof(*mobj));
     memset(mobj, 0, sizeof(*mobj));
 
     mobj->x = x;
@@ -21,16 +21,17 @@
 #include "p_tick.h"
 
 #include "doomstat.h"
+#include "i_system.h"
 #include "p_local.h"
-#include "z_zone.h"
+#include "z_slab.h"
 
 
 int leveltime;
 
 //
 // THINKERS
-// All thinkers should be allocated by Z_Malloc, so they can be operated on
-// uniformly. The actual structures will vary in size, but the first element
+// All thinkers should be allocated by P_AllocThinker, so they can be operated
+// on uniformly. The actual structures will vary in size, but the first element
 // must be thinker_t.
 //
 
@@ -39,12 +40,72 @@ int leveltime;
 thinker_t thinkercap;
 
 
+//
+// THINKER SLABS
+// Each type of thinker is allocated from its own slab, so thinkers of a
+// type sit next to each other in memory instead of being scattered
+// through the zone heap among cached lumps. All of them are released at
+// once by P_InitThinkers when a level is set up. The thinker list, and so
+// the order thinkers run in, is unaffected.
+//
+
+static const char* thinkerslabnames[NUMTHINKERTYPES] = {
+    "mobjs", "doors", "plats", "floors", "ceilings",
+    "light flashes", "strobes", "glows", "fire flickers"
+};
+
+static slab_t thinkerslabs[NUMTHINKERTYPES];
+
+//
+// P_AllocThinker
+// Allocates memory for a thinker of the given type.
+// The memory is not cleared.
+//
+void* P_AllocThinker(thinkertype_t type, size_t size) {
+    slab_t* slab = &thinkerslabs[type];
+    if (slab->size == 0) {
+        Z_SlabInit(slab, thinkerslabnames[type], size);
+    } else if (slab->size != size) {
+        I_Error("P_AllocThinker: Size %zu does not match %s (%zu)",
+                size, slab->name, slab->size);
+    }
+    return Z_SlabAlloc(slab);
+}
+
+//
+// P_DeallocThinker
+// Gives back the memory of a thinker allocated with P_AllocThinker.
+//
+void P_DeallocThinker(thinker_t* thinker) {
+    Z_SlabFree(thinker);
+}
+
+static void P_ResetThinkerSlabs() {
+    for (int i = 0; i < NUMTHINKERTYPES; i++) {
+        Z_SlabReset(&thinkerslabs[i]);
+    }
+}
+
+
 //
 // P_InitThinkers
+// Called on level setup and when loading a savegame or keyframe, and
+// frees every thinker. Anything still pointing at a thinker must be
+// cleared or restored by the caller:
+//  - P_SetupLevel frees the whole PU_LEVEL state along with them;
+//  - P_UnArchiveThinkers runs after the player mobjs, attackers and
+//    sound targets have been cleared, and P_RemoveMobj stops the
+//    sounds of each mobj first;
+//  - P_UnArchiveKeyframe restores every mobj reference, including the
+//    brain targets and body queue, from the keyframe.
+// The slab chunks themselves are never freed, so a missed reference
+// reads a reused object rather than unmapped memory, as a freed zone
+// block did before.
 //
 void P_InitThinkers() {
     thinkercap.prev = &thinkercap;
     thinkercap.next  = &thinkercap;
+    P_ResetThinkerSlabs();
 }
 
 //
@@ -78,7 +139,7 @@ bool P_IsThinkerRemoved(thinker_t* thinker) {
 static void P_FreeThinker(thinker_t* thinker) {
     thinker->next->prev = thinker->prev;
     thinker->prev->next = thinker->next;
-    Z_Free(thinker);
+    P_DeallocThinker(thinker);
 }
 
 //
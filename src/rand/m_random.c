@@ -58,6 +58,16 @@ void M_ClearRandom() {
     prndindex = 0;
 }
 
+void M_GetRandomState(int* m_index, int* p_index) {
+    *m_index = rndindex;
+    *p_index = prndindex;
+}
+
+void M_SetRandomState(int m_index, int p_index) {
+    rndindex = m_index & 0xff;
+    prndindex = p_index & 0xff;
+}
+
 // inspired by the same routine in Eternity, thanks haleyjd
 int P_SubRandom() {
     int r = P_Random();
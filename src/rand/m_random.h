@@ -44,4 +44,10 @@ int M_Random();
 //
 void M_ClearRandom();
 
+//
+// Get/set both random indices, used to snapshot the play simulation.
+//
+void M_GetRandomState(int* m_index, int* p_index);
+void M_SetRandomState(int m_index, int p_index);
+
 #endif
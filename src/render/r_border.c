@@ -20,6 +20,8 @@
 
 #include "doomdef.h"
 #include "deh_str.h"
+#include <stdlib.h>
+#include "i_system.h"
 #include "z_zone.h"
 #include "w_wad.h"
 #include "r_local.h"
@@ -36,20 +38,29 @@
 static pixel_t* background_buffer = NULL;
 
 
+//
+// The border patches are positioned in original resolution coordinates,
+// which V_DrawPatch scales up.
+//
+#define BORDER_X (viewwindowx / render_scale)
+#define BORDER_Y (viewwindowy / render_scale)
+#define BORDER_W (scaledviewwidth / render_scale)
+#define BORDER_H (viewheight / render_scale)
+
 static void R_DrawBeveledEdge() {
     V_UseBuffer(background_buffer);
 
     patch_t* patch = W_CacheLumpName(DEH_String("brdr_tl"), PU_CACHE);
-    V_DrawPatch(viewwindowx - 8, viewwindowy - 8, patch);
+    V_DrawPatch(BORDER_X - 8, BORDER_Y - 8, patch);
 
     patch = W_CacheLumpName(DEH_String("brdr_tr"), PU_CACHE);
-    V_DrawPatch(viewwindowx + scaledviewwidth, viewwindowy - 8, patch);
+    V_DrawPatch(BORDER_X + BORDER_W, BORDER_Y - 8, patch);
 
     patch = W_CacheLumpName(DEH_String("brdr_bl"), PU_CACHE);
-    V_DrawPatch(viewwindowx - 8, viewwindowy + viewheight, patch);
+    V_DrawPatch(BORDER_X - 8, BORDER_Y + BORDER_H, patch);
 
     patch = W_CacheLumpName(DEH_String("brdr_br"), PU_CACHE);
-    V_DrawPatch(viewwindowx + scaledviewwidth, viewwindowy + viewheight, patch);
+    V_DrawPatch(BORDER_X + BORDER_W, BORDER_Y + BORDER_H, patch);
 
     V_RestoreBuffer();
 }
@@ -58,8 +69,8 @@ static void R_DrawBackScreenRightBorder() {
     V_UseBuffer(background_buffer);
 
     patch_t* patch = W_CacheLumpName(DEH_String("brdr_r"), PU_CACHE);
-    for (int y = 0; y < viewheight; y += 8) {
-        V_DrawPatch(viewwindowx + scaledviewwidth, viewwindowy + y, patch);
+    for (int y = 0; y < BORDER_H; y += 8) {
+        V_DrawPatch(BORDER_X + BORDER_W, BORDER_Y + y, patch);
     }
 
     V_RestoreBuffer();
@@ -69,8 +80,8 @@ static void R_DrawBackScreenLeftBorder() {
     V_UseBuffer(background_buffer);
 
     patch_t* patch = W_CacheLumpName(DEH_String("brdr_l"), PU_CACHE);
-    for (int y = 0; y < viewheight; y += 8) {
-        V_DrawPatch(viewwindowx - 8, viewwindowy + y, patch);
+    for (int y = 0; y < BORDER_H; y += 8) {
+        V_DrawPatch(BORDER_X - 8, BORDER_Y + y, patch);
     }
 
     V_RestoreBuffer();
@@ -80,8 +91,8 @@ static void R_DrawBackScreenBottomBorder() {
     V_UseBuffer(background_buffer);
 
     patch_t* patch = W_CacheLumpName(DEH_String("brdr_b"), PU_CACHE);
-    for (int x = 0; x < scaledviewwidth; x += 8) {
-        V_DrawPatch(viewwindowx + x, viewwindowy + viewheight, patch);
+    for (int x = 0; x < BORDER_W; x += 8) {
+        V_DrawPatch(BORDER_X + x, BORDER_Y + BORDER_H, patch);
     }
 
     V_RestoreBuffer();
@@ -91,8 +102,8 @@ static void R_DrawBackScreenTopBorder() {
     V_UseBuffer(background_buffer);
 
     patch_t* patch = W_CacheLumpName(DEH_String("brdr_t"), PU_CACHE);
-    for (int x = 0; x < scaledviewwidth; x += 8) {
-        V_DrawPatch(viewwindowx + x, viewwindowy - 8, patch);
+    for (int x = 0; x < BORDER_W; x += 8) {
+        V_DrawPatch(BORDER_X + x, BORDER_Y - 8, patch);
     }
 
     V_RestoreBuffer();
@@ -116,28 +127,20 @@ static const byte* R_GetBackScreenTexture() {
 }
 
 static void R_FillBackScreenWithTexture() {
-    pixel_t* dest = background_buffer;
     const byte* texture = R_GetBackScreenTexture();
 
-    for (int y = 0; y < SCREENHEIGHT - SBARHEIGHT; y++) {
-        const byte* src = texture + ((y & 63) << 6);
-        for (int x = 0; x < SCREENWIDTH / 64; x++) {
-            memcpy(dest, src, 64);
-            dest += 64;
-        }
-        if (SCREENWIDTH & 63) {
-            memcpy(dest, src, SCREENWIDTH & 63);
-            dest += (SCREENWIDTH & 63);
-        }
-    }
+    V_UseBuffer(background_buffer);
+    V_FillFlat((SCREENHEIGHT - SBARHEIGHT) / render_scale, texture);
+    V_RestoreBuffer();
 }
 
+//
+// The buffer grows with render_scale, so it is kept out of the zone.
+//
 static void R_AllocBackgroundScreen() {
     unsigned int count = SCREENWIDTH * (SCREENHEIGHT - SBARHEIGHT);
     unsigned int size = count * sizeof(*background_buffer);
-    int tag = PU_STATIC;
-    void* user = NULL;
-    background_buffer = Z_Malloc((int) size, tag, user);
+    background_buffer = I_Realloc(NULL, size);
 }
 
 //
@@ -150,7 +153,7 @@ void R_FillBackScreen() {
     // and the background buffer can be freed if it was previously in use.
     if (scaledviewwidth == SCREENWIDTH) {
         if (background_buffer != NULL) {
-            Z_Free(background_buffer);
+            free(background_buffer);
             background_buffer = NULL;
         }
         return;
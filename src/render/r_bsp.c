@@ -19,6 +19,7 @@
 
 #include "m_bbox.h"
 #include "i_system.h"
+#include "z_zone.h"
 #include "r_main.h"
 #include "r_plane.h"
 #include "r_things.h"
@@ -31,13 +32,38 @@ side_t* sidedef;
 line_t* linedef;
 sector_t* frontsector;
 sector_t* backsector;
-drawseg_t drawsegs[MAXDRAWSEGS];
+drawseg_t* drawsegs;
 drawseg_t *ds_p;
+int maxdrawsegs;
 
 
 void R_RenderWallRange(int start, int stop);
 
 
+//
+// R_InitDrawSegs
+//
+void R_InitDrawSegs(void) {
+    maxdrawsegs = MAXDRAWSEGS;
+    drawsegs = Z_Malloc(maxdrawsegs * sizeof(*drawsegs), PU_STATIC, NULL);
+}
+
+//
+// R_GrowDrawSegs
+// Double the drawseg array, keeping ds_p pointing at the same entry.
+// Only used when vanilla_render_limits is off.
+//
+void R_GrowDrawSegs(void) {
+    ptrdiff_t used = ds_p - drawsegs;
+    drawseg_t* segs = Z_Malloc(maxdrawsegs * 2 * sizeof(*segs), PU_STATIC, NULL);
+
+    memcpy(segs, drawsegs, maxdrawsegs * sizeof(*segs));
+    Z_Free(drawsegs);
+    drawsegs = segs;
+    ds_p = drawsegs + used;
+    maxdrawsegs *= 2;
+}
+
 //
 // R_ClearDrawSegs
 //
@@ -68,7 +94,7 @@ typedef	struct
 
 // newend is one past the last valid seg
 static cliprange_t* newend;
-static cliprange_t solidsegs[MAXSEGS];
+static cliprange_t* solidsegs;
 
 
 //
@@ -192,6 +218,13 @@ static void R_ClipPassWallSegment(int first, int last) {
 
 
 
+//
+// R_InitClipSegs
+//
+void R_InitClipSegs(void) {
+    solidsegs = Z_Malloc(MAXSEGS * sizeof(*solidsegs), PU_STATIC, NULL);
+}
+
 //
 // R_ClearClipSegs
 //
@@ -346,7 +379,8 @@ static void R_RenderSubSectorLines(const subsector_t* sub_sector) {
     }
 
     // Check for solidsegs overflow - extremely unsatisfactory!
-    if (newend > &solidsegs[32]) {
+    // The vanilla limit of 32 grows with the render scale.
+    if (newend > &solidsegs[32 * render_scale]) {
         I_Error("R_RenderSubSector: solidsegs overflow (vanilla may crash here)\n");
     }
 }
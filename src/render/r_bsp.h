@@ -27,12 +27,16 @@ extern line_t*		linedef;
 extern sector_t*	frontsector;
 extern sector_t*	backsector;
 
-extern drawseg_t	drawsegs[MAXDRAWSEGS];
+extern drawseg_t*	drawsegs;
 extern drawseg_t*	ds_p;
+extern int		maxdrawsegs;
 
 
 // BSP?
+void R_InitClipSegs(void);
 void R_ClearClipSegs();
+void R_InitDrawSegs(void);
+void R_GrowDrawSegs(void);
 void R_ClearDrawSegs();
 
 
@@ -772,7 +772,21 @@ int R_TextureNumForName(const char *name) {
 //
 // R_PrecacheLevel
 // Preloads all relevant graphics for the level.
+// The lumps are only queued here and read by R_PrecacheStep, so that
+// the reading can be spread over the screen melt into the level.
 //
+
+// Number of lumps read per R_PrecacheStep call.
+#define PRECACHE_BATCH 8
+
+// One flag per WAD lump, set for lumps still to be read.
+static byte* precache_queue = NULL;
+static unsigned int precache_next;
+
+static void R_QueuePrecache(int lump) {
+    precache_queue[lump] = 1;
+}
+
 static void R_PrecacheSprites() {
     char* spritepresent = Z_Malloc(numsprites, PU_STATIC, NULL);
     memset(spritepresent, 0, numsprites);
@@ -793,7 +807,7 @@ static void R_PrecacheSprites() {
             const spriteframe_t* sf = &sprites[i].spriteframes[j];
             for (int k = 0; k < 8; k++) {
                 int lump = firstspritelump + sf->lump[k];
-                W_CacheLumpNum(lump, PU_CACHE);
+                R_QueuePrecache(lump);
             }
         }
     }
@@ -823,7 +837,7 @@ static void R_PrecacheTextures() {
         const texture_t* texture = textures[i];
         for (int j = 0; j < texture->patchcount; j++) {
             int lump = texture->patches[j].patch;
-            W_CacheLumpNum(lump, PU_CACHE);
+            R_QueuePrecache(lump);
         }
     }
 
@@ -845,7 +859,7 @@ static void R_PrecacheFlats() {
     for (int i = 0; i < numflats; i++) {
         if (flatpresent[i]) {
             int lump = firstflat + i;
-            W_CacheLumpNum(lump, PU_CACHE);
+            R_QueuePrecache(lump);
         }
     }
 
@@ -853,10 +867,55 @@ static void R_PrecacheFlats() {
 }
 
 void R_PrecacheLevel() {
+    // Drop anything left over from the previous level.
+    if (precache_queue != NULL) {
+        Z_Free(precache_queue);
+        precache_queue = NULL;
+    }
     if (demoplayback) {
         return;
     }
+
+    precache_queue = Z_Malloc(numlumps, PU_STATIC, NULL);
+    memset(precache_queue, 0, numlumps);
+    precache_next = 0;
+
     R_PrecacheFlats();
     R_PrecacheTextures();
     R_PrecacheSprites();
 }
+
+//
+// R_PrecacheStep
+// Read the next few queued lumps. Returns false once the queue is empty.
+//
+bool R_PrecacheStep(void) {
+    if (precache_queue == NULL) {
+        return false;
+    }
+
+    int count = 0;
+    while (precache_next < numlumps && count < PRECACHE_BATCH) {
+        if (precache_queue[precache_next]) {
+            W_CacheLumpNum((int) precache_next, PU_CACHE);
+            count++;
+        }
+        precache_next++;
+    }
+
+    if (precache_next >= numlumps) {
+        Z_Free(precache_queue);
+        precache_queue = NULL;
+        return false;
+    }
+    return true;
+}
+
+//
+// R_FinishPrecache
+// Read everything still queued.
+//
+void R_FinishPrecache(void) {
+    while (R_PrecacheStep()) {
+    }
+}
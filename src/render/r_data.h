@@ -32,6 +32,8 @@ const byte* R_GetColumn(int tex, int col);
 // I/O, setting up the stuff.
 void R_InitData (void);
 void R_PrecacheLevel (void);
+bool R_PrecacheStep(void);
+void R_FinishPrecache(void);
 
 
 // Retrieval.
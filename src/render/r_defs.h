@@ -81,11 +81,24 @@ typedef struct
 } degenmobj_t;
 
 
+struct sector_s;
+
+//
+// An edge of the sector adjacency graph: a sector reachable
+// through a two-sided line. Used by sound propagation.
+//
+typedef struct
+{
+    struct sector_s* sector;
+    // The line between both sectors has ML_SOUNDBLOCK set.
+    bool soundblock;
+} sectoradj_t;
+
 //
 // The SECTORS record, at runtime.
 // Stores things/mobjs.
 //
-typedef struct
+typedef struct sector_s
 {
     fixed_t floorheight;
     fixed_t ceilingheight;
@@ -123,6 +136,11 @@ typedef struct
 
     // [linecount] size
     struct line_s** lines;
+
+    int adjcount;
+
+    // [adjcount] size, one entry per two-sided line
+    sectoradj_t* adjacent;
 } sector_t;
 
 
@@ -409,7 +427,7 @@ typedef struct
 // one visplane). Each X position in the visplane has a particular vertical
 // line of texture which is to be drawn.
 // 
-typedef struct
+typedef struct visplane_s
 {
     fixed_t height;
     int picnum;
@@ -417,17 +435,16 @@ typedef struct
     int minx;
     int maxx;
 
-    // leave pads for [minx-1]/[maxx+1]
-    byte pad1;
-
-    // Here lies the rub for all dynamic resize/change of resolution.
-    byte top[SCREENWIDTH];
-    byte pad2;
-    byte pad3;
+    // SCREENWIDTH entries each, allocated by R_InitPlanes with
+    // pads left for [minx-1]/[maxx+1].
+    unsigned short* top;
+    unsigned short* bottom;
 
-    // See above.
-    byte bottom[SCREENWIDTH];
-    byte pad4;
+    // Next plane in the same R_FindPlane hash chain.
+    struct visplane_s* next;
 } visplane_t;
 
+// Value of visplane top[] for columns the plane does not cover.
+#define VISPLANE_EMPTY 0xffff
+
 #endif
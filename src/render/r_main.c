@@ -22,6 +22,7 @@
 #include <stdlib.h>
 #include "d_loop.h"
 #include "m_menu.h"
+#include "z_zone.h"
 #include "r_local.h"
 #include "r_sky.h"
 
@@ -75,7 +76,7 @@ int viewangletox[FINEANGLES / 2];
 // The xtoviewangleangle[] table maps a screen pixel
 // to the lowest viewangle that maps back to x ranges
 // from clipangle to -clipangle.
-angle_t xtoviewangle[SCREENWIDTH + 1];
+angle_t* xtoviewangle;
 
 lighttable_t* scalelight[LIGHTLEVELS][MAXLIGHTSCALE];
 lighttable_t* scalelightfixed[MAXLIGHTSCALE];
@@ -84,6 +85,10 @@ lighttable_t* zlight[LIGHTLEVELS][MAXLIGHTZ];
 // bumped light from gun blasts
 int extralight;
 
+// If true, the visplane, drawseg and opening limits of Vanilla Doom
+// are kept.
+int vanilla_render_limits = 1;
+
 
 void (*colfunc)(void);
 void (*basecolfunc)(void);
@@ -219,8 +224,8 @@ fixed_t R_PointToDist(fixed_t x, fixed_t y) {
     return FixedDiv(dx, COS(angle));
 }
 
-// 64
-#define MAX_SCALE (64 * FRACUNIT)
+// 64, in screen pixels, so it scales with the resolution.
+#define MAX_SCALE (64 * FRACUNIT * render_scale)
 
 // 0.00390625
 #define MIN_SCALE (256)
@@ -356,7 +361,7 @@ void R_InitLightTables(void) {
         startmap = ((LIGHTLEVELS - 1 - i) * 2) * NUMCOLORMAPS / LIGHTLEVELS;
         for (int j = 0; j < MAXLIGHTZ; j++) {
             scale =
-                FixedDiv((SCREENWIDTH / 2 * FRACUNIT), (j + 1) << LIGHTZSHIFT);
+                FixedDiv((ORIGWIDTH / 2 * FRACUNIT), (j + 1) << LIGHTZSHIFT);
             scale >>= LIGHTSCALESHIFT;
             level = startmap - scale / DISTMAP;
             if (level < 0) {
@@ -420,8 +425,8 @@ static void R_UpdateThingClippingArray() {
 // psprite scales
 //
 static void R_UpdateSpriteScales() {
-    pspritescale = FRACUNIT * viewwidth / SCREENWIDTH;
-    pspriteiscale = FRACUNIT * SCREENWIDTH / viewwidth;
+    pspritescale = FRACUNIT * viewwidth / ORIGWIDTH;
+    pspriteiscale = FRACUNIT * ORIGWIDTH / viewwidth;
 }
 
 static void R_UpdateDrawFuncs() {
@@ -445,8 +450,8 @@ static void R_UpdateProjectionPlane() {
         scaledviewwidth = SCREENWIDTH;
         viewheight = SCREENHEIGHT;
     } else {
-        scaledviewwidth = setblocks * 32;
-        viewheight = (setblocks * 168 / 10) & ~7;
+        scaledviewwidth = setblocks * 32 * render_scale;
+        viewheight = ((setblocks * 168 / 10) & ~7) * render_scale;
     }
 
     detailshift = setdetail;
@@ -469,6 +474,7 @@ void R_ExecuteSetViewSize() {
     R_UpdateDrawFuncs();
     R_UpdateViewWindow(scaledviewwidth, viewheight);
     R_InitTextureMapping();
+    R_UpdatePlaneTables();
     R_UpdateSpriteScales();
     R_UpdateThingClippingArray();
     R_UpdateLight();
@@ -478,6 +484,11 @@ void R_ExecuteSetViewSize() {
 // R_Init
 //
 void R_Init(void) {
+    xtoviewangle = Z_Malloc((SCREENWIDTH + 1) * sizeof(*xtoviewangle),
+                            PU_STATIC, NULL);
+    R_InitClipSegs();
+    R_InitDrawSegs();
+    R_InitPlanes();
     R_InitData();
     printf(".");
     printf(".");
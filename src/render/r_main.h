@@ -74,6 +74,8 @@ extern lighttable_t* zlight[LIGHTLEVELS][MAXLIGHTZ];
 extern int extralight;
 extern lighttable_t* fixedcolormap;
 
+extern int vanilla_render_limits;
+
 
 
 
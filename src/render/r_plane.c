@@ -32,16 +32,38 @@
 //
 
 // Here comes the obnoxious "visplane".
+// The pool starts at the vanilla limit and only grows when
+// vanilla_render_limits is off.
 #define MAXVISPLANES 128
-static visplane_t visplanes[MAXVISPLANES];
-static visplane_t* lastvisplane;
+static visplane_t** visplanes;
+static int num_visplanes;
+static int max_visplanes;
 visplane_t* floorplane;
 visplane_t* ceilingplane;
 
+// Visplanes with the same height, flat and light level share a hash
+// chain, kept in the order the planes were created.
+#define VISPLANEHASHSIZE 128
+#define VISPLANEHASH(height, picnum, lightlevel) \
+    (((unsigned) (picnum) * 3 + (unsigned) (lightlevel) \
+      + (unsigned) (height) * 7) & (VISPLANEHASHSIZE - 1))
+static visplane_t* visplanehash[VISPLANEHASHSIZE];
+static visplane_t* visplanehash_last[VISPLANEHASHSIZE];
+
 // ?
-#define MAXOPENINGS SCREENWIDTH * 64
-static short openings[MAXOPENINGS];
-short* lastopening;
+// Openings are handed out from a chain of blocks. Only the first,
+// vanilla sized one is used unless vanilla_render_limits is off.
+#define MAXOPENINGS (SCREENWIDTH * 64)
+
+typedef struct openingblock_s {
+    struct openingblock_s* next;
+    int size;
+    short* data;
+} openingblock_t;
+
+static openingblock_t* first_openings;
+static openingblock_t* cur_openings;
+static short* lastopening;
 
 
 //
@@ -49,13 +71,13 @@ short* lastopening;
 //  floorclip starts out SCREENHEIGHT
 //  ceilingclip starts out -1
 //
-short floorclip[SCREENWIDTH];
-short ceilingclip[SCREENWIDTH];
+short* floorclip;
+short* ceilingclip;
 
 //
 // spanstart holds the start of a plane span initialized to 0 at start
 //
-static int spanstart[SCREENHEIGHT];
+static int* spanstart;
 
 //
 // texture mapping
@@ -63,6 +85,109 @@ static int spanstart[SCREENHEIGHT];
 static lighttable_t** planezlight;
 static fixed_t planeheight;
 
+// Slope of each row and distance scale of each column, set up by
+// R_UpdatePlaneTables.
+static fixed_t* yslope;
+static fixed_t* distscale;
+
+// Texture steps for the current view angle.
+static fixed_t basexscale;
+static fixed_t baseyscale;
+
+// Distance and steps of each row for the plane height last drawn on it.
+static fixed_t* cachedheight;
+static fixed_t* cacheddistance;
+static fixed_t* cachedxstep;
+static fixed_t* cachedystep;
+
+//
+// Spans are collected from all the visplanes of a frame before any are
+// drawn, so that they can be drawn a flat at a time.
+//
+typedef struct {
+    short y;
+    short x1;
+    short x2;
+} planespan_t;
+
+typedef struct {
+    int lumpnum;
+    fixed_t height;
+    lighttable_t** zlight;
+    int firstspan;
+    int numspans;
+} flatplane_t;
+
+static planespan_t* planespans;
+static int num_planespans;
+static int max_planespans;
+
+static flatplane_t* flatplanes;
+static int max_flatplanes;
+
+
+static openingblock_t* R_NewOpeningsBlock(int size) {
+    openingblock_t* block = Z_Malloc(sizeof(*block), PU_STATIC, NULL);
+    block->next = NULL;
+    block->size = size;
+    block->data = Z_Malloc(size * (int) sizeof(*block->data), PU_STATIC, NULL);
+    return block;
+}
+
+//
+// Add count more visplanes to the pool.
+//
+static void R_GrowVisplanes(int count) {
+    visplane_t** list = Z_Malloc((max_visplanes + count) * (int) sizeof(*list),
+                                 PU_STATIC, NULL);
+    if (visplanes != NULL) {
+        memcpy(list, visplanes, max_visplanes * sizeof(*list));
+        Z_Free(visplanes);
+    }
+    visplanes = list;
+
+    visplane_t* planes = Z_Malloc(count * (int) sizeof(*planes), PU_STATIC, NULL);
+
+    // Each plane gets top[] and bottom[] with a pad on either side.
+    // These grow with render_scale, so they are kept out of the zone.
+    int stride = SCREENWIDTH + 2;
+    size_t size = count * stride * 2 * sizeof(unsigned short);
+    unsigned short* columns = I_Realloc(NULL, size);
+    memset(columns, 0, size);
+
+    for (int i = 0; i < count; i++) {
+        planes[i].top = columns + 1;
+        planes[i].bottom = columns + stride + 1;
+        columns += stride * 2;
+        visplanes[max_visplanes + i] = &planes[i];
+    }
+    max_visplanes += count;
+}
+
+//
+// R_InitPlanes
+// Allocate the screen sized arrays once the render scale is known.
+//
+void R_InitPlanes(void) {
+    first_openings = R_NewOpeningsBlock(MAXOPENINGS);
+    floorclip = Z_Malloc(SCREENWIDTH * sizeof(*floorclip), PU_STATIC, NULL);
+    ceilingclip = Z_Malloc(SCREENWIDTH * sizeof(*ceilingclip), PU_STATIC, NULL);
+    spanstart = Z_Malloc(SCREENHEIGHT * sizeof(*spanstart), PU_STATIC, NULL);
+
+    yslope = Z_Malloc(SCREENHEIGHT * sizeof(*yslope), PU_STATIC, NULL);
+    distscale = Z_Malloc(SCREENWIDTH * sizeof(*distscale), PU_STATIC, NULL);
+    cachedheight = Z_Malloc(SCREENHEIGHT * sizeof(*cachedheight), PU_STATIC, NULL);
+    cacheddistance = Z_Malloc(SCREENHEIGHT * sizeof(*cacheddistance), PU_STATIC, NULL);
+    cachedxstep = Z_Malloc(SCREENHEIGHT * sizeof(*cachedxstep), PU_STATIC, NULL);
+    cachedystep = Z_Malloc(SCREENHEIGHT * sizeof(*cachedystep), PU_STATIC, NULL);
+
+    R_GrowVisplanes(MAXVISPLANES);
+
+    max_flatplanes = max_visplanes;
+    flatplanes = Z_Malloc(max_flatplanes * sizeof(*flatplanes), PU_STATIC, NULL);
+    max_planespans = SCREENHEIGHT * 16;
+    planespans = Z_Malloc(max_planespans * sizeof(*planespans), PU_STATIC, NULL);
+}
 
 //
 // R_ClearPlanes
@@ -75,34 +200,125 @@ void R_ClearPlanes() {
 	ceilingclip[i] = -1;
     }
 
-    lastvisplane = visplanes;
-    lastopening = openings;
+    num_visplanes = 0;
+    memset(visplanehash, 0, sizeof(visplanehash));
+    memset(visplanehash_last, 0, sizeof(visplanehash_last));
+
+    cur_openings = first_openings;
+    lastopening = first_openings->data;
+
+    // Plane heights are never negative, so no row is cached yet.
+    memset(cachedheight, 0xff, SCREENHEIGHT * sizeof(*cachedheight));
+
+    // left to right mapping
+    angle_t angle = viewangle - ANG90;
+
+    // scale will be unit scale at SCREENWIDTH/2 distance
+    basexscale = FixedDiv(COS(angle), centerxfrac);
+    baseyscale = -FixedDiv(SIN(angle), centerxfrac);
 }
 
+//
+// R_AllocOpenings
+// Reserve count contiguous openings for the clip arrays of a drawseg.
+//
+short* R_AllocOpenings(int count) {
+    short* end = cur_openings->data + cur_openings->size;
 
+    if (lastopening + count > end) {
+        if (vanilla_render_limits) {
+            // Vanilla would overrun the array here and bomb out at
+            // the end of the frame.
+            I_Error("R_AllocOpenings: opening overflow (%td)",
+                    lastopening + count - first_openings->data);
+        }
+        // Move on to the next block, adding one if there is none big
+        // enough.
+        if (cur_openings->next == NULL || cur_openings->next->size < count) {
+            openingblock_t* block =
+                R_NewOpeningsBlock(count > MAXOPENINGS ? count : MAXOPENINGS);
+            block->next = cur_openings->next;
+            cur_openings->next = block;
+        }
+        cur_openings = cur_openings->next;
+        lastopening = cur_openings->data;
+    }
+
+    short* result = lastopening;
+    lastopening += count;
+    return result;
+}
+
+
+//
+// A new plane covers no columns, so its top[] is only cleared as
+// R_GetPlane extends it.
+//
 static visplane_t* R_NewVisplane(fixed_t height, int pic, int light) {
-    if (lastvisplane - visplanes == MAXVISPLANES) {
-        I_Error("R_NewVisplane: no more visplanes");
+    if (num_visplanes == max_visplanes) {
+        if (vanilla_render_limits) {
+            I_Error("R_NewVisplane: no more visplanes");
+        }
+        R_GrowVisplanes(max_visplanes);
     }
-    visplane_t*	new_plane = lastvisplane;
-    lastvisplane++;
+    visplane_t*	new_plane = visplanes[num_visplanes];
+    num_visplanes++;
 
     new_plane->height = height;
     new_plane->picnum = pic;
     new_plane->lightlevel = light;
     new_plane->minx = SCREENWIDTH;
     new_plane->maxx = -1;
-    memset(new_plane->top, 0xff, sizeof(new_plane->top));
+    new_plane->next = NULL;
+
+    unsigned hash = VISPLANEHASH(height, pic, light);
+    if (visplanehash_last[hash] != NULL) {
+        visplanehash_last[hash]->next = new_plane;
+    } else {
+        visplanehash[hash] = new_plane;
+    }
+    visplanehash_last[hash] = new_plane;
 
     return new_plane;
 }
 
+//
+// Mark the columns [start, stop] of a plane as unused.
+//
+static void R_ClearPlaneColumns(visplane_t* pl, int start, int stop) {
+    if (start <= stop) {
+        memset(&pl->top[start], 0xff, (stop - start + 1) * sizeof(*pl->top));
+    }
+}
+
+//
+// Extend the horizontal bounds of a plane to include [start, stop],
+// clearing the columns that it newly covers.
+//
+static void R_ExtendPlane(visplane_t* pl, int start, int stop) {
+    if (pl->minx > pl->maxx) {
+        R_ClearPlaneColumns(pl, start, stop);
+        pl->minx = start;
+        pl->maxx = stop;
+        return;
+    }
+    if (start < pl->minx) {
+        R_ClearPlaneColumns(pl, start, pl->minx - 1);
+        pl->minx = start;
+    }
+    if (stop > pl->maxx) {
+        R_ClearPlaneColumns(pl, pl->maxx + 1, stop);
+        pl->maxx = stop;
+    }
+}
+
 //
 // Tries to find the first and oldest compatible visplane with
 // given height, texture and light level.
 //
 static visplane_t* R_FindCompatiblePlane(fixed_t height, int picnum, int lightlevel) {
-    for (visplane_t* pl = visplanes; pl < lastvisplane; pl++) {
+    unsigned hash = VISPLANEHASH(height, picnum, lightlevel);
+    for (visplane_t* pl = visplanehash[hash]; pl != NULL; pl = pl->next) {
         if (height == pl->height && picnum == pl->picnum && lightlevel == pl->lightlevel) {
             return pl;
         }
@@ -141,7 +357,7 @@ static bool R_IsPlaneRangeClear(const visplane_t* pl, int start, int stop) {
     int intrl = (pl->minx > start) ? pl->minx : start;
     int intrh = (pl->maxx < stop) ? pl->maxx : stop;
     for (int x = intrl; x <= intrh; x++) {
-        if (pl->top[x] != 0xff) {
+        if (pl->top[x] != VISPLANE_EMPTY) {
             // Column already used at position X; cannot reuse this plane.
             return false;
         }
@@ -164,18 +380,39 @@ static bool R_IsPlaneRangeClear(const visplane_t* pl, int start, int stop) {
 visplane_t* R_GetPlane(visplane_t* pl, int start, int stop) {
     if (R_IsPlaneRangeClear(pl, start, stop)) {
         // Use the same one.
-        pl->minx = (start < pl->minx) ? start : pl->minx;
-        pl->maxx = (stop > pl->maxx) ? stop : pl->maxx;
+        R_ExtendPlane(pl, start, stop);
         return pl;
     }
     // Make a new visplane.
     visplane_t* new_plane = R_NewVisplane(pl->height, pl->picnum, pl->lightlevel);
-    new_plane->minx = start;
-    new_plane->maxx = stop;
+    R_ExtendPlane(new_plane, start, stop);
     return new_plane;
 }
 
 
+//
+// R_UpdatePlaneTables
+// The per-row slope and per-column distance scale only change with the
+// view size and detail level.
+//
+void R_UpdatePlaneTables(void) {
+    int scaled_width = viewwidth << detailshift;
+    fixed_t proj_plane_dist = scaled_width/2 * FRACUNIT;
+
+    for (int y = 0; y < viewheight; y++) {
+        fixed_t dy = ((y - centery) << FRACBITS) + FRACUNIT/2;
+        dy = abs(dy);
+        yslope[y] = FixedDiv(proj_plane_dist, dy);
+    }
+
+    // Length along the view ray through each column, relative to the
+    // distance straight ahead.
+    for (int x = 0; x < viewwidth; x++) {
+        fixed_t cosadj = abs(COS(xtoviewangle[x]));
+        distscale[x] = FixedDiv(FRACUNIT, cosadj);
+    }
+}
+
 static void R_SetColorMap(fixed_t distance) {
     if (fixedcolormap) {
         ds_colormap = fixedcolormap;
@@ -190,71 +427,72 @@ static void R_SetColorMap(fixed_t distance) {
 }
 
 static void R_SetTextureCoordinates(int x1, fixed_t distance) {
-    angle_t x1_angle = xtoviewangle[x1];
-
     // Calculate length: the hypotenuse with respect to the virtual screen
-    fixed_t cosadj = abs(COS(x1_angle));
-    fixed_t distance_scale = FixedDiv(FRACUNIT, cosadj);
-    fixed_t length = FixedMul(distance, distance_scale);
+    fixed_t length = FixedMul(distance, distscale[x1]);
 
-    angle_t angle = viewangle + x1_angle;
+    angle_t angle = viewangle + xtoviewangle[x1];
 
     ds_xfrac = viewx + FixedMul(COS(angle), length);
     ds_yfrac = -viewy - FixedMul(SIN(angle), length);
 }
 
-static void R_SetTextureSteps(fixed_t distance) {
-    // left to right mapping
-    angle_t angle = viewangle - ANG90;
-
-    // scale will be unit scale at SCREENWIDTH/2 distance
-    fixed_t base_x_scale = FixedDiv(COS(angle), centerxfrac);
-    fixed_t base_y_scale = -FixedDiv(SIN(angle), centerxfrac);
-
-    ds_xstep = FixedMul(distance, base_x_scale);
-    ds_ystep = FixedMul(distance, base_y_scale);
+//
+// Distance and steps for row y at the current plane height, computed
+// once per frame for each height a row is drawn at.
+//
+static fixed_t R_CachePlaneRow(int y) {
+    if (cachedheight[y] != planeheight) {
+        cachedheight[y] = planeheight;
+        cacheddistance[y] = FixedMul(planeheight, yslope[y]);
+        cachedxstep[y] = FixedMul(cacheddistance[y], basexscale);
+        cachedystep[y] = FixedMul(cacheddistance[y], baseyscale);
+    }
+    ds_xstep = cachedxstep[y];
+    ds_ystep = cachedystep[y];
+    return cacheddistance[y];
 }
 
-static void R_SetTextureRenderParams(int y, int x1, int x2, fixed_t distance) {
-    R_SetTextureSteps(distance);
+static void R_DrawPlane(int y, int x1, int x2) {
+    fixed_t distance = R_CachePlaneRow(y);
     R_SetTextureCoordinates(x1, distance);
+    R_SetColorMap(distance);
 
     ds_y = y;
     ds_x1 = x1;
     ds_x2 = x2;
-}
-
-static fixed_t R_CalculatePlaneDistance(int y) {
-    fixed_t dy = ((y - centery) << FRACBITS) + FRACUNIT/2;
-    dy = abs(dy);
-
-    int scaled_width = viewwidth << detailshift;
-    fixed_t proj_plane_dist = scaled_width/2 * FRACUNIT;
-
-    fixed_t slope = FixedDiv(proj_plane_dist, dy);
-
-    return FixedMul(planeheight, slope);
-}
-
-static void R_DrawPlane(int y, int x1, int x2) {
-    fixed_t distance = R_CalculatePlaneDistance(y);
-    R_SetTextureRenderParams(y, x1, x2, distance);
-    R_SetColorMap(distance);
 
     // high or low detail
     spanfunc();
 }
 
+//
+// Queue a span of the current flat to be drawn by R_DrawFlatSpans.
+//
+static void R_AddSpan(int y, int x1, int x2) {
+    if (num_planespans == max_planespans) {
+        planespan_t* spans =
+            Z_Malloc(max_planespans * 2 * (int) sizeof(*spans), PU_STATIC, NULL);
+        memcpy(spans, planespans, max_planespans * sizeof(*spans));
+        Z_Free(planespans);
+        planespans = spans;
+        max_planespans *= 2;
+    }
+    planespan_t* span = &planespans[num_planespans++];
+    span->y = (short) y;
+    span->x1 = (short) x1;
+    span->x2 = (short) x2;
+}
+
 //
 // R_MakeSpans
 //
 static void R_MakeSpans(int x, int t1, int b1, int t2, int b2) {
     while (t1 < t2 && t1 <= b1) {
-        R_DrawPlane(t1, spanstart[t1], x - 1);
+        R_AddSpan(t1, spanstart[t1], x - 1);
         t1++;
     }
     while (b1 > b2 && b1 >= t1) {
-        R_DrawPlane(b1, spanstart[b1], x - 1);
+        R_AddSpan(b1, spanstart[b1], x - 1);
         b1--;
     }
 
@@ -268,7 +506,7 @@ static void R_MakeSpans(int x, int t1, int b1, int t2, int b2) {
     }
 }
 
-static void R_SetPlaneLighting(const visplane_t* pl) {
+static lighttable_t** R_GetPlaneLighting(const visplane_t* pl) {
     int light = (pl->lightlevel >> LIGHTSEGSHIFT) + extralight;
     if (light >= LIGHTLEVELS) {
         light = LIGHTLEVELS - 1;
@@ -277,25 +515,21 @@ static void R_SetPlaneLighting(const visplane_t* pl) {
         light = 0;
     }
 
-    planezlight = zlight[light];
-}
-
-static void R_SetPlaneHeight(const visplane_t* pl) {
-    planeheight = abs(pl->height - viewz);
+    return zlight[light];
 }
 
-static void R_SetPlaneTexture(int lumpnum) {
-    ds_source = W_CacheLumpNum(lumpnum, PU_STATIC);
-}
-
-static void R_DrawFlat(visplane_t* pl) {
-    int plane_tex = firstflat + flattranslation[pl->picnum];
-    R_SetPlaneTexture(plane_tex);
-    R_SetPlaneHeight(pl);
-    R_SetPlaneLighting(pl);
+//
+// Turn the columns of a visplane into spans, queued to be drawn along
+// with the other planes of the same flat.
+//
+static void R_CollectFlatSpans(visplane_t* pl, flatplane_t* fp) {
+    fp->lumpnum = firstflat + flattranslation[pl->picnum];
+    fp->height = abs(pl->height - viewz);
+    fp->zlight = R_GetPlaneLighting(pl);
+    fp->firstspan = num_planespans;
 
-    pl->top[pl->maxx + 1] = 0xff;
-    pl->top[pl->minx - 1] = 0xff;
+    pl->top[pl->maxx + 1] = VISPLANE_EMPTY;
+    pl->top[pl->minx - 1] = VISPLANE_EMPTY;
 
     for (int x = pl->minx; x <= pl->maxx + 1; x++) {
         int t1 = pl->top[x - 1];
@@ -309,18 +543,50 @@ static void R_DrawFlat(visplane_t* pl) {
         R_MakeSpans(x, t1, b1, t2, b2);
     }
 
-    W_ReleaseLumpNum(plane_tex);
+    fp->numspans = num_planespans - fp->firstspan;
 }
 
-static void R_CheckOverflow() {
-    if (ds_p - drawsegs > MAXDRAWSEGS) {
-        I_Error("R_CheckOverflow: drawsegs overflow (%td)", ds_p - drawsegs);
+//
+// Order planes by flat, keeping planes of the same flat in the order
+// they were collected.
+//
+static int R_CompareFlatPlanes(const void* a, const void* b) {
+    const flatplane_t* fa = a;
+    const flatplane_t* fb = b;
+    if (fa->lumpnum != fb->lumpnum) {
+        return (fa->lumpnum < fb->lumpnum) ? -1 : 1;
     }
-    if (lastvisplane - visplanes > MAXVISPLANES) {
-        I_Error("R_CheckOverflow: visplane overflow (%td)", lastvisplane - visplanes);
+    return fa->firstspan - fb->firstspan;
+}
+
+//
+// Draw the queued spans one flat at a time, so each flat is only
+// looked up once and stays in the cache while its spans are drawn.
+// Visplanes never overlap on screen, so the order does not matter.
+//
+static void R_DrawFlatSpans(flatplane_t* fps, int count) {
+    qsort(fps, count, sizeof(*fps), R_CompareFlatPlanes);
+
+    int lumpnum = -1;
+    for (int i = 0; i < count; i++) {
+        const flatplane_t* fp = &fps[i];
+        if (fp->lumpnum != lumpnum) {
+            if (lumpnum != -1) {
+                W_ReleaseLumpNum(lumpnum);
+            }
+            lumpnum = fp->lumpnum;
+            ds_source = W_CacheLumpNum(lumpnum, PU_STATIC);
+        }
+        planeheight = fp->height;
+        planezlight = fp->zlight;
+
+        const planespan_t* span = &planespans[fp->firstspan];
+        for (int j = 0; j < fp->numspans; j++, span++) {
+            R_DrawPlane(span->y, span->x1, span->x2);
+        }
     }
-    if (lastopening - openings > MAXOPENINGS) {
-        I_Error("R_CheckOverflow: opening overflow (%td)", lastopening - openings);
+    if (lumpnum != -1) {
+        W_ReleaseLumpNum(lumpnum);
     }
 }
 
@@ -329,9 +595,18 @@ static void R_CheckOverflow() {
 // At the end of each frame.
 //
 void R_DrawPlanes() {
-    R_CheckOverflow();
+    int num_flatplanes = 0;
+    num_planespans = 0;
+
+    if (max_flatplanes < num_visplanes) {
+        Z_Free(flatplanes);
+        max_flatplanes = max_visplanes;
+        flatplanes = Z_Malloc(max_flatplanes * (int) sizeof(*flatplanes),
+                              PU_STATIC, NULL);
+    }
 
-    for (visplane_t* pl = visplanes; pl < lastvisplane; pl++) {
+    for (int i = 0; i < num_visplanes; i++) {
+        visplane_t* pl = visplanes[i];
 	if (pl->minx > pl->maxx) {
             continue;
         }
@@ -340,7 +615,9 @@ void R_DrawPlanes() {
             R_DrawSky(pl);
 	} else {
             // Regular flat.
-            R_DrawFlat(pl);
+            R_CollectFlatSpans(pl, &flatplanes[num_flatplanes++]);
         }
     }
+
+    R_DrawFlatSpans(flatplanes, num_flatplanes);
 }
@@ -25,13 +25,14 @@
 
 
 // Visplane related.
-extern short *lastopening;
-
-extern short floorclip[SCREENWIDTH];
-extern short ceilingclip[SCREENWIDTH];
+extern short* floorclip;
+extern short* ceilingclip;
 
+void R_InitPlanes(void);
+void R_UpdatePlaneTables(void);
 void R_ClearPlanes(void);
 void R_DrawPlanes(void);
+short* R_AllocOpenings(int count);
 visplane_t* R_FindPlane(fixed_t height, int picnum, int lightlevel);
 visplane_t* R_GetPlane(visplane_t* pl, int start, int stop);
 
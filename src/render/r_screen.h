@@ -21,7 +21,7 @@
 #define __R_SCREEN__
 
 // status bar height at bottom of screen
-#define SBARHEIGHT 32
+#define SBARHEIGHT (32 * render_scale)
 
 void R_DrawPixel(int x, int y, pixel_t color);
 pixel_t R_GetPixel(int x, int y);
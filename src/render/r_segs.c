@@ -103,7 +103,7 @@ static void R_CalculateMaskedColumnColormap() {
         dc_colormap = fixedcolormap;
         return;
     }
-    unsigned int index = spryscale >> LIGHTSCALESHIFT;
+    unsigned int index = (spryscale / render_scale) >> LIGHTSCALESHIFT;
     if (index >=  MAXLIGHTSCALE) {
         index = MAXLIGHTSCALE - 1;
     }
@@ -276,7 +276,7 @@ static void R_RenderMidTexture(int x, int yl, int yh, fixed_t tex_col) {
 // calculate lighting
 //
 static void R_CalculateColormap(fixed_t scale) {
-    unsigned index = scale >> LIGHTSCALESHIFT;
+    unsigned index = (scale / render_scale) >> LIGHTSCALESHIFT;
     if (index >= MAXLIGHTSCALE) {
         index = MAXLIGHTSCALE - 1;
     }
@@ -333,8 +333,8 @@ static void R_MarkFloorPlane(int x, int yh) {
     }
 
     if (top <= bottom) {
-        floorplane->top[x] = (byte) top;
-        floorplane->bottom[x] = (byte) bottom;
+        floorplane->top[x] = (unsigned short) top;
+        floorplane->bottom[x] = (unsigned short) bottom;
     }
 }
 
@@ -346,8 +346,8 @@ static void R_MarkCeilingPlane(int x, int yl) {
     }
 
     if (top <= bottom) {
-        ceilingplane->top[x] = (byte) top;
-        ceilingplane->bottom[x] = (byte) bottom;
+        ceilingplane->top[x] = (unsigned short) top;
+        ceilingplane->bottom[x] = (unsigned short) bottom;
     }
 }
 
@@ -405,11 +405,15 @@ static void R_RenderSegment() {
 }
 
 
-static void R_UpdateOpening(int start_x, const short clip[SCREENWIDTH]) {
+//
+// Copy the clip columns from start_x to rw_stopx into new openings,
+// returning them offset so they can be indexed by screen column.
+//
+static short* R_UpdateOpening(int start_x, const short* clip) {
     int dx = rw_stopx - start_x;
-    size_t size = dx * sizeof(*lastopening);
-    memcpy(lastopening, &clip[start_x], size);
-    lastopening += dx;
+    short* opening = R_AllocOpenings(dx);
+    memcpy(opening, &clip[start_x], dx * sizeof(*opening));
+    return opening - start_x;
 }
 
 static void R_SetSpriteBottomSilhouetteClip(int start_x) {
@@ -422,8 +426,7 @@ static void R_SetSpriteBottomSilhouetteClip(int start_x) {
         return;
     }
     if ((ds_p->silhouette & SIL_BOTTOM) || maskedtexture) {
-        ds_p->sprbottomclip = lastopening - start_x;
-        R_UpdateOpening(start_x, floorclip);
+        ds_p->sprbottomclip = R_UpdateOpening(start_x, floorclip);
         return;
     }
     ds_p->sprbottomclip = NULL;
@@ -439,8 +442,7 @@ static void R_SetSpriteTopSilhouetteClip(int start_x) {
         return;
     }
     if ((ds_p->silhouette & SIL_TOP) || maskedtexture) {
-        ds_p->sprtopclip = lastopening - start_x;
-        R_UpdateOpening(start_x, ceilingclip);
+        ds_p->sprtopclip = R_UpdateOpening(start_x, ceilingclip);
         return;
     }
     ds_p->sprtopclip = NULL;
@@ -742,8 +744,7 @@ static void R_CalculateTextureTwoSide() {
     if (sidedef->midtexture) {
         // masked midtexture
         maskedtexture = true;
-        maskedtexturecol = lastopening - rw_x;
-        lastopening += rw_stopx - rw_x;
+        maskedtexturecol = R_AllocOpenings(rw_stopx - rw_x) - rw_x;
     }
 }
 
@@ -829,10 +830,13 @@ static void R_PrepareSegmentRender(int start, int stop) {
 // A wall segment will be drawn between start and stop pixels (inclusive).
 //
 void R_RenderWallRange(int start, int stop) {
-    if (ds_p == &drawsegs[MAXDRAWSEGS]) {
-        // Can't save more sprite clipping info.
-        // Don't overflow and crash.
-        return;
+    if (ds_p == &drawsegs[maxdrawsegs]) {
+        if (vanilla_render_limits) {
+            // Can't save more sprite clipping info.
+            // Don't overflow and crash.
+            return;
+        }
+        R_GrowDrawSegs();
     }
     if (start >= viewwidth || start > stop) {
         I_Error("Bad R_RenderWallRange: %i to %i", start , stop);
@@ -62,5 +62,5 @@ void R_DrawSky(const visplane_t* pl) {
 // Called whenever the view size changes.
 //
 void R_InitSkyMap() {
-    sky_tex_mid = (SCREENHEIGHT / 2) * FRACUNIT;
+    sky_tex_mid = (ORIGHEIGHT / 2) * FRACUNIT;
 }
@@ -100,7 +100,7 @@ extern player_t* viewplayer;
 extern angle_t clipangle;
 
 extern int viewangletox[FINEANGLES / 2];
-extern angle_t xtoviewangle[SCREENWIDTH + 1];
+extern angle_t* xtoviewangle;
 
 extern fixed_t rw_distance;
 extern angle_t rw_normalangle;
@@ -29,7 +29,7 @@
 
 
 #define MINZ        (FRACUNIT * 4)
-#define BASEYCENTER (SCREENHEIGHT / 2)
+#define BASEYCENTER (ORIGHEIGHT / 2)
 
 
 //
@@ -44,8 +44,8 @@ fixed_t pspriteiscale;
 static lighttable_t** spritelights;
 
 // constant arrays used for psprite clipping and initializing clipping
-short negonearray[SCREENWIDTH];
-short screenheightarray[SCREENWIDTH];
+short* negonearray;
+short* screenheightarray;
 
 
 //
@@ -257,12 +257,22 @@ static void R_InitSpriteDefs(const char **namelist) {
 static vissprite_t vissprites[MAXVISSPRITES];
 static vissprite_t* vissprite_p;
 
+// per column sprite clipping, filled in by R_DrawSprite
+static short* clipbot;
+static short* cliptop;
+
 
 //
 // R_InitSprites
 // Called at program start.
 //
 void R_InitSprites(const char** namelist) {
+    size_t size = SCREENWIDTH * sizeof(short);
+    negonearray = Z_Malloc((int) size, PU_STATIC, NULL);
+    screenheightarray = Z_Malloc((int) size, PU_STATIC, NULL);
+    clipbot = Z_Malloc((int) size, PU_STATIC, NULL);
+    cliptop = Z_Malloc((int) size, PU_STATIC, NULL);
+
     for (int i = 0; i < SCREENWIDTH; i++) {
 	negonearray[i] = -1;
     }
@@ -440,7 +450,7 @@ static lighttable_t* R_CalculateVisibleSpriteColorMap(const mobj_t* thing,
         return colormaps;
     }
     // diminished light
-    int index = xscale >> (LIGHTSCALESHIFT - detailshift);
+    int index = (xscale / render_scale) >> (LIGHTSCALESHIFT - detailshift);
     if (index >= MAXLIGHTSCALE) {
         index = MAXLIGHTSCALE - 1;
     }
@@ -665,7 +675,7 @@ static void R_CalculatePlayerSpriteEdges(vissprite_t* vis,
     const spriteframe_t* sprframe = R_GetPlayerSpriteFrame(plr_sprite);
     int lump = sprframe->lump[PLAYER_SPRITE_ANGLE];
 
-    fixed_t tx = plr_sprite->sx - (SCREENWIDTH/2)*FRACUNIT;
+    fixed_t tx = plr_sprite->sx - (ORIGWIDTH/2)*FRACUNIT;
     tx -= spriteoffset[lump];
     vis->x1 = (centerxfrac + FixedMul(tx,pspritescale)) >> FRACBITS;
 
@@ -721,9 +731,6 @@ static void R_SetPlayerSpriteScreenBounds() {
     mceilingclip = negonearray;
 }
 
-static short clipbot[SCREENWIDTH];
-static short cliptop[SCREENWIDTH];
-
 static void R_SetThingSpriteScreenBounds() {
     mfloorclip = clipbot;
     mceilingclip = cliptop;
@@ -22,8 +22,8 @@
 
 
 // Constant arrays used for psprite clipping and initializing clipping.
-extern short negonearray[SCREENWIDTH];
-extern short screenheightarray[SCREENWIDTH];
+extern short* negonearray;
+extern short* screenheightarray;
 
 // vars for R_DrawMaskedColumn
 extern short* mfloorclip;
@@ -0,0 +1,196 @@
+//
+// Copyright(C) 1993-1996 Id Software, Inc.
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	Demo keyframe index.
+//
+//	The index file starts with a header identifying the demo it was
+//	built from, followed by one record per keyframe:
+//
+//	    header: magic[8] version demo_length demo_sha1[20]
+//	    record: tic gametic demo_offset episode map size data[size]
+//
+//	All integers are 32-bit little endian. The snapshot data is
+//	written by P_ArchiveKeyframe.
+//
+
+
+#include <stdio.h>
+#include <string.h>
+
+#include "d_loop.h"
+#include "i_system.h"
+#include "m_misc.h"
+#include "sha1.h"
+#include "doomstat.h"
+#include "p_saveg.h"
+#include "p_keyframe.h"
+
+#define KEYFRAME_MAGIC   "BRMKEYFR"
+#define KEYFRAME_VERSION 2
+
+// The record header fields before the snapshot data.
+#define RECORD_FIELDS 6
+
+static FILE* index_stream;
+
+
+static void P_WriteIndexInt(int value) {
+    byte buf[4] = {
+        value & 0xff,
+        (value >> 8) & 0xff,
+        (value >> 16) & 0xff,
+        (value >> 24) & 0xff
+    };
+    fwrite(buf, 1, sizeof(buf), index_stream);
+}
+
+static bool P_ReadIndexInt(int* value) {
+    byte buf[4];
+    if (fread(buf, 1, sizeof(buf), index_stream) < sizeof(buf)) {
+        return false;
+    }
+    *value = buf[0] | (buf[1] << 8) | (buf[2] << 16) | (buf[3] << 24);
+    return true;
+}
+
+static void P_DemoDigest(sha1_digest_t digest, byte* demo, int length) {
+    sha1_context_t context;
+    SHA1_Init(&context);
+    SHA1_Update(&context, demo, length);
+    SHA1_Final(digest, &context);
+}
+
+bool P_CreateKeyframeIndex(const char* filename, byte* demo, int length) {
+    index_stream = M_fopen(filename, "wb+");
+    if (index_stream == NULL) {
+        return false;
+    }
+
+    sha1_digest_t digest;
+    P_DemoDigest(digest, demo, length);
+
+    fwrite(KEYFRAME_MAGIC, 1, 8, index_stream);
+    P_WriteIndexInt(KEYFRAME_VERSION);
+    P_WriteIndexInt(length);
+    fwrite(digest, 1, sizeof(digest), index_stream);
+
+    return true;
+}
+
+void P_WriteKeyframe(int tic, int demo_offset) {
+    P_WriteIndexInt(tic);
+    P_WriteIndexInt(gametic);
+    P_WriteIndexInt(demo_offset);
+    P_WriteIndexInt(gameepisode);
+    P_WriteIndexInt(gamemap);
+
+    // The size is filled in once the snapshot has been written.
+    long size_position = ftell(index_stream);
+    P_WriteIndexInt(0);
+
+    save_stream = index_stream;
+    savegame_error = false;
+    P_ArchiveKeyframe();
+    if (savegame_error) {
+        I_Error("P_WriteKeyframe: Error while writing keyframe at tic %i",
+                tic);
+    }
+
+    long end_position = ftell(index_stream);
+    fseek(index_stream, size_position, SEEK_SET);
+    P_WriteIndexInt((int) (end_position - size_position - 4));
+    fseek(index_stream, end_position, SEEK_SET);
+}
+
+bool P_OpenKeyframeIndex(const char* filename, byte* demo, int length) {
+    index_stream = M_fopen(filename, "rb");
+    if (index_stream == NULL) {
+        return false;
+    }
+
+    char magic[8];
+    int version;
+    int demo_length;
+    sha1_digest_t digest;
+    sha1_digest_t demo_digest;
+
+    if (fread(magic, 1, sizeof(magic), index_stream) < sizeof(magic)
+        || memcmp(magic, KEYFRAME_MAGIC, sizeof(magic)) != 0
+        || !P_ReadIndexInt(&version) || version != KEYFRAME_VERSION
+        || !P_ReadIndexInt(&demo_length) || demo_length != length
+        || fread(digest, 1, sizeof(digest), index_stream) < sizeof(digest)) {
+        P_CloseKeyframeIndex();
+        return false;
+    }
+
+    P_DemoDigest(demo_digest, demo, length);
+    if (memcmp(digest, demo_digest, sizeof(digest)) != 0) {
+        P_CloseKeyframeIndex();
+        return false;
+    }
+
+    return true;
+}
+
+//
+// A_Tracer only acts every fourth gametic, so a keyframe can only be
+// restored when gametic has the same phase it had when it was taken.
+//
+bool P_FindKeyframe(int tic, keyframe_t* keyframe) {
+    bool found = false;
+
+    while (true) {
+        int fields[RECORD_FIELDS];
+        for (int i = 0; i < RECORD_FIELDS; i++) {
+            if (!P_ReadIndexInt(&fields[i])) {
+                return found;
+            }
+        }
+        long position = ftell(index_stream);
+
+        if (fields[0] > tic) {
+            // Keyframes are stored in increasing tic order.
+            return found;
+        }
+        if ((fields[1] & 3) == (gametic & 3)) {
+            keyframe->tic = fields[0];
+            keyframe->gametic = fields[1];
+            keyframe->demo_offset = fields[2];
+            keyframe->episode = fields[3];
+            keyframe->map = fields[4];
+            keyframe->position = position;
+            found = true;
+        }
+        if (fseek(index_stream, position + fields[5], SEEK_SET) != 0) {
+            return found;
+        }
+    }
+}
+
+bool P_ReadKeyframe(const keyframe_t* keyframe) {
+    if (fseek(index_stream, keyframe->position, SEEK_SET) != 0) {
+        return false;
+    }
+    save_stream = index_stream;
+    savegame_error = false;
+    return P_UnArchiveKeyframe();
+}
+
+void P_CloseKeyframeIndex() {
+    if (index_stream != NULL) {
+        fclose(index_stream);
+        index_stream = NULL;
+    }
+}
@@ -0,0 +1,64 @@
+//
+// Copyright(C) 1993-1996 Id Software, Inc.
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	Demo keyframe index: a sidecar file of play simulation
+//	snapshots, taken at fixed intervals while playing back a demo,
+//	used to seek within the demo.
+//
+
+
+#ifndef __P_KEYFRAME__
+#define __P_KEYFRAME__
+
+#include "doomtype.h"
+
+typedef struct
+{
+    // Number of demo tics read before the keyframe was taken.
+    int tic;
+
+    // Value of gametic when the keyframe was taken.
+    int gametic;
+
+    // Offset of the next ticcmd in the demo lump.
+    int demo_offset;
+
+    // Level the keyframe was taken on.
+    int episode;
+    int map;
+
+    // Position of the snapshot in the index file.
+    long position;
+} keyframe_t;
+
+// Create a new index for the given demo, replacing any existing one.
+bool P_CreateKeyframeIndex(const char *filename, byte *demo, int length);
+
+// Append a snapshot of the current level to the index being created.
+void P_WriteKeyframe(int tic, int demo_offset);
+
+// Open an existing index. Fails if it was built from another demo.
+bool P_OpenKeyframeIndex(const char *filename, byte *demo, int length);
+
+// Find the latest keyframe at or before the given demo tic that can
+// be restored while gametic has its current value.
+bool P_FindKeyframe(int tic, keyframe_t *keyframe);
+
+// Restore a keyframe. Its level must already be loaded.
+bool P_ReadKeyframe(const keyframe_t *keyframe);
+
+void P_CloseKeyframeIndex(void);
+
+#endif
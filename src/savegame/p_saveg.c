@@ -24,6 +24,7 @@
 #include "deh_str.h"
 #include "i_system.h"
 #include "z_zone.h"
+#include "a_enemy.h"
 #include "p_local.h"
 #include "p_saveg.h"
 #include "p_ceiling.h"
@@ -31,11 +32,16 @@
 #include "p_floor.h"
 #include "p_doors.h"
 #include "p_lights.h"
+#include "p_spec.h"
+#include "p_switch.h"
+#include "m_random.h"
 
 // State.
 #include "doomstat.h"
 #include "g_game.h"
 #include "m_misc.h"
+#include "r_main.h"
+#include "r_sky.h"
 #include "r_state.h"
 
 FILE* save_stream;
@@ -1487,7 +1493,7 @@ void P_ArchiveThinkers() {
 static void P_UnArchiveMobj() {
     saveg_read_pad();
 
-    mobj_t* mobj = Z_Malloc(sizeof(*mobj), PU_LEVEL, NULL);
+    mobj_t* mobj = P_AllocThinker(tt_mobj, sizeof(*mobj));
     saveg_read_mobj_t(mobj);
 
     mobj->target = NULL;
@@ -1511,7 +1517,7 @@ static void P_ResetThinkers() {
         if (curr_thinker->function.acp1 == (actionf_p1) P_MobjThinker) {
             P_RemoveMobj((mobj_t*) curr_thinker);
         } else {
-            Z_Free(curr_thinker);
+            P_DeallocThinker(curr_thinker);
         }
         curr_thinker = next;
     }
@@ -1644,7 +1650,7 @@ void P_ArchiveSpecials(void) {
 
 static void P_UnArchiveGlowLight() {
     saveg_read_pad();
-    glow_t* glow = Z_Malloc(sizeof(*glow), PU_LEVEL, NULL);
+    glow_t* glow = P_AllocThinker(tt_glow, sizeof(*glow));
     saveg_read_glow_t(glow);
     glow->thinker.function.acp1 = (actionf_p1) T_Glow;
     P_AddThinker(&glow->thinker);
@@ -1652,7 +1658,7 @@ static void P_UnArchiveGlowLight() {
 
 static void P_UnArchiveStrobeLight() {
     saveg_read_pad();
-    strobe_t* strobe = Z_Malloc(sizeof(*strobe), PU_LEVEL, NULL);
+    strobe_t* strobe = P_AllocThinker(tt_strobe, sizeof(*strobe));
     saveg_read_strobe_t(strobe);
     strobe->thinker.function.acp1 = (actionf_p1) T_StrobeFlash;
     P_AddThinker(&strobe->thinker);
@@ -1660,7 +1666,7 @@ static void P_UnArchiveStrobeLight() {
 
 static void P_UnArchiveFlashLight() {
     saveg_read_pad();
-    lightflash_t* flash = Z_Malloc(sizeof(*flash), PU_LEVEL, NULL);
+    lightflash_t* flash = P_AllocThinker(tt_flash, sizeof(*flash));
     saveg_read_lightflash_t(flash);
     flash->thinker.function.acp1 = (actionf_p1) T_LightFlash;
     P_AddThinker(&flash->thinker);
@@ -1668,7 +1674,7 @@ static void P_UnArchiveFlashLight() {
 
 static void P_UnArchivePlatform() {
     saveg_read_pad();
-    plat_t* plat = Z_Malloc(sizeof(*plat), PU_LEVEL, NULL);
+    plat_t* plat = P_AllocThinker(tt_plat, sizeof(*plat));
     saveg_read_plat_t(plat);
     plat->sector->specialdata = plat;
     if (plat->thinker.function.acp1) {
@@ -1680,7 +1686,7 @@ static void P_UnArchivePlatform() {
 
 static void P_UnArchiveFloor() {
     saveg_read_pad();
-    floormove_t* floor = Z_Malloc(sizeof(*floor), PU_LEVEL, NULL);
+    floormove_t* floor = P_AllocThinker(tt_floor, sizeof(*floor));
     saveg_read_floormove_t(floor);
     floor->sector->specialdata = floor;
     floor->thinker.function.acp1 = (actionf_p1) T_MoveFloor;
@@ -1689,7 +1695,7 @@ static void P_UnArchiveFloor() {
 
 static void P_UnArchiveDoor() {
     saveg_read_pad();
-    vldoor_t* door = Z_Malloc(sizeof(*door), PU_LEVEL, NULL);
+    vldoor_t* door = P_AllocThinker(tt_door, sizeof(*door));
     saveg_read_vldoor_t(door);
     door->sector->specialdata = door;
     door->thinker.function.acp1 = (actionf_p1) T_VerticalDoor;
@@ -1698,7 +1704,7 @@ static void P_UnArchiveDoor() {
 
 static void P_UnArchiveCeiling() {
     saveg_read_pad();
-    ceiling_t* ceiling = Z_Malloc(sizeof(*ceiling), PU_LEVEL, NULL);
+    ceiling_t* ceiling = P_AllocThinker(tt_ceiling, sizeof(*ceiling));
     saveg_read_ceiling_t(ceiling);
     ceiling->sector->specialdata = ceiling;
     if (ceiling->thinker.function.acp1) {
@@ -1746,3 +1752,799 @@ void P_UnArchiveSpecials() {
         }
     }
 }
+
+
+//
+// fireflicker_t
+//
+
+static void saveg_read_fireflicker_t(fireflicker_t* str) {
+    // thinker_t thinker;
+    saveg_read_thinker_t(&str->thinker);
+
+    // sector_t* sector;
+    int sector = saveg_read32();
+    str->sector = &sectors[sector];
+
+    // int count;
+    str->count = saveg_read32();
+
+    // int maxlight;
+    str->maxlight = saveg_read32();
+
+    // int minlight;
+    str->minlight = saveg_read32();
+}
+
+static void saveg_write_fireflicker_t(fireflicker_t* str) {
+    // thinker_t thinker;
+    saveg_write_thinker_t(&str->thinker);
+
+    // sector_t* sector;
+    saveg_write32(str->sector - sectors);
+
+    // int count;
+    saveg_write32(str->count);
+
+    // int maxlight;
+    saveg_write32(str->maxlight);
+
+    // int minlight;
+    saveg_write32(str->minlight);
+}
+
+
+//
+// DEMO KEYFRAMES
+//
+// A keyframe is written over the same stream as a savegame, but it must
+// restore the play simulation exactly so that demo playback can resume
+// from it without desyncing. Unlike savegames, keyframes keep thinkers
+// in their original order (mobjs and specials interleaved), keep every
+// mobj reference (targets, tracers, sound targets...), keep the order
+// of the sector and blockmap thing lists and store full precision
+// heights and offsets. Thinker references are written as 1-based
+// indexes into the serialized thinker list, 0 being NULL.
+//
+
+typedef enum {
+    kf_mobj,
+    kf_ceiling,
+    kf_door,
+    kf_floor,
+    kf_plat,
+    kf_flash,
+    kf_strobe,
+    kf_glow,
+    kf_fireflicker,
+    kf_none
+} keyframeclass_t;
+
+// Ceilings and platforms in stasis have no think function,
+// and removed thinkers wait in the list until their turn to be freed.
+typedef enum {
+    kf_thinking,
+    kf_stasis,
+    kf_removed
+} keyframestate_t;
+
+#define KEYFRAME_EOF 0x4b
+
+typedef struct {
+    thinker_t* thinker;
+    int index;
+} kf_lookup_t;
+
+// Serialized thinkers, in thinker list order.
+static thinker_t** kf_thinkers;
+static int kf_numthinkers;
+
+// Serialized thinkers sorted by address, to find their indexes.
+static kf_lookup_t* kf_lookup;
+
+
+static int P_CompareKeyframeLookup(const void* a, const void* b) {
+    uintptr_t ta = (uintptr_t) ((const kf_lookup_t*) a)->thinker;
+    uintptr_t tb = (uintptr_t) ((const kf_lookup_t*) b)->thinker;
+    return (ta > tb) - (ta < tb);
+}
+
+//
+// Returns the 1-based keyframe index of a thinker, or 0 if it is NULL
+// or was not serialized.
+//
+static int P_KeyframeIndex(const void* thinker) {
+    if (thinker == NULL) {
+        return 0;
+    }
+    kf_lookup_t key = {(thinker_t*) thinker, 0};
+    kf_lookup_t* found = bsearch(&key, kf_lookup, kf_numthinkers,
+                                 sizeof(*kf_lookup), P_CompareKeyframeLookup);
+    return found ? found->index : 0;
+}
+
+static void* P_KeyframeThinker(int index) {
+    if (index <= 0 || index > kf_numthinkers) {
+        return NULL;
+    }
+    return kf_thinkers[index - 1];
+}
+
+static bool P_IsActiveCeiling(const thinker_t* th) {
+    for (int i = 0; i < MAXCEILINGS; i++) {
+        if (activeceilings[i] == (ceiling_t*) th) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool P_IsActivePlat(const thinker_t* th) {
+    for (int i = 0; i < MAXPLATS; i++) {
+        if (activeplats[i] == (plat_t*) th) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static keyframeclass_t P_KeyframeClass(const thinker_t* th) {
+    actionf_p1 func = th->function.acp1;
+
+    if (func == (actionf_p1) P_MobjThinker) {
+        return kf_mobj;
+    }
+    if (func == (actionf_p1) T_MoveCeiling) {
+        return kf_ceiling;
+    }
+    if (func == (actionf_p1) T_VerticalDoor) {
+        return kf_door;
+    }
+    if (func == (actionf_p1) T_MoveFloor) {
+        return kf_floor;
+    }
+    if (func == (actionf_p1) T_PlatRaise) {
+        return kf_plat;
+    }
+    if (func == (actionf_p1) T_LightFlash) {
+        return kf_flash;
+    }
+    if (func == (actionf_p1) T_StrobeFlash) {
+        return kf_strobe;
+    }
+    if (func == (actionf_p1) T_Glow) {
+        return kf_glow;
+    }
+    if (func == (actionf_p1) T_FireFlicker) {
+        return kf_fireflicker;
+    }
+    if (th->function.acv == (actionf_v) NULL) {
+        if (P_IsActiveCeiling(th)) {
+            return kf_ceiling;
+        }
+        if (P_IsActivePlat(th)) {
+            return kf_plat;
+        }
+    }
+    return kf_none;
+}
+
+static keyframestate_t P_KeyframeState(const thinker_t* th) {
+    if (P_IsThinkerRemoved((thinker_t*) th)) {
+        return kf_removed;
+    }
+    if (th->function.acv == (actionf_v) NULL) {
+        return kf_stasis;
+    }
+    return kf_thinking;
+}
+
+static void P_AllocKeyframeThinkers(int count) {
+    kf_numthinkers = 0;
+    kf_thinkers = Z_Malloc((count + 1) * sizeof(*kf_thinkers), PU_STATIC, NULL);
+    kf_lookup = Z_Malloc((count + 1) * sizeof(*kf_lookup), PU_STATIC, NULL);
+}
+
+static void P_FreeKeyframeThinkers() {
+    Z_Free(kf_thinkers);
+    Z_Free(kf_lookup);
+    kf_thinkers = NULL;
+    kf_lookup = NULL;
+    kf_numthinkers = 0;
+}
+
+static void P_SortKeyframeLookup() {
+    for (int i = 0; i < kf_numthinkers; i++) {
+        kf_lookup[i].thinker = kf_thinkers[i];
+        kf_lookup[i].index = i + 1;
+    }
+    qsort(kf_lookup, kf_numthinkers, sizeof(*kf_lookup),
+          P_CompareKeyframeLookup);
+}
+
+//
+// Removed mobjs are not freed until their thinking turn comes up, so
+// other mobjs may still point at them. Those are kept in the keyframe
+// so the references behave exactly as they did when recording.
+// byptr holds every thinker sorted by address, indexed into keep[].
+//
+static void P_MarkRemovedMobj(bool* keep, const kf_lookup_t* byptr, int count,
+                              const mobj_t* mobj) {
+    if (mobj == NULL || !P_IsThinkerRemoved((thinker_t*) &mobj->thinker)) {
+        return;
+    }
+    kf_lookup_t key = {(thinker_t*) &mobj->thinker, 0};
+    const kf_lookup_t* found = bsearch(&key, byptr, count, sizeof(*byptr),
+                                       P_CompareKeyframeLookup);
+    if (found != NULL) {
+        keep[found->index] = true;
+    }
+}
+
+static void P_CollectKeyframeThinkers() {
+    int count = 0;
+    for (thinker_t* th = thinkercap.next; th != &thinkercap; th = th->next) {
+        count++;
+    }
+
+    thinker_t** all = Z_Malloc((count + 1) * sizeof(*all), PU_STATIC, NULL);
+    bool* keep = Z_Malloc((count + 1) * sizeof(*keep), PU_STATIC, NULL);
+    int n = 0;
+    for (thinker_t* th = thinkercap.next; th != &thinkercap; th = th->next) {
+        all[n] = th;
+        keep[n] = P_KeyframeClass(th) != kf_none;
+        n++;
+    }
+
+    kf_lookup_t* byptr = Z_Malloc((count + 1) * sizeof(*byptr), PU_STATIC, NULL);
+    for (int i = 0; i < count; i++) {
+        byptr[i].thinker = all[i];
+        byptr[i].index = i;
+    }
+    qsort(byptr, count, sizeof(*byptr), P_CompareKeyframeLookup);
+
+    for (int i = 0; i < count; i++) {
+        if (keep[i] && P_KeyframeClass(all[i]) == kf_mobj) {
+            const mobj_t* mobj = (mobj_t*) all[i];
+            P_MarkRemovedMobj(keep, byptr, count, mobj->target);
+            P_MarkRemovedMobj(keep, byptr, count, mobj->tracer);
+        }
+    }
+    for (int i = 0; i < MAXPLAYERS; i++) {
+        P_MarkRemovedMobj(keep, byptr, count, players[i].attacker);
+    }
+    for (int i = 0; i < numsectors; i++) {
+        P_MarkRemovedMobj(keep, byptr, count, sectors[i].soundtarget);
+    }
+    Z_Free(byptr);
+
+    P_AllocKeyframeThinkers(count);
+    for (int i = 0; i < count; i++) {
+        if (keep[i]) {
+            kf_thinkers[kf_numthinkers++] = all[i];
+        }
+    }
+    P_SortKeyframeLookup();
+
+    Z_Free(all);
+    Z_Free(keep);
+}
+
+static void P_ArchiveKeyframeGlobals() {
+    int m_index;
+    int p_index;
+    M_GetRandomState(&m_index, &p_index);
+
+    saveg_write32(leveltime);
+    saveg_write32(m_index);
+    saveg_write32(p_index);
+    saveg_write32(validcount);
+    saveg_write32(totalkills);
+    saveg_write32(totalitems);
+    saveg_write32(totalsecret);
+    saveg_write32(sky_tex);
+    saveg_write32(levelTimer);
+    saveg_write32(levelTimeCount);
+    saveg_write32(paused);
+}
+
+static void P_UnArchiveKeyframeGlobals() {
+    leveltime = saveg_read32();
+    int m_index = saveg_read32();
+    int p_index = saveg_read32();
+    M_SetRandomState(m_index, p_index);
+    validcount = saveg_read32();
+    totalkills = saveg_read32();
+    totalitems = saveg_read32();
+    totalsecret = saveg_read32();
+    sky_tex = saveg_read32();
+    levelTimer = saveg_read32();
+    levelTimeCount = saveg_read32();
+    paused = saveg_read32();
+}
+
+static void P_ArchiveKeyframeWorld() {
+    for (int i = 0; i < numsectors; i++) {
+        const sector_t* sec = &sectors[i];
+        saveg_write32(sec->floorheight);
+        saveg_write32(sec->ceilingheight);
+        saveg_write16(sec->floorpic);
+        saveg_write16(sec->ceilingpic);
+        saveg_write16(sec->lightlevel);
+        saveg_write16(sec->special);
+        saveg_write16(sec->tag);
+        saveg_write32(sec->soundtraversed);
+        saveg_write32(P_KeyframeIndex(sec->soundtarget));
+        saveg_write32(P_KeyframeIndex(sec->specialdata));
+    }
+    for (int i = 0; i < numlines; i++) {
+        const line_t* li = &lines[i];
+        saveg_write16(li->flags);
+        saveg_write16(li->special);
+        saveg_write16(li->tag);
+    }
+    for (int i = 0; i < numsides; i++) {
+        const side_t* si = &sides[i];
+        saveg_write32(si->textureoffset);
+        saveg_write32(si->rowoffset);
+        saveg_write16(si->toptexture);
+        saveg_write16(si->bottomtexture);
+        saveg_write16(si->midtexture);
+    }
+}
+
+//
+// Sector references to thinkers are resolved once all thinkers are read.
+//
+static void P_UnArchiveKeyframeWorld(int* soundtargets, int* specialdata) {
+    for (int i = 0; i < numsectors; i++) {
+        sector_t* sec = &sectors[i];
+        sec->floorheight = saveg_read32();
+        sec->ceilingheight = saveg_read32();
+        sec->floorpic = saveg_read16();
+        sec->ceilingpic = saveg_read16();
+        sec->lightlevel = saveg_read16();
+        sec->special = saveg_read16();
+        sec->tag = saveg_read16();
+        sec->soundtraversed = saveg_read32();
+        soundtargets[i] = saveg_read32();
+        specialdata[i] = saveg_read32();
+        sec->validcount = 0;
+    }
+    for (int i = 0; i < numlines; i++) {
+        line_t* li = &lines[i];
+        li->flags = saveg_read16();
+        li->special = saveg_read16();
+        li->tag = saveg_read16();
+        li->validcount = 0;
+    }
+    for (int i = 0; i < numsides; i++) {
+        side_t* si = &sides[i];
+        si->textureoffset = saveg_read32();
+        si->rowoffset = saveg_read32();
+        si->toptexture = saveg_read16();
+        si->bottomtexture = saveg_read16();
+        si->midtexture = saveg_read16();
+    }
+}
+
+static void P_ArchiveKeyframeThinker(thinker_t* th) {
+    keyframeclass_t tclass = P_KeyframeClass(th);
+    if (tclass == kf_none) {
+        // Only removed mobjs are kept without a known class.
+        tclass = kf_mobj;
+    }
+    saveg_write8(tclass);
+    saveg_write8(P_KeyframeState(th));
+
+    switch (tclass) {
+        case kf_mobj:
+            saveg_write_mobj_t((mobj_t*) th);
+            saveg_write32(P_KeyframeIndex(((mobj_t*) th)->target));
+            saveg_write32(P_KeyframeIndex(((mobj_t*) th)->tracer));
+            break;
+        case kf_ceiling:
+            saveg_write_ceiling_t((ceiling_t*) th);
+            break;
+        case kf_door:
+            saveg_write_vldoor_t((vldoor_t*) th);
+            break;
+        case kf_floor:
+            saveg_write_floormove_t((floormove_t*) th);
+            break;
+        case kf_plat:
+            saveg_write_plat_t((plat_t*) th);
+            break;
+        case kf_flash:
+            saveg_write_lightflash_t((lightflash_t*) th);
+            break;
+        case kf_strobe:
+            saveg_write_strobe_t((strobe_t*) th);
+            break;
+        case kf_glow:
+            saveg_write_glow_t((glow_t*) th);
+            break;
+        case kf_fireflicker:
+            saveg_write_fireflicker_t((fireflicker_t*) th);
+            break;
+        case kf_none:
+            break;
+    }
+}
+
+//
+// Mobj target and tracer are left as keyframe indexes,
+// to be resolved by P_ResolveKeyframeMobjs.
+//
+static thinker_t* P_UnArchiveKeyframeMobj() {
+    mobj_t* mobj = P_AllocThinker(tt_mobj, sizeof(*mobj));
+    saveg_read_mobj_t(mobj);
+    mobj->target = (mobj_t*) (intptr_t) saveg_read32();
+    mobj->tracer = (mobj_t*) (intptr_t) saveg_read32();
+    mobj->info = &mobjinfo[mobj->type];
+    mobj->subsector = R_PointInSubsector(mobj->x, mobj->y);
+    mobj->snext = NULL;
+    mobj->sprev = NULL;
+    mobj->bnext = NULL;
+    mobj->bprev = NULL;
+    return &mobj->thinker;
+}
+
+static thinker_t* P_UnArchiveKeyframeSpecial(keyframeclass_t tclass) {
+    switch (tclass) {
+        case kf_ceiling: {
+            ceiling_t* ceiling = P_AllocThinker(tt_ceiling, sizeof(*ceiling));
+            saveg_read_ceiling_t(ceiling);
+            return &ceiling->thinker;
+        }
+        case kf_door: {
+            vldoor_t* door = P_AllocThinker(tt_door, sizeof(*door));
+            saveg_read_vldoor_t(door);
+            return &door->thinker;
+        }
+        case kf_floor: {
+            floormove_t* floor = P_AllocThinker(tt_floor, sizeof(*floor));
+            saveg_read_floormove_t(floor);
+            return &floor->thinker;
+        }
+        case kf_plat: {
+            plat_t* plat = P_AllocThinker(tt_plat, sizeof(*plat));
+            saveg_read_plat_t(plat);
+            return &plat->thinker;
+        }
+        case kf_flash: {
+            lightflash_t* flash = P_AllocThinker(tt_flash, sizeof(*flash));
+            saveg_read_lightflash_t(flash);
+            return &flash->thinker;
+        }
+        case kf_strobe: {
+            strobe_t* strobe = P_AllocThinker(tt_strobe, sizeof(*strobe));
+            saveg_read_strobe_t(strobe);
+            return &strobe->thinker;
+        }
+        case kf_glow: {
+            glow_t* glow = P_AllocThinker(tt_glow, sizeof(*glow));
+            saveg_read_glow_t(glow);
+            return &glow->thinker;
+        }
+        case kf_fireflicker: {
+            fireflicker_t* flick =
+                P_AllocThinker(tt_fireflicker, sizeof(*flick));
+            saveg_read_fireflicker_t(flick);
+            return &flick->thinker;
+        }
+        default:
+            I_Error("P_UnArchiveKeyframe: Unknown tclass %i in keyframe",
+                    tclass);
+    }
+    return NULL;
+}
+
+static actionf_p1 P_KeyframeThinkFunction(keyframeclass_t tclass) {
+    switch (tclass) {
+        case kf_mobj:
+            return (actionf_p1) P_MobjThinker;
+        case kf_ceiling:
+            return (actionf_p1) T_MoveCeiling;
+        case kf_door:
+            return (actionf_p1) T_VerticalDoor;
+        case kf_floor:
+            return (actionf_p1) T_MoveFloor;
+        case kf_plat:
+            return (actionf_p1) T_PlatRaise;
+        case kf_flash:
+            return (actionf_p1) T_LightFlash;
+        case kf_strobe:
+            return (actionf_p1) T_StrobeFlash;
+        case kf_glow:
+            return (actionf_p1) T_Glow;
+        case kf_fireflicker:
+            return (actionf_p1) T_FireFlicker;
+        default:
+            return NULL;
+    }
+}
+
+static void P_UnArchiveKeyframeThinker() {
+    keyframeclass_t tclass = saveg_read8();
+    keyframestate_t state = saveg_read8();
+
+    thinker_t* th;
+    if (tclass == kf_mobj) {
+        th = P_UnArchiveKeyframeMobj();
+    } else {
+        th = P_UnArchiveKeyframeSpecial(tclass);
+    }
+
+    switch (state) {
+        case kf_stasis:
+            th->function.acv = (actionf_v) NULL;
+            break;
+        case kf_removed:
+            th->function.acv = (actionf_v) (-1);
+            break;
+        default:
+            th->function.acp1 = P_KeyframeThinkFunction(tclass);
+            break;
+    }
+    P_AddThinker(th);
+    kf_thinkers[kf_numthinkers++] = th;
+}
+
+static void P_ResolveKeyframeMobjs() {
+    for (int i = 0; i < kf_numthinkers; i++) {
+        mobj_t* mobj = (mobj_t*) kf_thinkers[i];
+        if (mobj->thinker.function.acp1 != (actionf_p1) P_MobjThinker
+            && !P_IsThinkerRemoved(&mobj->thinker)) {
+            continue;
+        }
+        mobj->target = P_KeyframeThinker((intptr_t) mobj->target);
+        mobj->tracer = P_KeyframeThinker((intptr_t) mobj->tracer);
+    }
+}
+
+static void P_ArchiveKeyframeThingLists() {
+    // Sector thing lists.
+    for (int i = 0; i < numsectors; i++) {
+        int count = 0;
+        for (mobj_t* mo = sectors[i].thinglist; mo; mo = mo->snext) {
+            count++;
+        }
+        saveg_write32(count);
+        for (mobj_t* mo = sectors[i].thinglist; mo; mo = mo->snext) {
+            saveg_write32(P_KeyframeIndex(mo));
+        }
+    }
+
+    // Blockmap thing lists, only the non empty blocks.
+    int numblocks = bmapwidth * bmapheight;
+    int used = 0;
+    for (int i = 0; i < numblocks; i++) {
+        if (blocklinks[i]) {
+            used++;
+        }
+    }
+    saveg_write32(used);
+    for (int i = 0; i < numblocks; i++) {
+        if (!blocklinks[i]) {
+            continue;
+        }
+        int count = 0;
+        for (mobj_t* mo = blocklinks[i]; mo; mo = mo->bnext) {
+            count++;
+        }
+        saveg_write32(i);
+        saveg_write32(count);
+        for (mobj_t* mo = blocklinks[i]; mo; mo = mo->bnext) {
+            saveg_write32(P_KeyframeIndex(mo));
+        }
+    }
+}
+
+static void P_UnArchiveKeyframeThingLists() {
+    for (int i = 0; i < numsectors; i++) {
+        mobj_t* prev = NULL;
+        int count = saveg_read32();
+        sectors[i].thinglist = NULL;
+        for (int j = 0; j < count; j++) {
+            mobj_t* mo = P_KeyframeThinker(saveg_read32());
+            mo->sprev = prev;
+            mo->snext = NULL;
+            if (prev) {
+                prev->snext = mo;
+            } else {
+                sectors[i].thinglist = mo;
+            }
+            prev = mo;
+        }
+    }
+
+    int numblocks = bmapwidth * bmapheight;
+    memset(blocklinks, 0, numblocks * sizeof(*blocklinks));
+    int used = saveg_read32();
+    for (int i = 0; i < used; i++) {
+        int block = saveg_read32();
+        int count = saveg_read32();
+        if (block < 0 || block >= numblocks) {
+            I_Error("P_UnArchiveKeyframe: Bad blockmap block %i", block);
+        }
+        mobj_t* prev = NULL;
+        for (int j = 0; j < count; j++) {
+            mobj_t* mo = P_KeyframeThinker(saveg_read32());
+            mo->bprev = prev;
+            mo->bnext = NULL;
+            if (prev) {
+                prev->bnext = mo;
+            } else {
+                blocklinks[block] = mo;
+            }
+            prev = mo;
+        }
+    }
+}
+
+static void P_ArchiveKeyframePlayers() {
+    for (int i = 0; i < MAXPLAYERS; i++) {
+        if (!playeringame[i]) {
+            continue;
+        }
+        saveg_write_player_t(&players[i]);
+        saveg_write32(P_KeyframeIndex(players[i].mo));
+        saveg_write32(P_KeyframeIndex(players[i].attacker));
+    }
+}
+
+static void P_UnArchiveKeyframePlayers() {
+    for (int i = 0; i < MAXPLAYERS; i++) {
+        if (!playeringame[i]) {
+            continue;
+        }
+        saveg_read_player_t(&players[i]);
+        players[i].mo = P_KeyframeThinker(saveg_read32());
+        players[i].attacker = P_KeyframeThinker(saveg_read32());
+        players[i].message = NULL;
+    }
+}
+
+static void P_ArchiveKeyframeSpecials() {
+    for (int i = 0; i < MAXCEILINGS; i++) {
+        saveg_write32(P_KeyframeIndex(activeceilings[i]));
+    }
+    for (int i = 0; i < MAXPLATS; i++) {
+        saveg_write32(P_KeyframeIndex(activeplats[i]));
+    }
+    for (int i = 0; i < MAXBUTTONS; i++) {
+        const button_t* button = &buttonlist[i];
+        saveg_write32(button->line ? button->line - lines : -1);
+        saveg_write_enum(button->where);
+        saveg_write32(button->btexture);
+        saveg_write32(button->btimer);
+        saveg_write32(button->soundorg ? button->line->frontsector - sectors
+                                       : -1);
+    }
+}
+
+static void P_UnArchiveKeyframeSpecials() {
+    for (int i = 0; i < MAXCEILINGS; i++) {
+        activeceilings[i] = P_KeyframeThinker(saveg_read32());
+    }
+    for (int i = 0; i < MAXPLATS; i++) {
+        activeplats[i] = P_KeyframeThinker(saveg_read32());
+    }
+    for (int i = 0; i < MAXBUTTONS; i++) {
+        button_t* button = &buttonlist[i];
+        int line = saveg_read32();
+        button->line = line >= 0 ? &lines[line] : NULL;
+        button->where = saveg_read_enum();
+        button->btexture = saveg_read32();
+        button->btimer = saveg_read32();
+        int sector = saveg_read32();
+        button->soundorg = sector >= 0 ? &sectors[sector].soundorg : NULL;
+    }
+}
+
+static void P_ArchiveKeyframeQueues() {
+    saveg_write32(numbraintargets);
+    saveg_write32(braintargeton);
+    saveg_write32(brainspiteasy);
+    for (int i = 0; i < MAXBRAINTARGETS; i++) {
+        saveg_write32(P_KeyframeIndex(braintargets[i]));
+    }
+
+    saveg_write32(bodyqueslot);
+    for (int i = 0; i < BODYQUESIZE; i++) {
+        saveg_write32(P_KeyframeIndex(bodyque[i]));
+    }
+
+    saveg_write32(iquehead);
+    saveg_write32(iquetail);
+    for (int i = 0; i < ITEMQUESIZE; i++) {
+        saveg_write_mapthing_t(&itemrespawnque[i]);
+        saveg_write32(itemrespawntime[i]);
+    }
+}
+
+static void P_UnArchiveKeyframeQueues() {
+    numbraintargets = saveg_read32();
+    braintargeton = saveg_read32();
+    brainspiteasy = saveg_read32();
+    for (int i = 0; i < MAXBRAINTARGETS; i++) {
+        braintargets[i] = P_KeyframeThinker(saveg_read32());
+    }
+
+    bodyqueslot = saveg_read32();
+    for (int i = 0; i < BODYQUESIZE; i++) {
+        bodyque[i] = P_KeyframeThinker(saveg_read32());
+    }
+
+    iquehead = saveg_read32();
+    iquetail = saveg_read32();
+    for (int i = 0; i < ITEMQUESIZE; i++) {
+        saveg_read_mapthing_t(&itemrespawnque[i]);
+        itemrespawntime[i] = saveg_read32();
+    }
+}
+
+//
+// P_ArchiveKeyframe
+// Write an exact snapshot of the play simulation of the current level.
+//
+void P_ArchiveKeyframe() {
+    P_CollectKeyframeThinkers();
+
+    P_ArchiveKeyframeGlobals();
+    P_ArchiveKeyframeWorld();
+
+    saveg_write32(kf_numthinkers);
+    for (int i = 0; i < kf_numthinkers; i++) {
+        P_ArchiveKeyframeThinker(kf_thinkers[i]);
+    }
+
+    P_ArchiveKeyframeThingLists();
+    P_ArchiveKeyframePlayers();
+    P_ArchiveKeyframeSpecials();
+    P_ArchiveKeyframeQueues();
+    saveg_write8(KEYFRAME_EOF);
+
+    P_FreeKeyframeThinkers();
+}
+
+//
+// P_UnArchiveKeyframe
+// Restore a snapshot written by P_ArchiveKeyframe. The level it was taken
+// on must already be loaded. Returns false if the keyframe is damaged.
+//
+bool P_UnArchiveKeyframe() {
+    P_UnArchiveKeyframeGlobals();
+
+    int* soundtargets = Z_Malloc(numsectors * sizeof(int), PU_STATIC, NULL);
+    int* specialdata = Z_Malloc(numsectors * sizeof(int), PU_STATIC, NULL);
+    P_UnArchiveKeyframeWorld(soundtargets, specialdata);
+
+    P_ResetThinkers();
+    int count = saveg_read32();
+    if (count < 0 || savegame_error) {
+        I_Error("P_UnArchiveKeyframe: Bad thinker count %i", count);
+    }
+    P_AllocKeyframeThinkers(count);
+    for (int i = 0; i < count; i++) {
+        P_UnArchiveKeyframeThinker();
+    }
+    P_ResolveKeyframeMobjs();
+
+    for (int i = 0; i < numsectors; i++) {
+        sectors[i].soundtarget = P_KeyframeThinker(soundtargets[i]);
+        sectors[i].specialdata = P_KeyframeThinker(specialdata[i]);
+    }
+    Z_Free(soundtargets);
+    Z_Free(specialdata);
+
+    P_UnArchiveKeyframeThingLists();
+    P_UnArchiveKeyframePlayers();
+    P_UnArchiveKeyframeSpecials();
+    P_UnArchiveKeyframeQueues();
+    bool result = saveg_read8() == KEYFRAME_EOF && !savegame_error;
+
+    P_FreeKeyframeThinkers();
+    return result;
+}
@@ -58,6 +58,11 @@ void P_UnArchiveThinkers (void);
 void P_ArchiveSpecials (void);
 void P_UnArchiveSpecials (void);
 
+// Demo keyframes: exact snapshots of the play simulation, restored
+// over a freshly loaded copy of the level they were taken on.
+void P_ArchiveKeyframe(void);
+bool P_UnArchiveKeyframe(void);
+
 extern FILE *save_stream;
 extern bool savegame_error;
 
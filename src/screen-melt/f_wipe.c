@@ -19,6 +19,7 @@
 #include <string.h>
 
 #include "z_zone.h"
+#include "i_system.h"
 #include "i_video.h"
 #include "v_video.h"
 #include "m_random.h"
@@ -29,11 +30,15 @@
 //                       SCREEN WIPE PACKAGE
 //
 
+// Screen sized, so they grow with render_scale. They are kept outside
+// the zone, allocated on the first wipe and reused after that.
 static pixel_t*	wipe_scr_start;
 static pixel_t*	wipe_scr_end;
 
 // The position of each column in the screen when scrolling.
 // (col_pos < 0 => not ready to scroll yet)
+// Columns and positions are in original resolution pixels; each one
+// moves render_scale columns of the screen.
 static int* col_pos;
 
 
@@ -41,14 +46,14 @@ static int* col_pos;
 // Setup initial column positions.
 //
 static void wipe_initColumnPositions() {
-    size_t size = SCREENWIDTH * sizeof(*col_pos);
+    size_t size = ORIGWIDTH * sizeof(*col_pos);
     col_pos = Z_Malloc((int) size, PU_STATIC, NULL);
 
     // The screen is divided into groups of two columns, where
     // each pair of columns moves together at the same speed.
     col_pos[0] = -(M_Random() % 16);
     col_pos[1] = col_pos[0];
-    for (int i = 2; i < SCREENWIDTH; i += 2) {
+    for (int i = 2; i < ORIGWIDTH; i += 2) {
         // Generate a random value of -1, 0, or 1.
         int r = (M_Random() % 3) - 1;
         int pos = col_pos[i - 1] + r;
@@ -81,13 +86,15 @@ static void wipe_moveStartScreen(int i, int dy) {
     const pixel_t* src = wipe_scr_start;
     pixel_t* dst = I_VideoBuffer;
 
+    int x = i * render_scale;
     int y0 = 0;
-    int y1 = SCREENHEIGHT - col_pos[i];
+    int y1 = (ORIGHEIGHT - col_pos[i]) * render_scale;
+    int offset = col_pos[i] * render_scale;
 
     for (int y = y0; y < y1; y++) {
-        int src_spot = i + (y * SCREENWIDTH);
-        int dst_spot = i + ((y + col_pos[i]) * SCREENWIDTH);
-        dst[dst_spot] = src[src_spot];
+        int src_spot = x + (y * SCREENWIDTH);
+        int dst_spot = x + ((y + offset) * SCREENWIDTH);
+        memcpy(&dst[dst_spot], &src[src_spot], render_scale * sizeof(*dst));
     }
 }
 
@@ -95,12 +102,13 @@ static void wipe_moveEndScreen(int i, int dy) {
     const pixel_t* src = wipe_scr_end;
     pixel_t* dst = I_VideoBuffer;
 
-    int y0 = col_pos[i];
-    int y1 = y0 + dy;
+    int x = i * render_scale;
+    int y0 = col_pos[i] * render_scale;
+    int y1 = y0 + dy * render_scale;
 
     for (int y = y0; y < y1; y++) {
-        int spot = i + (y * SCREENWIDTH);
-        dst[spot] = src[spot];
+        int spot = x + (y * SCREENWIDTH);
+        memcpy(&dst[spot], &src[spot], render_scale * sizeof(*dst));
     }
 }
 
@@ -110,8 +118,8 @@ static void wipe_moveEndScreen(int i, int dy) {
 static int wipe_CalculateDy(int i) {
     int pos = col_pos[i];
     int dy = (pos < 16) ? pos + 1 : 8;
-    if (pos + dy >= SCREENHEIGHT) {
-        dy = SCREENHEIGHT - pos;
+    if (pos + dy >= ORIGHEIGHT) {
+        dy = ORIGHEIGHT - pos;
     }
     return dy;
 }
@@ -125,12 +133,12 @@ static void wipe_moveColumn(int col) {
 static bool wipe_moveColumns() {
     bool done = true;
 
-    for (int i = 0; i < SCREENWIDTH; i++) {
+    for (int i = 0; i < ORIGWIDTH; i++) {
         if (col_pos[i] < 0) {
             // A column will only start to move when col_pos >= 0.
             col_pos[i]++;
             done = false;
-        } else if (col_pos[i] < SCREENHEIGHT) {
+        } else if (col_pos[i] < ORIGHEIGHT) {
             wipe_moveColumn(i);
             done = false;
         }
@@ -149,24 +157,26 @@ static bool wipe_doMelt(int ticks) {
 
 static void wipe_exitMelt() {
     Z_Free(col_pos);
-    Z_Free(wipe_scr_start);
-    Z_Free(wipe_scr_end);
 }
 
 void wipe_StartScreen() {
     int size = SCREENWIDTH * SCREENHEIGHT * sizeof(*wipe_scr_start);
-    wipe_scr_start = Z_Malloc(size, PU_STATIC, NULL);
+    if (wipe_scr_start == NULL) {
+        wipe_scr_start = I_Realloc(NULL, size);
+    }
     I_ReadScreen(wipe_scr_start);
 }
 
 void wipe_EndScreen() {
     // Copy current frame to wipe_scr_end
     int size = SCREENWIDTH * SCREENHEIGHT * sizeof(*wipe_scr_end);
-    wipe_scr_end = Z_Malloc(size, PU_STATIC, NULL);
+    if (wipe_scr_end == NULL) {
+        wipe_scr_end = I_Realloc(NULL, size);
+    }
     I_ReadScreen(wipe_scr_end);
 
     // Copy wipe_scr_start (previous frame) to video screen.
-    V_DrawBlock(0, 0, SCREENWIDTH, SCREENHEIGHT, wipe_scr_start);
+    memcpy(I_VideoBuffer, wipe_scr_start, size);
 }
 
 int wipe_ScreenWipe(int ticks) {
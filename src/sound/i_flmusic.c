@@ -39,8 +39,6 @@ typedef fluid_long_long_t fluid_int_t;
 #include "i_system.h"
 #include "i_sound.h"
 #include "m_misc.h"
-#include "memio.h"
-#include "mus2mid.h"
 
 char *fsynth_sf_path = "";
 int fsynth_chorus_active = 1;
@@ -190,16 +188,9 @@ static void I_FL_StopSong(void)
     }
 }
 
-// Determine whether memory block is a .mid file
-
-static bool IsMid(const byte *mem, int len)
-{
-    return len > 4 && !memcmp(mem, "MThd", 4);
-}
-
 static void *I_FL_RegisterSong(void *data, int len)
 {
-    int result = FLUID_FAILED;
+    int result;
 
     player = new_fluid_player(synth);
 
@@ -210,43 +201,13 @@ static void *I_FL_RegisterSong(void *data, int len)
         return NULL;
     }
 
-    if (IsMid(data, len))
-    {
-        result = fluid_player_add_mem(player, data, len);
-
-        if (result == FLUID_FAILED)
-        {
-            fprintf(stderr,
-                    "I_FL_RegisterSong: FluidSynth failed to load MIDI.\n");
-            return NULL;
-        }
-    }
-    else
+    result = fluid_player_add_mem(player, data, len);
+
+    if (result == FLUID_FAILED)
     {
-        // Assume a MUS file and try to convert
-        MEMFILE *instream;
-        MEMFILE *outstream;
-        void *outbuf;
-        size_t outbuf_len;
-
-        instream = mem_fopen_read(data, len);
-        outstream = mem_fopen_write();
-
-        if (mus2mid(instream, outstream) == 0)
-        {
-            mem_get_buf(outstream, &outbuf, &outbuf_len);
-            result = fluid_player_add_mem(player, outbuf, outbuf_len);
-        }
-
-        mem_fclose(instream);
-        mem_fclose(outstream);
-
-        if (result == FLUID_FAILED)
-        {
-            fprintf(stderr,
-                    "I_FL_RegisterSong: FluidSynth failed to load MUS.\n");
-            return NULL;
-        }
+        fprintf(stderr,
+                "I_FL_RegisterSong: FluidSynth failed to load MIDI.\n");
+        return NULL;
     }
 
     Mix_HookMusic(FL_Mix_Callback, NULL);
@@ -0,0 +1,610 @@
+//
+// Copyright(C) 1993-1996 Id Software, Inc.
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	System interface for sound, with a native software mixer.
+//
+//	Sound effects are mixed straight from their 8-bit DMX lumps,
+//	resampled on the fly to the output rate, so no converted copy
+//	of any sound is ever kept. The mixer runs as an SDL_mixer post
+//	effect, so the music modules keep working on the same device.
+//
+
+#include "config.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "SDL.h"
+#include "SDL_mixer.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "deh_str.h"
+#include "i_sound.h"
+#include "m_misc.h"
+#include "w_wad.h"
+#include "z_zone.h"
+
+#include "doomtype.h"
+
+
+// Use the native mixer instead of SDL_mixer channels for sound effects.
+
+int snd_nativemixer = 0;
+
+
+#ifndef DISABLE_SDL2MIXER
+
+
+#define NUM_CHANNELS 16
+
+// Frames mixed at a time.
+#define MIX_BLOCK 256
+
+//
+// A sound effect lump, parsed once and kept for the rest of the game.
+// The samples are unsigned 8-bit mono.
+//
+typedef struct
+{
+    const byte *samples;
+    uint32_t length;
+    int samplerate;
+} mixsfx_t;
+
+typedef struct
+{
+    // NULL when the voice is not playing.
+    const byte *samples;
+    uint32_t length;
+
+    // 32.32 fixed point position and step, in source samples.
+    uint64_t position;
+    uint64_t step;
+
+    // Left and right gains, 0-255.
+    int left;
+    int right;
+} voice_t;
+
+static bool sound_initialized = false;
+static bool use_sfx_prefix;
+
+static int mixer_freq;
+
+// Written by the game thread and read by the audio thread in MixVoices,
+// both with voices_lock held. SDL_LockAudio only covers the legacy audio
+// device, not the one SDL_mixer opens, so it cannot be used here.
+static voice_t voices[NUM_CHANNELS];
+static SDL_mutex *voices_lock;
+
+// Mixing buffers, only used by the audio thread.
+static int16_t mono_buf[MIX_BLOCK];
+static int32_t mix_buf[MIX_BLOCK * 2];
+
+
+//
+// Resample a voice into mono_buf, with linear interpolation between
+// source samples. Returns the number of frames generated, which is
+// less than frames if the sound ended.
+//
+static int ResampleVoice(voice_t *voice, int frames)
+{
+    const byte *samples = voice->samples;
+    uint32_t last = voice->length - 1;
+    uint64_t position = voice->position;
+    uint64_t step = voice->step;
+    int i;
+
+    for (i = 0; i < frames; ++i)
+    {
+        uint32_t index = (uint32_t) (position >> 32);
+
+        if (index > last)
+        {
+            break;
+        }
+
+        int s0 = samples[index] - 128;
+        int s1 = (index < last) ? samples[index + 1] - 128 : s0;
+        int frac = (int) ((position >> 24) & 0xff);
+
+        mono_buf[i] = (int16_t) ((s0 << 8) + (s1 - s0) * frac);
+        position += step;
+    }
+
+    voice->position = position;
+
+    return i;
+}
+
+//
+// Apply the voice gains to mono_buf and add the result to mix_buf.
+//
+static void AccumulateVoice(const voice_t *voice, int frames)
+{
+    int i = 0;
+
+#ifdef __SSE2__
+    __m128i gains = _mm_set_epi16(voice->right, voice->left,
+                                  voice->right, voice->left,
+                                  voice->right, voice->left,
+                                  voice->right, voice->left);
+
+    for (; i + 8 <= frames; i += 8)
+    {
+        __m128i mono = _mm_loadu_si128((const __m128i *) &mono_buf[i]);
+
+        for (int half = 0; half < 2; ++half)
+        {
+            // Duplicate each sample into a left/right pair.
+            __m128i stereo = half ? _mm_unpackhi_epi16(mono, mono)
+                                  : _mm_unpacklo_epi16(mono, mono);
+
+            // 16x16 -> 32 bit products.
+            __m128i lo = _mm_mullo_epi16(stereo, gains);
+            __m128i hi = _mm_mulhi_epi16(stereo, gains);
+            __m128i *out = (__m128i *) &mix_buf[(i + half * 4) * 2];
+
+            _mm_storeu_si128(out, _mm_add_epi32(_mm_loadu_si128(out),
+                                               _mm_unpacklo_epi16(lo, hi)));
+            _mm_storeu_si128(out + 1,
+                             _mm_add_epi32(_mm_loadu_si128(out + 1),
+                                           _mm_unpackhi_epi16(lo, hi)));
+        }
+    }
+#endif
+
+    for (; i < frames; ++i)
+    {
+        mix_buf[i * 2] += mono_buf[i] * voice->left;
+        mix_buf[i * 2 + 1] += mono_buf[i] * voice->right;
+    }
+}
+
+//
+// Add mix_buf to the output, which already holds the music.
+//
+static void WriteMix(int16_t *stream, int frames)
+{
+    int samples = frames * 2;
+    int i = 0;
+
+#ifdef __SSE2__
+    for (; i + 8 <= samples; i += 8)
+    {
+        __m128i a = _mm_srai_epi32(
+            _mm_loadu_si128((const __m128i *) &mix_buf[i]), 8);
+        __m128i b = _mm_srai_epi32(
+            _mm_loadu_si128((const __m128i *) &mix_buf[i + 4]), 8);
+        __m128i *out = (__m128i *) &stream[i];
+
+        _mm_storeu_si128(out, _mm_adds_epi16(_mm_loadu_si128(out),
+                                             _mm_packs_epi32(a, b)));
+    }
+#endif
+
+    for (; i < samples; ++i)
+    {
+        int value = stream[i] + (mix_buf[i] >> 8);
+
+        if (value < INT16_MIN)
+        {
+            value = INT16_MIN;
+        }
+        else if (value > INT16_MAX)
+        {
+            value = INT16_MAX;
+        }
+
+        stream[i] = (int16_t) value;
+    }
+}
+
+//
+// SDL_mixer post effect: mix all playing voices into the output.
+//
+static void MixVoices(int chan, void *stream, int len, void *udata)
+{
+    int16_t *out = stream;
+    int frames = len / 4;
+
+    SDL_LockMutex(voices_lock);
+
+    while (frames > 0)
+    {
+        int block = frames < MIX_BLOCK ? frames : MIX_BLOCK;
+        bool mixed = false;
+
+        memset(mix_buf, 0, block * 2 * sizeof(*mix_buf));
+
+        for (int i = 0; i < NUM_CHANNELS; ++i)
+        {
+            voice_t *voice = &voices[i];
+
+            if (voice->samples == NULL)
+            {
+                continue;
+            }
+
+            int generated = ResampleVoice(voice, block);
+
+            AccumulateVoice(voice, generated);
+            mixed = true;
+
+            if (generated < block)
+            {
+                voice->samples = NULL;
+            }
+        }
+
+        if (mixed)
+        {
+            WriteMix(out, block);
+        }
+
+        out += block * 2;
+        frames -= block;
+    }
+
+    SDL_UnlockMutex(voices_lock);
+}
+
+//
+// Parse a DMX sound lump. The lump stays cached for the rest of the
+// game, as the mixer reads its samples directly.
+//
+static mixsfx_t *LoadSfx(sfxinfo_t *sfxinfo)
+{
+    mixsfx_t *sfx = sfxinfo->driver_data;
+
+    if (sfx != NULL)
+    {
+        return sfx->length > 0 ? sfx : NULL;
+    }
+
+    sfx = Z_Malloc(sizeof(*sfx), PU_STATIC, NULL);
+    sfx->samples = NULL;
+    sfx->length = 0;
+    sfx->samplerate = 0;
+    sfxinfo->driver_data = sfx;
+
+    int lumpnum = sfxinfo->lumpnum;
+    byte *data = W_CacheLumpNum(lumpnum, PU_STATIC);
+    unsigned int lumplen = W_LumpLength(lumpnum);
+
+    // Same validation as the SDL_mixer module: a DMX header, and
+    // DMX discards sounds of 48 samples or less.
+
+    if (lumplen < 8 || data[0] != 0x03 || data[1] != 0x00)
+    {
+        W_ReleaseLumpNum(lumpnum);
+        return NULL;
+    }
+
+    int samplerate = (data[3] << 8) | data[2];
+    unsigned int length = (data[7] << 24) | (data[6] << 16)
+                        | (data[5] << 8) | data[4];
+
+    if (length > lumplen - 8 || length <= 48 || samplerate == 0)
+    {
+        W_ReleaseLumpNum(lumpnum);
+        return NULL;
+    }
+
+    // The DMX sound library skips the first 16 and last 16 bytes.
+
+    sfx->samples = data + 8 + 16;
+    sfx->length = length - 32;
+    sfx->samplerate = samplerate;
+
+    return sfx;
+}
+
+static void GetSfxLumpName(sfxinfo_t *sfx, char *buf, size_t buf_len)
+{
+    // Linked sfx lumps? Get the lump number for the sound linked to.
+
+    if (sfx->link != NULL)
+    {
+        sfx = sfx->link;
+    }
+
+    // Doom adds a DS* prefix to sound lumps; Heretic and Hexen don't
+    // do this.
+
+    if (use_sfx_prefix)
+    {
+        M_snprintf(buf, buf_len, "ds%s", DEH_String(sfx->name));
+    }
+    else
+    {
+        M_StringCopy(buf, DEH_String(sfx->name), buf_len);
+    }
+}
+
+//
+// Only the lumps are loaded, there is nothing to convert.
+//
+static void I_MIX_PrecacheSounds(sfxinfo_t *sounds, int num_sounds)
+{
+    char namebuf[9];
+
+    for (int i = 0; i < num_sounds; ++i)
+    {
+        GetSfxLumpName(&sounds[i], namebuf, sizeof(namebuf));
+
+        sounds[i].lumpnum = W_CheckNumForName(namebuf);
+
+        if (sounds[i].lumpnum != -1)
+        {
+            LoadSfx(&sounds[i]);
+        }
+    }
+}
+
+static int I_MIX_GetSfxLumpNum(sfxinfo_t *sfx)
+{
+    char namebuf[9];
+
+    GetSfxLumpName(sfx, namebuf, sizeof(namebuf));
+
+    return W_GetNumForName(namebuf);
+}
+
+static void SetVoiceParams(voice_t *voice, int vol, int sep)
+{
+    int left = ((254 - sep) * vol) / 127;
+    int right = ((sep) * vol) / 127;
+
+    if (left < 0) left = 0;
+    else if (left > 255) left = 255;
+    if (right < 0) right = 0;
+    else if (right > 255) right = 255;
+
+    voice->left = left;
+    voice->right = right;
+}
+
+static void I_MIX_UpdateSoundParams(int handle, int vol, int sep)
+{
+    if (!sound_initialized || handle < 0 || handle >= NUM_CHANNELS)
+    {
+        return;
+    }
+
+    SDL_LockMutex(voices_lock);
+    SetVoiceParams(&voices[handle], vol, sep);
+    SDL_UnlockMutex(voices_lock);
+}
+
+//
+// Playback rate of a sound, as a step in source samples per output
+// frame. Pitch shifting follows the SDL_mixer module, which stretches
+// the sound by (2 - pitch / NORM_PITCH).
+//
+static uint64_t VoiceStep(const mixsfx_t *sfx, int pitch)
+{
+    uint64_t step = ((uint64_t) sfx->samplerate << 32) / mixer_freq;
+
+    if (snd_pitchshift && pitch != NORM_PITCH && pitch < 2 * NORM_PITCH)
+    {
+        step = step * NORM_PITCH / (2 * NORM_PITCH - pitch);
+    }
+
+    return step;
+}
+
+static int I_MIX_StartSound(sfxinfo_t *sfxinfo, int channel, int vol, int sep,
+                            int pitch)
+{
+    if (!sound_initialized || channel < 0 || channel >= NUM_CHANNELS)
+    {
+        return -1;
+    }
+
+    mixsfx_t *sfx = LoadSfx(sfxinfo);
+
+    SDL_LockMutex(voices_lock);
+
+    voice_t *voice = &voices[channel];
+
+    if (sfx == NULL)
+    {
+        voice->samples = NULL;
+        SDL_UnlockMutex(voices_lock);
+        return -1;
+    }
+
+    voice->samples = sfx->samples;
+    voice->length = sfx->length;
+    voice->position = 0;
+    voice->step = VoiceStep(sfx, pitch);
+    SetVoiceParams(voice, vol, sep);
+
+    SDL_UnlockMutex(voices_lock);
+
+    return channel;
+}
+
+static void I_MIX_StopSound(int handle)
+{
+    if (!sound_initialized || handle < 0 || handle >= NUM_CHANNELS)
+    {
+        return;
+    }
+
+    SDL_LockMutex(voices_lock);
+    voices[handle].samples = NULL;
+    SDL_UnlockMutex(voices_lock);
+}
+
+static bool I_MIX_SoundIsPlaying(int handle)
+{
+    if (!sound_initialized || handle < 0 || handle >= NUM_CHANNELS)
+    {
+        return false;
+    }
+
+    SDL_LockMutex(voices_lock);
+    bool playing = voices[handle].samples != NULL;
+    SDL_UnlockMutex(voices_lock);
+
+    return playing;
+}
+
+//
+// Voices stop by themselves and hold no resources, so there is
+// nothing to update.
+//
+static void I_MIX_UpdateSound(void)
+{
+}
+
+static void I_MIX_ShutdownSound(void)
+{
+    if (!sound_initialized)
+    {
+        return;
+    }
+
+    Mix_UnregisterEffect(MIX_CHANNEL_POST, MixVoices);
+    Mix_CloseAudio();
+    SDL_QuitSubSystem(SDL_INIT_AUDIO);
+
+    SDL_DestroyMutex(voices_lock);
+    voices_lock = NULL;
+
+    sound_initialized = false;
+}
+
+// Calculate slice size, based on snd_maxslicetime_ms.
+// The result must be a power of two.
+
+static int GetSliceSize(void)
+{
+    int limit = (snd_samplerate * snd_maxslicetime_ms) / 1000;
+
+    // Try all powers of two, not exceeding the limit.
+
+    for (int n = 0; n < 16; ++n)
+    {
+        // 2^n <= limit < 2^n+1 ?
+
+        if ((1 << (n + 1)) > limit)
+        {
+            return (1 << n);
+        }
+    }
+
+    return 1024;
+}
+
+static bool I_MIX_InitSound(bool _use_sfx_prefix)
+{
+    Uint16 mixer_format;
+    int mixer_channels;
+
+    // Only used when selected, the SDL_mixer module is used otherwise.
+
+    if (!snd_nativemixer)
+    {
+        return false;
+    }
+
+    use_sfx_prefix = _use_sfx_prefix;
+
+    memset(voices, 0, sizeof(voices));
+
+    if (SDL_Init(SDL_INIT_AUDIO) < 0)
+    {
+        fprintf(stderr, "Unable to set up sound.\n");
+        return false;
+    }
+
+    if (Mix_OpenAudioDevice(snd_samplerate, AUDIO_S16SYS, 2, GetSliceSize(),
+                            NULL, SDL_AUDIO_ALLOW_FREQUENCY_CHANGE) < 0)
+    {
+        fprintf(stderr, "Error initialising SDL_mixer: %s\n", Mix_GetError());
+        SDL_QuitSubSystem(SDL_INIT_AUDIO);
+        return false;
+    }
+
+    Mix_QuerySpec(&mixer_freq, &mixer_format, &mixer_channels);
+
+    // The mixer only generates 16-bit stereo.
+
+    if (mixer_format != AUDIO_S16SYS || mixer_channels != 2)
+    {
+        fprintf(stderr, "I_MIX_InitSound: Unsupported output format, "
+                        "falling back to SDL_mixer.\n");
+        Mix_CloseAudio();
+        SDL_QuitSubSystem(SDL_INIT_AUDIO);
+        return false;
+    }
+
+    // Sound effects do not use SDL_mixer channels at all.
+
+    Mix_AllocateChannels(0);
+
+    voices_lock = SDL_CreateMutex();
+
+    if (voices_lock == NULL)
+    {
+        fprintf(stderr, "I_MIX_InitSound: Unable to create a mutex: %s\n",
+                        SDL_GetError());
+        Mix_CloseAudio();
+        SDL_QuitSubSystem(SDL_INIT_AUDIO);
+        return false;
+    }
+
+    Mix_RegisterEffect(MIX_CHANNEL_POST, MixVoices, NULL, NULL);
+
+    SDL_PauseAudio(0);
+
+    sound_initialized = true;
+
+    return true;
+}
+
+static const snddevice_t sound_mix_devices[] =
+{
+    SNDDEVICE_SB,
+    SNDDEVICE_PAS,
+    SNDDEVICE_GUS,
+    SNDDEVICE_WAVEBLASTER,
+    SNDDEVICE_SOUNDCANVAS,
+    SNDDEVICE_AWE32,
+};
+
+const sound_module_t sound_mix_module =
+{
+    sound_mix_devices,
+    arrlen(sound_mix_devices),
+    I_MIX_InitSound,
+    I_MIX_ShutdownSound,
+    I_MIX_GetSfxLumpNum,
+    I_MIX_UpdateSound,
+    I_MIX_UpdateSoundParams,
+    I_MIX_StartSound,
+    I_MIX_StopSound,
+    I_MIX_SoundIsPlaying,
+    I_MIX_PrecacheSounds,
+};
+
+
+#endif // DISABLE_SDL2MIXER
@@ -21,8 +21,6 @@
 #include <stdlib.h>
 #include <string.h>
 
-#include "memio.h"
-#include "mus2mid.h"
 
 #include "deh_str.h"
 #include "i_sound.h"
@@ -36,7 +34,6 @@
 
 // #define OPL_MIDI_DEBUG
 
-#define MAXMIDLENGTH (96 * 1024)
 #define GENMIDI_NUM_INSTRS  128
 #define GENMIDI_NUM_PERCUSSION 47
 
@@ -647,7 +644,10 @@ static void I_OPL_SetMusicVolume(int volume)
 
     current_music_volume = volume;
 
-    // Update the volume of all voices.
+    // Update the volume of all voices. Callbacks also change the
+    // voices, so hold them off while doing this.
+
+    OPL_Lock();
 
     for (i = 0; i < MIDI_CHANNELS_PER_TRACK; ++i)
     {
@@ -660,6 +660,8 @@ static void I_OPL_SetMusicVolume(int volume)
             SetChannelVolume(&channels[i], channels[i].volume_base, false);
         }
     }
+
+    OPL_Unlock();
 }
 
 static void VoiceKeyOff(opl_voice_t *voice)
@@ -1535,6 +1537,8 @@ static void I_OPL_PauseSong(void)
     // Turn off all main instrument voices (not percussion).
     // This is what Vanilla does.
 
+    OPL_Lock();
+
     for (i = 0; i < num_opl_voices; ++i)
     {
         if (voices[i].channel != NULL
@@ -1543,6 +1547,8 @@ static void I_OPL_PauseSong(void)
             VoiceKeyOff(&voices[i]);
         }
     }
+
+    OPL_Unlock();
 }
 
 static void I_OPL_ResumeSong(void)
@@ -1605,77 +1611,22 @@ static void I_OPL_UnRegisterSong(void *handle)
     }
 }
 
-// Determine whether memory block is a .mid file
-
-static bool IsMid(byte *mem, int len)
-{
-    return len > 4 && !memcmp(mem, "MThd", 4);
-}
-
-static bool ConvertMus(byte *musdata, int len, char *filename)
-{
-    MEMFILE *instream;
-    MEMFILE *outstream;
-    void *outbuf;
-    size_t outbuf_len;
-    int result;
-
-    instream = mem_fopen_read(musdata, len);
-    outstream = mem_fopen_write();
-
-    result = mus2mid(instream, outstream);
-
-    if (result == 0)
-    {
-        mem_get_buf(outstream, &outbuf, &outbuf_len);
-
-        M_WriteFile(filename, outbuf, outbuf_len);
-    }
-
-    mem_fclose(instream);
-    mem_fclose(outstream);
-
-    return result;
-}
-
 static void *I_OPL_RegisterSong(void *data, int len)
 {
     midi_file_t *result;
-    char *filename;
 
     if (!music_initialized)
     {
         return NULL;
     }
 
-    // MUS files begin with "MUS"
-    // Reject anything which doesnt have this signature
-
-    filename = M_TempFile("doom.mid");
-
-    if (IsMid(data, len) && len < MAXMIDLENGTH)
-    {
-        M_WriteFile(filename, data, len);
-    }
-    else
-    {
-        // Assume a MUS file and try to convert
-
-        ConvertMus(data, len, filename);
-    }
-
-    result = MIDI_LoadFile(filename);
+    result = MIDI_LoadMemory(data, len);
 
     if (result == NULL)
     {
         fprintf(stderr, "I_OPL_RegisterSong: Failed to load MID.\n");
     }
 
-    // remove file now
-
-    M_remove(filename);
-    free(filename);
-
     return result;
 }
 
@@ -1688,7 +1639,10 @@ static bool I_OPL_MusicIsPlaying(void)
         return false;
     }
 
-    return num_tracks > 0;
+    // A song that is not looping has finished once all of its tracks
+    // have reached their end.
+
+    return num_tracks > 0 && (song_looping || running_tracks > 0);
 }
 
 // Shutdown music
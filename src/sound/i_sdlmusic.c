@@ -26,8 +26,6 @@
 
 #include "config.h"
 #include "doomtype.h"
-#include "memio.h"
-#include "mus2mid.h"
 
 #include "gusconf.h"
 #include "i_sound.h"
@@ -118,8 +116,6 @@ void I_InitTimidityConfig(void)
 #ifndef DISABLE_SDL2MIXER
 
 
-#define MAXMIDLENGTH (96 * 1024)
-
 static bool music_initialized = false;
 
 // If this is true, this module initialized SDL sound and has the
@@ -326,39 +322,6 @@ static void I_SDL_UnRegisterSong(void *handle)
     }
 }
 
-// Determine whether memory block is a .mid file 
-
-static bool IsMid(byte *mem, int len)
-{
-    return len > 4 && !memcmp(mem, "MThd", 4);
-}
-
-static bool ConvertMus(byte *musdata, int len, const char *filename)
-{
-    MEMFILE *instream;
-    MEMFILE *outstream;
-    void *outbuf;
-    size_t outbuf_len;
-    int result;
-
-    instream = mem_fopen_read(musdata, len);
-    outstream = mem_fopen_write();
-
-    result = mus2mid(instream, outstream);
-
-    if (result == 0)
-    {
-        mem_get_buf(outstream, &outbuf, &outbuf_len);
-
-        M_WriteFile(filename, outbuf, outbuf_len);
-    }
-
-    mem_fclose(instream);
-    mem_fclose(outstream);
-
-    return result;
-}
-
 static void *I_SDL_RegisterSong(void *data, int len)
 {
     char *filename;
@@ -369,25 +332,28 @@ static void *I_SDL_RegisterSong(void *data, int len)
         return NULL;
     }
 
-    // MUS files begin with "MUS"
-    // Reject anything which doesnt have this signature
+    // The data stays valid until the song is unregistered, so SDL_mixer
+    // can read it straight from memory.
 
-    filename = M_TempFile("doom.mid");
-
-    if (IsMid(data, len) && len < MAXMIDLENGTH)
-    {
-        M_WriteFile(filename, data, len);
-    }
-    else
+    if (strlen(snd_musiccmd) == 0)
     {
-	// Assume a MUS file and try to convert
+        music = Mix_LoadMUS_RW(SDL_RWFromConstMem(data, len), 1);
+        if (music == NULL)
+        {
+            // Failed to load
+            fprintf(stderr, "Error loading midi: %s\n", Mix_GetError());
+        }
 
-        ConvertMus(data, len, filename);
+        return music;
     }
 
-    // Load the MIDI. In an ideal world we'd be using Mix_LoadMUS_RW()
-    // by now, but Mix_SetMusicCMD() only works with Mix_LoadMUS(), so
-    // we have to generate a temporary file.
+    // Mix_SetMusicCMD() only works with Mix_LoadMUS(), so for an external
+    // MIDI program we have to generate a temporary file. We can't delete
+    // the file, otherwise the program won't find the file to play. This
+    // means we leave a mess on disk :(
+
+    filename = M_TempFile("doom.mid");
+    M_WriteFile(filename, data, len);
 
     music = Mix_LoadMUS(filename);
     if (music == NULL)
@@ -396,16 +362,6 @@ static void *I_SDL_RegisterSong(void *data, int len)
         fprintf(stderr, "Error loading midi: %s\n", Mix_GetError());
     }
 
-    // Remove the temporary MIDI file; however, when using an external
-    // MIDI program we can't delete the file. Otherwise, the program
-    // won't find the file to play. This means we leave a mess on
-    // disk :(
-
-    if (strlen(snd_musiccmd) == 0)
-    {
-        M_remove(filename);
-    }
-
     free(filename);
 
     return music;
@@ -35,7 +35,9 @@
 #include "i_system.h"
 #include "i_swap.h"
 #include "m_argv.h"
+#include "m_config.h"
 #include "m_misc.h"
+#include "sha1.h"
 #include "w_wad.h"
 #include "z_zone.h"
 
@@ -52,6 +54,11 @@ int use_libsamplerate = 0;
 
 float libsamplerate_scale = 0.65f;
 
+// If non-zero, sound effects converted with libsamplerate are stored
+// on disk, so they do not need to be converted again on the next run.
+
+int snd_diskcache = 1;
+
 
 #ifndef DISABLE_SDL2MIXER
 
@@ -60,6 +67,9 @@ float libsamplerate_scale = 0.65f;
 //#define DEBUG_DUMP_WAVS
 #define NUM_CHANNELS 16
 
+// Maximum number of threads converting sound effects when precaching.
+#define MAX_SFX_WORKERS 16
+
 typedef struct allocated_sound_s allocated_sound_t;
 
 struct allocated_sound_s
@@ -69,6 +79,7 @@ struct allocated_sound_s
     int use_count;
     int pitch;
     allocated_sound_t *prev, *next;
+    allocated_sound_t *hash_next;
 };
 
 static bool sound_initialized = false;
@@ -79,21 +90,88 @@ static int mixer_freq;
 static Uint16 mixer_format;
 static int mixer_channels;
 static bool use_sfx_prefix;
-static bool (*ExpandSoundData)(sfxinfo_t *sfxinfo,
-                                  byte *data,
-                                  int samplerate,
-                                  int length) = NULL;
 
-// Doubly-linked list of allocated sounds.
-// When a sound is played, it is moved to the head, so that the oldest
-// sounds not used recently are at the tail.
+// A sound effect being loaded. Conversion only touches the job itself,
+// so several jobs can be converted at once on different threads.
+
+typedef struct
+{
+    sfxinfo_t *sfxinfo;
+    int lumpnum;
+
+    // 8-bit source samples, inside the cached lump.
+    byte *data;
+    int samplerate;
+    int length;
+
+    // Key of the converted sound in the disk cache.
+    sha1_digest_t key;
+
+    // Converted sound, allocated with malloc.
+    byte *output;
+    uint32_t output_len;
+} sfxjob_t;
+
+static bool (*ExpandSoundData)(sfxjob_t *job) = NULL;
+
+// Directory of the disk cache, or NULL if it is not used.
+static char *sfx_cache_dir = NULL;
+
+// Part of every disk cache key. Bump it whenever the conversion or the
+// output format changes, so that sounds converted by older code are
+// never loaded.
+#define SFX_CACHE_VERSION 2
+
+// Allocated sounds are found through a hash table keyed by sfxinfo and
+// pitch.  Sounds that are not currently locked are also kept on a
+// doubly-linked LRU list: when a sound is unlocked it goes to the head,
+// so the tail is always the sound to free first.
+
+#define SOUND_HASH_SIZE 256
+
+static allocated_sound_t *sound_hash[SOUND_HASH_SIZE];
 
 static allocated_sound_t *allocated_sounds_head = NULL;
 static allocated_sound_t *allocated_sounds_tail = NULL;
 static int allocated_sounds_size = 0;
 
+// Cache counters, shown by I_SfxCacheDevMessages.
+
+static unsigned int cache_hits = 0;
+static unsigned int cache_misses = 0;
+static unsigned int cache_evictions = 0;
+static int cache_entries = 0;
 
-// Hook a sound into the linked list at the head.
+static unsigned int SoundHash(sfxinfo_t *sfxinfo, int pitch)
+{
+    uintptr_t key = (uintptr_t) sfxinfo;
+
+    key = (key >> 4) ^ (key >> 12) ^ ((uintptr_t) pitch * 0x9e3779b1u);
+
+    return key & (SOUND_HASH_SIZE - 1);
+}
+
+static void SoundHashInsert(allocated_sound_t *snd)
+{
+    unsigned int h = SoundHash(snd->sfxinfo, snd->pitch);
+
+    snd->hash_next = sound_hash[h];
+    sound_hash[h] = snd;
+}
+
+static void SoundHashRemove(allocated_sound_t *snd)
+{
+    allocated_sound_t **p = &sound_hash[SoundHash(snd->sfxinfo, snd->pitch)];
+
+    while (*p != snd)
+    {
+        p = &(*p)->hash_next;
+    }
+
+    *p = snd->hash_next;
+}
+
+// Hook a sound into the LRU list at the head.
 
 static void AllocatedSoundLink(allocated_sound_t *snd)
 {
@@ -112,7 +190,7 @@ static void AllocatedSoundLink(allocated_sound_t *snd)
     }
 }
 
-// Unlink a sound from the linked list.
+// Unlink a sound from the LRU list.
 
 static void AllocatedSoundUnlink(allocated_sound_t *snd)
 {
@@ -137,41 +215,39 @@ static void AllocatedSoundUnlink(allocated_sound_t *snd)
 
 static void FreeAllocatedSound(allocated_sound_t *snd)
 {
-    // Unlink from linked list.
+    // Only unlocked sounds are on the LRU list.
+
+    if (snd->use_count == 0)
+    {
+        AllocatedSoundUnlink(snd);
+    }
 
-    AllocatedSoundUnlink(snd);
+    SoundHashRemove(snd);
 
     // Keep track of the amount of allocated sound data:
 
     allocated_sounds_size -= snd->chunk.alen;
+    --cache_entries;
 
     free(snd);
 }
 
-// Search from the tail backwards along the allocated sounds list, find
-// and free a sound that is not in use, to free up memory.  Return true
-// for success.
+// Free the least recently used sound that is not in use, to free up
+// memory.  Return true for success.
 
 static bool FindAndFreeSound(void)
 {
-    allocated_sound_t *snd;
-
-    snd = allocated_sounds_tail;
-
-    while (snd != NULL)
+    if (allocated_sounds_tail == NULL)
     {
-        if (snd->use_count == 0)
-        {
-            FreeAllocatedSound(snd);
-            return true;
-        }
+        // No available sounds to free...
 
-        snd = snd->prev;
+        return false;
     }
 
-    // No available sounds to free...
+    FreeAllocatedSound(allocated_sounds_tail);
+    ++cache_evictions;
 
-    return false;
+    return true;
 }
 
 // Enforce SFX cache size limit.  We are just about to allocate "len"
@@ -201,7 +277,8 @@ static void ReserveCacheSpace(size_t len)
 
 // Allocate a block for a new sound effect.
 
-static allocated_sound_t *AllocateSound(sfxinfo_t *sfxinfo, size_t len)
+static allocated_sound_t *AllocateSound(sfxinfo_t *sfxinfo, int pitch,
+                                        size_t len)
 {
     allocated_sound_t *snd;
 
@@ -232,7 +309,7 @@ static allocated_sound_t *AllocateSound(sfxinfo_t *sfxinfo, size_t len)
     snd->chunk.alen = len;
     snd->chunk.allocated = 1;
     snd->chunk.volume = MIX_MAX_VOLUME;
-    snd->pitch = NORM_PITCH;
+    snd->pitch = pitch;
 
     snd->sfxinfo = sfxinfo;
     snd->use_count = 0;
@@ -240,7 +317,9 @@ static allocated_sound_t *AllocateSound(sfxinfo_t *sfxinfo, size_t len)
     // Keep track of how much memory all these cached sounds are using...
 
     allocated_sounds_size += len;
+    ++cache_entries;
 
+    SoundHashInsert(snd);
     AllocatedSoundLink(snd);
 
     return snd;
@@ -250,17 +329,16 @@ static allocated_sound_t *AllocateSound(sfxinfo_t *sfxinfo, size_t len)
 
 static void LockAllocatedSound(allocated_sound_t *snd)
 {
-    // Increase use count, to stop the sound being freed.
+    // A locked sound cannot be freed, so take it off the LRU list.
+
+    if (snd->use_count == 0)
+    {
+        AllocatedSoundUnlink(snd);
+    }
 
     ++snd->use_count;
 
     //printf("++ %s: Use count=%i\n", snd->sfxinfo->name, snd->use_count);
-
-    // When we use a sound, re-link it into the list at the head, so
-    // that the oldest sounds fall to the end of the list for freeing.
-
-    AllocatedSoundUnlink(snd);
-    AllocatedSoundLink(snd);
 }
 
 // Unlock a sound to indicate that it may now be freed.
@@ -275,14 +353,22 @@ static void UnlockAllocatedSound(allocated_sound_t *snd)
     --snd->use_count;
 
     //printf("-- %s: Use count=%i\n", snd->sfxinfo->name, snd->use_count);
+
+    // Once nothing is using the sound, it is the most recently used
+    // candidate for freeing.
+
+    if (snd->use_count == 0)
+    {
+        AllocatedSoundLink(snd);
+    }
 }
 
-// Search through the list of allocated sounds and return the one that matches
-// the supplied sfxinfo entry and pitch level.
+// Return the allocated sound that matches the supplied sfxinfo entry
+// and pitch level.
 
 static allocated_sound_t * GetAllocatedSoundBySfxInfoAndPitch(sfxinfo_t *sfxinfo, int pitch)
 {
-    allocated_sound_t * p = allocated_sounds_head;
+    allocated_sound_t * p = sound_hash[SoundHash(sfxinfo, pitch)];
 
     while (p != NULL)
     {
@@ -290,7 +376,7 @@ static allocated_sound_t * GetAllocatedSoundBySfxInfoAndPitch(sfxinfo_t *sfxinfo
         {
             return p;
         }
-        p = p->next;
+        p = p->hash_next;
     }
 
     return NULL;
@@ -319,14 +405,13 @@ static allocated_sound_t * PitchShift(allocated_sound_t *insnd, int pitch)
         dstlen++;
     }
 
-    outsnd = AllocateSound(insnd->sfxinfo, dstlen);
+    outsnd = AllocateSound(insnd->sfxinfo, pitch, dstlen);
 
     if (!outsnd)
     {
         return NULL;
     }
 
-    outsnd->pitch = pitch;
     dstbuf = (Sint16 *)outsnd->chunk.abuf;
 
     // loop over output buffer. find corresponding input cell, copy over
@@ -402,19 +487,16 @@ static int SRC_ConversionMode(void)
 // Returns number of clipped samples.
 // DWF 2008-02-10 with cleanups by Simon Howard.
 
-static bool ExpandSoundData_SRC(sfxinfo_t *sfxinfo,
-                                   byte *data,
-                                   int samplerate,
-                                   int length)
+static bool ExpandSoundData_SRC(sfxjob_t *job)
 {
     SRC_DATA src_data;
     float *data_in;
     uint32_t i, abuf_index=0, clipped=0;
-//    uint32_t alen;
     int retn;
     int16_t *expanded;
-    allocated_sound_t *snd;
-    Mix_Chunk *chunk;
+    byte *data = job->data;
+    int samplerate = job->samplerate;
+    int length = job->length;
 
     src_data.input_frames = length;
     data_in = malloc(length * sizeof(float));
@@ -442,19 +524,19 @@ static bool ExpandSoundData_SRC(sfxinfo_t *sfxinfo,
     retn = src_simple(&src_data, SRC_ConversionMode(), 1);
     assert(retn == 0);
 
-    // Allocate the new chunk.
-
-//    alen = src_data.output_frames_gen * 4;
+    // Allocate the converted sound.
 
-    snd = AllocateSound(sfxinfo, src_data.output_frames_gen * 4);
+    job->output_len = src_data.output_frames_gen * 4;
+    job->output = malloc(job->output_len);
 
-    if (snd == NULL)
+    if (job->output == NULL)
     {
+        free(data_in);
+        free(src_data.data_out);
         return false;
     }
 
-    chunk = &snd->chunk;
-    expanded = (int16_t *) chunk->abuf;
+    expanded = (int16_t *) job->output;
 
     // Convert the result back into 16-bit integers.
 
@@ -509,8 +591,8 @@ static bool ExpandSoundData_SRC(sfxinfo_t *sfxinfo,
     if (clipped > 0)
     {
         fprintf(stderr, "Sound '%s': clipped %u samples (%0.2f %%)\n", 
-                        sfxinfo->name, clipped,
-                        400.0 * clipped / chunk->alen);
+                        job->sfxinfo->name, clipped,
+                        400.0 * clipped / job->output_len);
     }
 
     return true;
@@ -600,15 +682,13 @@ static void WriteWAV(char *filename, byte *data,
 // Generic sound expansion function for any sample rate.
 // Returns number of clipped samples (always 0).
 
-static bool ExpandSoundData_SDL(sfxinfo_t *sfxinfo,
-                                   byte *data,
-                                   int samplerate,
-                                   int length)
+static bool ExpandSoundData_SDL(sfxjob_t *job)
 {
     SDL_AudioCVT convertor;
-    allocated_sound_t *snd;
-    Mix_Chunk *chunk;
     uint32_t expanded_length;
+    byte *data = job->data;
+    int samplerate = job->samplerate;
+    int length = job->length;
 
     // Calculate the length of the expanded version of the sample.
 
@@ -618,17 +698,16 @@ static bool ExpandSoundData_SDL(sfxinfo_t *sfxinfo,
 
     expanded_length *= 4;
 
-    // Allocate a chunk in which to expand the sound
+    // Allocate a buffer in which to expand the sound
 
-    snd = AllocateSound(sfxinfo, expanded_length);
+    job->output = malloc(expanded_length);
+    job->output_len = expanded_length;
 
-    if (snd == NULL)
+    if (job->output == NULL)
     {
         return false;
     }
 
-    chunk = &snd->chunk;
-
     // If we can, use the standard / optimized SDL conversion routines.
 
     if (samplerate <= mixer_freq
@@ -644,12 +723,12 @@ static bool ExpandSoundData_SDL(sfxinfo_t *sfxinfo,
 
         SDL_ConvertAudio(&convertor);
 
-        memcpy(chunk->abuf, convertor.buf, chunk->alen);
+        memcpy(job->output, convertor.buf, job->output_len);
         free(convertor.buf);
     }
     else
     {
-        Sint16 *expanded = (Sint16 *) chunk->abuf;
+        Sint16 *expanded = (Sint16 *) job->output;
         int expanded_length;
         int expand_ratio;
         int i;
@@ -714,10 +793,10 @@ static bool ExpandSoundData_SDL(sfxinfo_t *sfxinfo,
     return true;
 }
 
-// Load and convert a sound effect
-// Returns true if successful
+// Load a sound effect lump and check its header.
+// Returns true if this is a valid sound.
 
-static bool CacheSFX(sfxinfo_t *sfxinfo)
+static bool PrepareSfxJob(sfxinfo_t *sfxinfo, sfxjob_t *job)
 {
     int lumpnum;
     unsigned int lumplen;
@@ -738,6 +817,7 @@ static bool CacheSFX(sfxinfo_t *sfxinfo)
     {
         // Invalid sound
 
+        W_ReleaseLumpNum(lumpnum);
         return false;
     }
 
@@ -757,18 +837,201 @@ static bool CacheSFX(sfxinfo_t *sfxinfo)
 
     if (length > lumplen - 8 || length <= 48)
     {
+        W_ReleaseLumpNum(lumpnum);
         return false;
     }
 
+    job->sfxinfo = sfxinfo;
+    job->lumpnum = lumpnum;
+
     // The DMX sound library seems to skip the first 16 and last 16
     // bytes of the lump - reason unknown.
 
-    data += 16;
-    length -= 32;
+    job->data = data + 8 + 16;
+    job->length = length - 32;
+    job->samplerate = samplerate;
+    job->output = NULL;
+    job->output_len = 0;
 
-    // Sample rate conversion
+    // The converted sound depends on the lump contents and on
+    // everything that affects the conversion.
 
-    if (!ExpandSoundData(sfxinfo, data + 8, samplerate, length))
+    if (sfx_cache_dir != NULL)
+    {
+        sha1_context_t context;
+        uint32_t scale;
+
+        memcpy(&scale, &libsamplerate_scale, sizeof(scale));
+
+        SHA1_Init(&context);
+        SHA1_UpdateInt32(&context, SFX_CACHE_VERSION);
+        SHA1_Update(&context, data, lumplen);
+        SHA1_UpdateInt32(&context, mixer_freq);
+        SHA1_UpdateInt32(&context, mixer_format);
+        SHA1_UpdateInt32(&context, mixer_channels);
+        SHA1_UpdateInt32(&context, use_libsamplerate);
+        SHA1_UpdateInt32(&context, scale);
+        SHA1_Final(job->key, &context);
+    }
+
+    return true;
+}
+
+// Convert a sound effect to the mixer format.
+// Safe to call from any thread.
+
+static void ConvertSfxJob(sfxjob_t *job)
+{
+    if (!ExpandSoundData(job))
+    {
+        free(job->output);
+        job->output = NULL;
+    }
+}
+
+//
+// SFX DISK CACHE
+// Each converted sound is stored in a file named after its key:
+// an 8 byte magic, the 32-bit little endian length and the samples.
+//
+
+#define SFX_CACHE_MAGIC "BRMSFX01"
+
+static char *SfxCacheFileName(const sfxjob_t *job)
+{
+    char hash_str[sizeof(sha1_digest_t) * 2 + 1];
+
+    for (unsigned int i = 0; i < sizeof(sha1_digest_t); ++i)
+    {
+        M_snprintf(hash_str + i * 2, sizeof(hash_str) - i * 2,
+                   "%02x", job->key[i]);
+    }
+
+    return M_StringJoin(sfx_cache_dir, hash_str, ".pcm", NULL);
+}
+
+static bool LoadCachedSfx(sfxjob_t *job)
+{
+    char magic[8];
+    byte len_buf[4];
+    char *filename;
+    FILE *stream;
+    long filelen;
+
+    if (sfx_cache_dir == NULL)
+    {
+        return false;
+    }
+
+    filename = SfxCacheFileName(job);
+    stream = M_fopen(filename, "rb");
+    free(filename);
+
+    if (stream == NULL)
+    {
+        return false;
+    }
+
+    filelen = M_FileLength(stream);
+
+    if (fread(magic, 1, sizeof(magic), stream) != sizeof(magic)
+     || memcmp(magic, SFX_CACHE_MAGIC, sizeof(magic)) != 0
+     || fread(len_buf, 1, sizeof(len_buf), stream) != sizeof(len_buf))
+    {
+        fclose(stream);
+        return false;
+    }
+
+    job->output_len = len_buf[0] | (len_buf[1] << 8)
+                    | (len_buf[2] << 16) | ((uint32_t) len_buf[3] << 24);
+
+    // Reject files cut short.
+
+    if (filelen != (long) (sizeof(magic) + sizeof(len_buf) + job->output_len))
+    {
+        fclose(stream);
+        return false;
+    }
+
+    job->output = malloc(job->output_len);
+
+    if (job->output == NULL
+     || fread(job->output, 1, job->output_len, stream) != job->output_len)
+    {
+        free(job->output);
+        job->output = NULL;
+        fclose(stream);
+        return false;
+    }
+
+    fclose(stream);
+
+    return true;
+}
+
+static void StoreCachedSfx(const sfxjob_t *job)
+{
+    byte len_buf[4];
+    char *filename;
+    FILE *stream;
+
+    filename = SfxCacheFileName(job);
+    stream = M_fopen(filename, "wb");
+
+    if (stream == NULL)
+    {
+        free(filename);
+        return;
+    }
+
+    len_buf[0] = job->output_len & 0xff;
+    len_buf[1] = (job->output_len >> 8) & 0xff;
+    len_buf[2] = (job->output_len >> 16) & 0xff;
+    len_buf[3] = (job->output_len >> 24) & 0xff;
+
+    fwrite(SFX_CACHE_MAGIC, 1, 8, stream);
+    fwrite(len_buf, 1, sizeof(len_buf), stream);
+
+    if (fwrite(job->output, 1, job->output_len, stream) != job->output_len)
+    {
+        // A short file is rejected by LoadCachedSfx, but don't leave
+        // it lying around.
+
+        fclose(stream);
+        remove(filename);
+        free(filename);
+        return;
+    }
+
+    fclose(stream);
+    free(filename);
+}
+
+// Put a converted sound effect into the allocated sounds list.
+// Returns true if successful
+
+static bool FinishSfxJob(sfxjob_t *job)
+{
+    allocated_sound_t *snd = NULL;
+
+    if (job->output != NULL)
+    {
+        snd = AllocateSound(job->sfxinfo, NORM_PITCH, job->output_len);
+    }
+
+    if (snd != NULL)
+    {
+        memcpy(snd->chunk.abuf, job->output, job->output_len);
+    }
+
+    free(job->output);
+    job->output = NULL;
+
+    // don't need the original lump any more
+
+    W_ReleaseLumpNum(job->lumpnum);
+
+    if (snd == NULL)
     {
         return false;
     }
@@ -776,22 +1039,41 @@ static bool CacheSFX(sfxinfo_t *sfxinfo)
 #ifdef DEBUG_DUMP_WAVS
     {
         char filename[16];
-        allocated_sound_t * snd;
 
         M_snprintf(filename, sizeof(filename), "%s.wav",
-                   DEH_String(sfxinfo->name));
-        snd = GetAllocatedSoundBySfxInfoAndPitch(sfxinfo, NORM_PITCH);
-        WriteWAV(filename, snd->chunk.abuf, snd->chunk.alen,mixer_freq);
+                   DEH_String(job->sfxinfo->name));
+        WriteWAV(filename, snd->chunk.abuf, snd->chunk.alen, mixer_freq);
     }
 #endif
 
-    // don't need the original lump any more
-  
-    W_ReleaseLumpNum(lumpnum);
-
     return true;
 }
 
+// Load and convert a sound effect
+// Returns true if successful
+
+static bool CacheSFX(sfxinfo_t *sfxinfo)
+{
+    sfxjob_t job;
+
+    if (!PrepareSfxJob(sfxinfo, &job))
+    {
+        return false;
+    }
+
+    if (!LoadCachedSfx(&job))
+    {
+        ConvertSfxJob(&job);
+
+        if (job.output != NULL && sfx_cache_dir != NULL)
+        {
+            StoreCachedSfx(&job);
+        }
+    }
+
+    return FinishSfxJob(&job);
+}
+
 static void GetSfxLumpName(sfxinfo_t *sfx, char *buf, size_t buf_len)
 {
     // Linked sfx lumps? Get the lump number for the sound linked to.
@@ -814,15 +1096,121 @@ static void GetSfxLumpName(sfxinfo_t *sfx, char *buf, size_t buf_len)
     }
 }
 
-// Preload all the sound effects - stops nasty ingame freezes
+// Jobs to convert, shared by the precache worker threads.
+
+static sfxjob_t **pending_jobs;
+static int num_pending_jobs;
+static SDL_atomic_t next_pending_job;
+
+static int SfxWorkerThread(void *unused)
+{
+    int i;
+
+    while ((i = SDL_AtomicAdd(&next_pending_job, 1)) < num_pending_jobs)
+    {
+        ConvertSfxJob(pending_jobs[i]);
+    }
+
+    return 0;
+}
+
+// Convert all pending jobs, on as many threads as there are CPUs.
+
+static void RunPendingSfxJobs(void)
+{
+    SDL_Thread *workers[MAX_SFX_WORKERS];
+    int num_workers;
+    int i;
+
+    SDL_AtomicSet(&next_pending_job, 0);
+
+    // This thread does its share of the work too.
+
+    num_workers = SDL_GetCPUCount() - 1;
+
+    if (num_workers > MAX_SFX_WORKERS)
+    {
+        num_workers = MAX_SFX_WORKERS;
+    }
+    if (num_workers > num_pending_jobs - 1)
+    {
+        num_workers = num_pending_jobs - 1;
+    }
+
+    for (i = 0; i < num_workers; ++i)
+    {
+        workers[i] = SDL_CreateThread(SfxWorkerThread, "sfx", NULL);
+
+        if (workers[i] == NULL)
+        {
+            break;
+        }
+    }
+
+    num_workers = i;
+
+    SfxWorkerThread(NULL);
+
+    for (i = 0; i < num_workers; ++i)
+    {
+        SDL_WaitThread(workers[i], NULL);
+    }
+}
+
+// Preload all the sound effects - stops nasty ingame freezes.
+// Lumps are loaded and sounds added to the cache on this thread,
+// only the conversion itself runs in parallel.
 
 static void I_SDL_PrecacheSounds(sfxinfo_t *sounds, int num_sounds)
 {
     char namebuf[9];
+    sfxjob_t *jobs;
+    bool *prepared;
     int i;
 
     printf("I_SDL_PrecacheSounds: Precaching all sound effects..");
 
+    jobs = calloc(num_sounds, sizeof(*jobs));
+    prepared = calloc(num_sounds, sizeof(*prepared));
+    pending_jobs = calloc(num_sounds, sizeof(*pending_jobs));
+    num_pending_jobs = 0;
+
+    if (jobs == NULL || prepared == NULL || pending_jobs == NULL)
+    {
+        I_Error("I_SDL_PrecacheSounds: Out of memory");
+    }
+
+    for (i=0; i<num_sounds; ++i)
+    {
+        GetSfxLumpName(&sounds[i], namebuf, sizeof(namebuf));
+
+        sounds[i].lumpnum = W_CheckNumForName(namebuf);
+
+        if (sounds[i].lumpnum != -1
+         && PrepareSfxJob(&sounds[i], &jobs[i]))
+        {
+            prepared[i] = true;
+
+            if (!LoadCachedSfx(&jobs[i]))
+            {
+                pending_jobs[num_pending_jobs++] = &jobs[i];
+            }
+        }
+    }
+
+    printf(".");
+    fflush(stdout);
+
+    RunPendingSfxJobs();
+
+    for (i=0; i<num_pending_jobs; ++i)
+    {
+        if (pending_jobs[i]->output != NULL && sfx_cache_dir != NULL)
+        {
+            StoreCachedSfx(pending_jobs[i]);
+        }
+    }
+
     for (i=0; i<num_sounds; ++i)
     {
         if ((i % 6) == 0)
@@ -831,16 +1219,18 @@ static void I_SDL_PrecacheSounds(sfxinfo_t *sounds, int num_sounds)
             fflush(stdout);
         }
 
-        GetSfxLumpName(&sounds[i], namebuf, sizeof(namebuf));
-
-        sounds[i].lumpnum = W_CheckNumForName(namebuf);
-
-        if (sounds[i].lumpnum != -1)
+        if (prepared[i])
         {
-            CacheSFX(&sounds[i]);
+            FinishSfxJob(&jobs[i]);
         }
     }
 
+    free(jobs);
+    free(prepared);
+    free(pending_jobs);
+    pending_jobs = NULL;
+    num_pending_jobs = 0;
+
     printf("\n");
 }
 
@@ -848,16 +1238,28 @@ static void I_SDL_PrecacheSounds(sfxinfo_t *sounds, int num_sounds)
 
 static bool LockSound(sfxinfo_t *sfxinfo)
 {
+    allocated_sound_t *snd;
+
+    snd = GetAllocatedSoundBySfxInfoAndPitch(sfxinfo, NORM_PITCH);
+
     // If the sound isn't loaded, load it now
-    if (GetAllocatedSoundBySfxInfoAndPitch(sfxinfo, NORM_PITCH) == NULL)
+    if (snd == NULL)
     {
+        ++cache_misses;
+
         if (!CacheSFX(sfxinfo))
         {
             return false;
         }
+
+        snd = GetAllocatedSoundBySfxInfoAndPitch(sfxinfo, NORM_PITCH);
+    }
+    else
+    {
+        ++cache_hits;
     }
 
-    LockAllocatedSound(GetAllocatedSoundBySfxInfoAndPitch(sfxinfo, NORM_PITCH));
+    LockAllocatedSound(snd);
 
     return true;
 }
@@ -945,6 +1347,7 @@ static int I_SDL_StartSound(sfxinfo_t *sfxinfo, int channel, int vol, int sep, i
 
         if (snd_pitchshift)
         {
+            ++cache_misses;
             newsnd = PitchShift(snd, pitch);
 
             if (newsnd)
@@ -957,6 +1360,11 @@ static int I_SDL_StartSound(sfxinfo_t *sfxinfo, int channel, int vol, int sep, i
     }
     else
     {
+        if (pitch != NORM_PITCH)
+        {
+            ++cache_hits;
+        }
+
         LockAllocatedSound(snd);
     }
 
@@ -1029,6 +1437,9 @@ static void I_SDL_ShutdownSound(void)
     Mix_CloseAudio();
     SDL_QuitSubSystem(SDL_INIT_AUDIO);
 
+    free(sfx_cache_dir);
+    sfx_cache_dir = NULL;
+
     sound_initialized = false;
 }
 
@@ -1097,6 +1508,16 @@ static bool I_SDL_InitSound(bool _use_sfx_prefix)
         }
 
         ExpandSoundData = ExpandSoundData_SRC;
+
+        // Conversion with libsamplerate is slow enough to be worth
+        // keeping the results.
+
+        if (snd_diskcache && strcmp(configdir, "") != 0)
+        {
+            sfx_cache_dir = M_StringJoin(configdir, "sfxcache",
+                                         DIR_SEPARATOR_S, NULL);
+            M_MakeDirectory(sfx_cache_dir);
+        }
     }
 #else
     if (use_libsamplerate != 0)
@@ -1126,6 +1547,73 @@ static const snddevice_t sound_sdl_devices[] =
     SNDDEVICE_AWE32,
 };
 
+void I_SfxCacheDevMessages(char *result, size_t result_len)
+{
+    M_snprintf(result, result_len,
+               "SFX cache:\n"
+               "entries: %i\n"
+               "size: %i / %i\n"
+               "hits: %u\n"
+               "misses: %u\n"
+               "evictions: %u\n",
+               cache_entries, allocated_sounds_size, snd_cachesize,
+               cache_hits, cache_misses, cache_evictions);
+}
+
+//
+// Convert a sound effect to 16-bit stereo at the given rate, through the
+// same header checks and converter (chosen by use_libsamplerate) as the
+// game uses for the mixer. For the offline renderer, which never opens
+// the audio device. The samples are allocated with malloc.
+//
+
+bool I_SDL_ConvertSfx(sfxinfo_t *sfxinfo, int freq,
+                      int16_t **samples, uint32_t *num_frames)
+{
+    sfxjob_t job;
+
+    if (sound_initialized)
+    {
+        I_Error("I_SDL_ConvertSfx: Sound is already initialized");
+    }
+
+    mixer_freq = freq;
+    mixer_format = AUDIO_S16SYS;
+    mixer_channels = 2;
+    ExpandSoundData = ExpandSoundData_SDL;
+
+#ifdef HAVE_LIBSAMPLERATE
+    if (use_libsamplerate != 0)
+    {
+        if (SRC_ConversionMode() < 0)
+        {
+            I_Error("I_SDL_ConvertSfx: Invalid value for use_libsamplerate: %i",
+                    use_libsamplerate);
+        }
+
+        ExpandSoundData = ExpandSoundData_SRC;
+    }
+#endif
+
+    if (!PrepareSfxJob(sfxinfo, &job))
+    {
+        return false;
+    }
+
+    ConvertSfxJob(&job);
+    W_ReleaseLumpNum(job.lumpnum);
+
+    if (job.output == NULL)
+    {
+        return false;
+    }
+
+    *samples = (int16_t *) job.output;
+    *num_frames = job.output_len / 4;
+
+    return true;
+}
+
 const sound_module_t sound_sdl_module =
 {
     sound_sdl_devices,
@@ -1142,4 +1630,17 @@ const sound_module_t sound_sdl_module =
 };
 
 
+#else // DISABLE_SDL2MIXER
+
+void I_SfxCacheDevMessages(char *result, size_t result_len)
+{
+    M_snprintf(result, result_len, "No SFX cache!");
+}
+
+bool I_SDL_ConvertSfx(sfxinfo_t *sfxinfo, int freq,
+                      int16_t **samples, uint32_t *num_frames)
+{
+    return false;
+}
+
 #endif // DISABLE_SDL2MIXER
@@ -16,14 +16,20 @@
 //
 
 
+#include <stdlib.h>
+#include <string.h>
+
 #include "config.h"
 #include "doomtype.h"
 
 #include "gusconf.h"
 #include "i_sound.h"
+#include "i_system.h"
 #include "i_video.h"
 #include "m_argv.h"
 #include "m_config.h"
+#include "memio.h"
+#include "mus2mid.h"
 
 // Sound sample rate to use for digital output (Hz)
 
@@ -62,6 +68,19 @@ static bool music_packs_active = false;
 // depending on whether the current track is substituted.
 static const music_module_t *active_music_module;
 
+// MIDI data converted from MUS lumps. Songs are kept until shutdown, so
+// returning to a level does not convert its music again.
+typedef struct {
+    int lumpnum;
+    int len;
+    void* midi;
+    size_t midi_len;
+} converted_song_t;
+
+static converted_song_t* converted_songs = NULL;
+static int num_converted_songs = 0;
+static int converted_songs_alloced = 0;
+
 
 // DOS-specific options: These are unused but should be maintained
 // so that the config file can be shared between Broom and doom.exe
@@ -76,6 +95,7 @@ static int snd_mport = 0;
 static const sound_module_t *sound_modules[] =
 {
 #ifndef DISABLE_SDL2MIXER
+    &sound_mix_module,
     &sound_sdl_module,
 #endif // DISABLE_SDL2MIXER
     &sound_pcsound_module,
@@ -348,6 +368,13 @@ void I_InitMusic(void)
 
 void I_ShutdownMusic(void)
 {
+    for (int i = 0; i < num_converted_songs; ++i) {
+        free(converted_songs[i].midi);
+    }
+    free(converted_songs);
+    converted_songs = NULL;
+    num_converted_songs = 0;
+    converted_songs_alloced = 0;
 }
 
 void I_SetMusicVolume(int volume) {
@@ -371,7 +398,60 @@ void I_ResumeSong(void) {
     }
 }
 
-void* I_RegisterSong(void* data, int len) {
+static bool IsMid(const byte* mem, int len) {
+    return len > 4 && !memcmp(mem, "MThd", 4);
+}
+
+//
+// Convert a MUS lump to MIDI, or return the copy converted earlier. The
+// result is owned by the cache. Returns false if the data is not MUS.
+//
+static bool ConvertSong(void* data, int len, int lumpnum,
+                        void** midi, size_t* midi_len) {
+    for (int i = 0; i < num_converted_songs; ++i) {
+        converted_song_t* song = &converted_songs[i];
+        if (song->lumpnum == lumpnum && song->len == len) {
+            *midi = song->midi;
+            *midi_len = song->midi_len;
+            return true;
+        }
+    }
+
+    MEMFILE* instream = mem_fopen_read(data, len);
+    MEMFILE* outstream = mem_fopen_write();
+    bool result = mus2mid(instream, outstream) == 0;
+
+    if (result) {
+        void* outbuf;
+        size_t outbuf_len;
+
+        mem_get_buf(outstream, &outbuf, &outbuf_len);
+
+        if (num_converted_songs == converted_songs_alloced) {
+            converted_songs_alloced = converted_songs_alloced
+                                    ? converted_songs_alloced * 2 : 16;
+            converted_songs = I_Realloc(converted_songs,
+                converted_songs_alloced * sizeof(*converted_songs));
+        }
+
+        converted_song_t* song = &converted_songs[num_converted_songs++];
+        song->lumpnum = lumpnum;
+        song->len = len;
+        song->midi = malloc(outbuf_len);
+        song->midi_len = outbuf_len;
+        memcpy(song->midi, outbuf, outbuf_len);
+
+        *midi = song->midi;
+        *midi_len = song->midi_len;
+    }
+
+    mem_fclose(instream);
+    mem_fclose(outstream);
+
+    return result;
+}
+
+void* I_RegisterSong(void* data, int len, int lumpnum) {
     // If the music pack module is active, check to see if there is a
     // valid substitution for this track. If there is, we set the
     // active_music_module pointer to the music pack module for the
@@ -387,6 +467,17 @@ void* I_RegisterSong(void* data, int len) {
     // No substitution for this track, so use the main module.
     active_music_module = music_module;
     if (active_music_module) {
+        void* midi;
+        size_t midi_len;
+
+        // MUS files begin with "MUS"; anything else that is not a MIDI
+        // file is passed through for the module to reject.
+        if (!IsMid(data, len)
+         && ConvertSong(data, len, lumpnum, &midi, &midi_len)) {
+            data = midi;
+            len = (int) midi_len;
+        }
+
         return active_music_module->RegisterSong(data, len);
     }
     return NULL;
@@ -456,6 +547,7 @@ void I_BindSoundVariables(void) {
     M_BindStringVariable("snd_dmxoption",        &snd_dmxoption);
     M_BindIntVariable("snd_samplerate",          &snd_samplerate);
     M_BindIntVariable("snd_cachesize",           &snd_cachesize);
+    M_BindIntVariable("snd_nativemixer",         &snd_nativemixer);
     M_BindIntVariable("opl_io_port",             &opl_io_port);
     M_BindIntVariable("snd_pitchshift",          &snd_pitchshift);
     M_BindStringVariable("music_pack_path",      &music_pack_path);
@@ -464,6 +556,7 @@ void I_BindSoundVariables(void) {
     M_BindIntVariable("gus_ram_kb",              &gus_ram_kb);
     M_BindIntVariable("use_libsamplerate",       &use_libsamplerate);
     M_BindFloatVariable("libsamplerate_scale",   &libsamplerate_scale);
+    M_BindIntVariable("snd_diskcache",           &snd_diskcache);
 
 #ifdef _WIN32
     I_BindWinSoundVariables();
@@ -193,6 +193,8 @@ typedef struct
 
     // Register a song handle from data
     // Returns a handle that can be used to play the song
+    // MUS lumps have already been converted to MIDI, except for the
+    // music pack module, which is given the original lump data.
 
     void *(*RegisterSong)(void *data, int len);
 
@@ -222,7 +224,7 @@ void I_ShutdownMusic(void);
 void I_SetMusicVolume(int volume);
 void I_PauseSong(void);
 void I_ResumeSong(void);
-void *I_RegisterSong(void *data, int len);
+void *I_RegisterSong(void *data, int len, int lumpnum);
 void I_UnRegisterSong(void *handle);
 void I_PlaySong(void *handle, bool looping);
 void I_StopSong(void);
@@ -232,12 +234,14 @@ extern int snd_sfxdevice;
 extern int snd_musicdevice;
 extern int snd_samplerate;
 extern int snd_cachesize;
+extern int snd_nativemixer;
 extern int snd_maxslicetime_ms;
 extern char *snd_musiccmd;
 extern int snd_pitchshift;
 extern char *snd_dmxoption;
 extern int use_libsamplerate;
 extern float libsamplerate_scale;
+extern int snd_diskcache;
 
 void I_BindSoundVariables(void);
 
@@ -250,10 +254,14 @@ typedef enum {
 
 void I_SetOPLDriverVer(opl_driver_ver_t ver);
 void I_OPL_DevMessages(char *, size_t);
+void I_SfxCacheDevMessages(char *, size_t);
+bool I_SDL_ConvertSfx(sfxinfo_t *sfxinfo, int freq,
+                      int16_t **samples, uint32_t *num_frames);
 
 // Sound modules
 
 void I_InitTimidityConfig(void);
+extern const sound_module_t sound_mix_module;
 extern const sound_module_t sound_sdl_module;
 extern const sound_module_t sound_pcsound_module;
 extern const music_module_t music_sdl_module;
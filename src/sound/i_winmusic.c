@@ -28,8 +28,6 @@
 #include "i_sound.h"
 #include "i_system.h"
 #include "m_misc.h"
-#include "memio.h"
-#include "mus2mid.h"
 #include "midifile.h"
 #include "midifallback.h"
 
@@ -1534,43 +1532,9 @@ static void I_WIN_ResumeSong(void)
     win_midi_state = STATE_PLAYING;
 }
 
-// Determine whether memory block is a .mid file 
-
-static bool IsMid(byte *mem, int len)
-{
-    return len > 4 && !memcmp(mem, "MThd", 4);
-}
-
-static bool ConvertMus(byte *musdata, int len, const char *filename)
-{
-    MEMFILE *instream;
-    MEMFILE *outstream;
-    void *outbuf;
-    size_t outbuf_len;
-    int result;
-
-    instream = mem_fopen_read(musdata, len);
-    outstream = mem_fopen_write();
-
-    result = mus2mid(instream, outstream);
-
-    if (result == 0)
-    {
-        mem_get_buf(outstream, &outbuf, &outbuf_len);
-
-        M_WriteFile(filename, outbuf, outbuf_len);
-    }
-
-    mem_fclose(instream);
-    mem_fclose(outstream);
-
-    return result;
-}
-
 static void *I_WIN_RegisterSong(void *data, int len)
 {
     unsigned int i;
-    char *filename;
     midi_file_t *file;
 
     MIDIPROPTIMEDIV prop_timediv;
@@ -1582,26 +1546,7 @@ static void *I_WIN_RegisterSong(void *data, int len)
         return NULL;
     }
 
-    // MUS files begin with "MUS"
-    // Reject anything which doesnt have this signature
-
-    filename = M_TempFile("doom.mid");
-
-    if (IsMid(data, len))
-    {
-        M_WriteFile(filename, data, len);
-    }
-    else
-    {
-        // Assume a MUS file and try to convert
-
-        ConvertMus(data, len, filename);
-    }
-
-    file = MIDI_LoadFile(filename);
-
-    M_remove(filename);
-    free(filename);
+    file = MIDI_LoadMemory(data, len);
 
     if (file == NULL)
     {
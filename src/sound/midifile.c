@@ -59,7 +59,7 @@ typedef struct
 
     unsigned int data_len;
 
-    // Events in this track:
+    // Events in this track, in one contiguous array:
 
     midi_event_t *events;
     int num_events;
@@ -80,11 +80,21 @@ struct midi_file_s
     midi_track_t *tracks;
     unsigned int num_tracks;
 
-    // Data buffer used to store data read for SysEx or meta events:
+    // Copy of the file that was loaded. The data of SysEx and meta
+    // events points into this buffer.
     byte *buffer;
     unsigned int buffer_size;
 };
 
+// Position in the MIDI data being read.
+
+typedef struct
+{
+    byte *data;
+    size_t len;
+    size_t pos;
+} midi_stream_t;
+
 // Check the header of a chunk:
 
 static bool CheckChunkHeader(chunk_header_t *chunk,
@@ -108,28 +118,38 @@ static bool CheckChunkHeader(chunk_header_t *chunk,
 
 // Read a single byte.  Returns false on error.
 
-static bool ReadByte(byte *result, FILE *stream)
+static bool ReadByte(byte *result, midi_stream_t *stream)
 {
-    int c;
-
-    c = fgetc(stream);
-
-    if (c == EOF)
+    if (stream->pos >= stream->len)
     {
         fprintf(stderr, "ReadByte: Unexpected end of file\n");
         return false;
     }
-    else
-    {
-        *result = (byte) c;
 
-        return true;
+    *result = stream->data[stream->pos];
+    ++stream->pos;
+
+    return true;
+}
+
+// Read a fixed-size block, such as a chunk header.
+
+static bool ReadBlock(void *result, size_t len, midi_stream_t *stream)
+{
+    if (len > stream->len - stream->pos)
+    {
+        return false;
     }
+
+    memcpy(result, stream->data + stream->pos, len);
+    stream->pos += len;
+
+    return true;
 }
 
 // Read a variable-length value.
 
-static bool ReadVariableLength(unsigned int *result, FILE *stream)
+static bool ReadVariableLength(unsigned int *result, midi_stream_t *stream)
 {
     int i;
     byte b = 0;
@@ -163,36 +183,21 @@ static bool ReadVariableLength(unsigned int *result, FILE *stream)
     return false;
 }
 
-// Read a byte sequence into the data buffer.
+// Skip over a byte sequence, returning a pointer to it in the file
+// buffer.
 
-static void *ReadByteSequence(unsigned int num_bytes, FILE *stream)
+static byte *ReadByteSequence(unsigned int num_bytes, midi_stream_t *stream)
 {
-    unsigned int i;
     byte *result;
 
-    // Allocate a buffer. Allocate one extra byte, as malloc(0) is
-    // non-portable.
-
-    result = malloc(num_bytes + 1);
-
-    if (result == NULL)
+    if (num_bytes > stream->len - stream->pos)
     {
-        fprintf(stderr, "ReadByteSequence: Failed to allocate buffer\n");
+        fprintf(stderr, "ReadByteSequence: Unexpected end of file\n");
         return NULL;
     }
 
-    // Read the data:
-
-    for (i=0; i<num_bytes; ++i)
-    {
-        if (!ReadByte(&result[i], stream))
-        {
-            fprintf(stderr, "ReadByteSequence: Error while reading byte %u\n",
-                            i);
-            free(result);
-            return NULL;
-        }
-    }
+    result = stream->data + stream->pos;
+    stream->pos += num_bytes;
 
     return result;
 }
@@ -203,7 +208,7 @@ static void *ReadByteSequence(unsigned int num_bytes, FILE *stream)
 
 static bool ReadChannelEvent(midi_event_t *event,
                                 byte event_type, bool two_param,
-                                FILE *stream)
+                                midi_stream_t *stream)
 {
     byte b = 0;
 
@@ -243,7 +248,7 @@ static bool ReadChannelEvent(midi_event_t *event,
 // Read sysex event:
 
 static bool ReadSysExEvent(midi_event_t *event, int event_type,
-                              FILE *stream)
+                              midi_stream_t *stream)
 {
     event->event_type = event_type;
 
@@ -269,7 +274,7 @@ static bool ReadSysExEvent(midi_event_t *event, int event_type,
 
 // Read meta event:
 
-static bool ReadMetaEvent(midi_event_t *event, FILE *stream)
+static bool ReadMetaEvent(midi_event_t *event, midi_stream_t *stream)
 {
     byte b = 0;
 
@@ -308,7 +313,7 @@ static bool ReadMetaEvent(midi_event_t *event, FILE *stream)
 }
 
 static bool ReadEvent(midi_event_t *event, unsigned int *last_event_type,
-                         FILE *stream)
+                         midi_stream_t *stream)
 {
     byte event_type = 0;
 
@@ -332,12 +337,7 @@ static bool ReadEvent(midi_event_t *event, unsigned int *last_event_type,
     if ((event_type & 0x80) == 0)
     {
         event_type = *last_event_type;
-
-        if (fseek(stream, -1, SEEK_CUR) < 0)
-        {
-            fprintf(stderr, "ReadEvent: Unable to seek in stream\n");
-            return false;
-        }
+        --stream->pos;
     }
     else
     {
@@ -386,40 +386,13 @@ static bool ReadEvent(midi_event_t *event, unsigned int *last_event_type,
     return false;
 }
 
-// Free an event:
-
-static void FreeEvent(midi_event_t *event)
-{
-    // Some event types have dynamically allocated buffers assigned
-    // to them that must be freed.
-
-    switch (event->event_type)
-    {
-        case MIDI_EVENT_SYSEX:
-        case MIDI_EVENT_SYSEX_SPLIT:
-            free(event->data.sysex.data);
-            break;
-
-        case MIDI_EVENT_META:
-            free(event->data.meta.data);
-            break;
-
-        default:
-            // Nothing to do.
-            break;
-    }
-}
-
 // Read and check the track chunk header
 
-static bool ReadTrackHeader(midi_track_t *track, FILE *stream)
+static bool ReadTrackHeader(midi_track_t *track, midi_stream_t *stream)
 {
-    size_t records_read;
     chunk_header_t chunk_header;
 
-    records_read = fread(&chunk_header, sizeof(chunk_header_t), 1, stream);
-
-    if (records_read < 1)
+    if (!ReadBlock(&chunk_header, sizeof(chunk_header_t), stream))
     {
         return false;
     }
@@ -434,11 +407,12 @@ static bool ReadTrackHeader(midi_track_t *track, FILE *stream)
     return true;
 }
 
-static bool ReadTrack(midi_track_t *track, FILE *stream)
+static bool ReadTrack(midi_track_t *track, midi_stream_t *stream)
 {
-    midi_event_t *new_events;
     midi_event_t *event;
     unsigned int last_event_type;
+    size_t track_len;
+    int max_events;
 
     track->num_events = 0;
     track->events = NULL;
@@ -450,17 +424,27 @@ static bool ReadTrack(midi_track_t *track, FILE *stream)
         return false;
     }
 
-    // Then the events:
+    // Then the events. Most events take three bytes or so, which gives
+    // a first guess at how many there are. The length in the header is
+    // not trusted beyond the data actually left in the stream:
 
     last_event_type = 0;
+    track_len = track->data_len;
+    if (track_len > stream->len - stream->pos)
+    {
+        track_len = stream->len - stream->pos;
+    }
+    max_events = track_len / 3 + 16;
+    track->events = I_Realloc(NULL, sizeof(midi_event_t) * max_events);
 
     for (;;)
     {
-        // Resize the track slightly larger to hold another event:
-
-        new_events = I_Realloc(track->events, 
-                             sizeof(midi_event_t) * (track->num_events + 1));
-        track->events = new_events;
+        if (track->num_events == max_events)
+        {
+            max_events *= 2;
+            track->events = I_Realloc(track->events,
+                                      sizeof(midi_event_t) * max_events);
+        }
 
         // Read the next event:
 
@@ -481,24 +465,15 @@ static bool ReadTrack(midi_track_t *track, FILE *stream)
         }
     }
 
-    return true;
-}
+    // Give back the unused space:
 
-// Free a track:
-
-static void FreeTrack(midi_track_t *track)
-{
-    unsigned int i;
-
-    for (i=0; i<track->num_events; ++i)
-    {
-        FreeEvent(&track->events[i]);
-    }
+    track->events = I_Realloc(track->events,
+                              sizeof(midi_event_t) * track->num_events);
 
-    free(track->events);
+    return true;
 }
 
-static bool ReadAllTracks(midi_file_t *file, FILE *stream)
+static bool ReadAllTracks(midi_file_t *file, midi_stream_t *stream)
 {
     unsigned int i;
 
@@ -528,14 +503,11 @@ static bool ReadAllTracks(midi_file_t *file, FILE *stream)
 
 // Read and check the header chunk.
 
-static bool ReadFileHeader(midi_file_t *file, FILE *stream)
+static bool ReadFileHeader(midi_file_t *file, midi_stream_t *stream)
 {
-    size_t records_read;
     unsigned int format_type;
 
-    records_read = fread(&file->header, sizeof(midi_header_t), 1, stream);
-
-    if (records_read < 1)
+    if (!ReadBlock(&file->header, sizeof(midi_header_t), stream))
     {
         return false;
     }
@@ -571,64 +543,106 @@ void MIDI_FreeFile(midi_file_t *file)
     {
         for (i=0; i<file->num_tracks; ++i)
         {
-            FreeTrack(&file->tracks[i]);
+            free(file->tracks[i].events);
         }
 
         free(file->tracks);
     }
 
+    free(file->buffer);
     free(file);
 }
 
-midi_file_t *MIDI_LoadFile(char *filename)
+// Parse a MIDI file held in a buffer allocated with malloc. The file
+// takes ownership of the buffer: SysEx and meta events point into it.
+
+static midi_file_t *LoadBuffer(byte *buffer, size_t len)
 {
     midi_file_t *file;
-    FILE *stream;
+    midi_stream_t stream;
 
     file = malloc(sizeof(midi_file_t));
 
     if (file == NULL)
     {
+        free(buffer);
         return NULL;
     }
 
     file->tracks = NULL;
     file->num_tracks = 0;
-    file->buffer = NULL;
-    file->buffer_size = 0;
+    file->buffer = buffer;
+    file->buffer_size = len;
 
-    // Open file
+    stream.data = buffer;
+    stream.len = len;
+    stream.pos = 0;
 
-    stream = M_fopen(filename, "rb");
+    // Read MIDI file header
 
-    if (stream == NULL)
+    if (!ReadFileHeader(file, &stream))
     {
-        fprintf(stderr, "MIDI_LoadFile: Failed to open '%s'\n", filename);
         MIDI_FreeFile(file);
         return NULL;
     }
 
-    // Read MIDI file header
+    // Read all tracks:
 
-    if (!ReadFileHeader(file, stream))
+    if (!ReadAllTracks(file, &stream))
     {
-        fclose(stream);
         MIDI_FreeFile(file);
         return NULL;
     }
 
-    // Read all tracks:
+    return file;
+}
 
-    if (!ReadAllTracks(file, stream))
+midi_file_t *MIDI_LoadMemory(void *data, size_t len)
+{
+    byte *buffer;
+
+    buffer = malloc(len + 1);
+
+    if (buffer == NULL)
+    {
+        return NULL;
+    }
+
+    memcpy(buffer, data, len);
+
+    return LoadBuffer(buffer, len);
+}
+
+midi_file_t *MIDI_LoadFile(char *filename)
+{
+    FILE *stream;
+    byte *data;
+    long len;
+
+    // Open file
+
+    stream = M_fopen(filename, "rb");
+
+    if (stream == NULL)
     {
+        fprintf(stderr, "MIDI_LoadFile: Failed to open '%s'\n", filename);
+        return NULL;
+    }
+
+    len = M_FileLength(stream);
+    data = malloc(len + 1);
+
+    if (data == NULL || fread(data, 1, len, stream) < (size_t) len)
+    {
+        fprintf(stderr, "MIDI_LoadFile: Failed to read '%s'\n", filename);
         fclose(stream);
-        MIDI_FreeFile(file);
+        free(data);
         return NULL;
     }
 
     fclose(stream);
 
-    return file;
+    return LoadBuffer(data, len);
 }
 
 // Get the number of tracks in a MIDI file.
@@ -18,6 +18,8 @@
 #ifndef MIDIFILE_H
 #define MIDIFILE_H
 
+#include <stddef.h>
+
 typedef struct midi_file_s midi_file_t;
 typedef struct midi_track_iter_s midi_track_iter_t;
 
@@ -188,6 +190,11 @@ typedef struct
 
 midi_file_t *MIDI_LoadFile(char *filename);
 
+// Load a MIDI file from a memory buffer. The buffer is not needed
+// after this returns.
+
+midi_file_t *MIDI_LoadMemory(void *data, size_t len);
+
 // Free a MIDI file.
 
 void MIDI_FreeFile(midi_file_t *file);
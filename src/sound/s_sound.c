@@ -16,6 +16,7 @@
 //
 
 
+#include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -74,13 +75,61 @@ typedef struct
     int handle;
 
     int pitch;
+
+    // position in the free or busy channel heap
+    int heap_pos;
+
+    // order in which channels were claimed, oldest first
+    unsigned int sequence;
+
+    // volume and separation last passed to the sound module, and the
+    // origin position they were computed for
+    int volume;
+    int sep;
+    fixed_t origin_x;
+    fixed_t origin_y;
 } channel_t;
 
+//
+// Binary heap of channel numbers. Free channels are kept in a heap
+// ordered by channel number, so that the lowest free channel is used
+// first as in Vanilla; busy channels are kept in a heap ordered from
+// least to most important.
+//
+typedef struct
+{
+    int *items;
+    int count;
+    bool (*before)(int a, int b);
+} channel_heap_t;
+
 //
 // The set of channels available
 //
 static channel_t *channels;
 
+static channel_heap_t free_channels;
+static channel_heap_t busy_channels;
+static unsigned int channel_sequence;
+
+//
+// Positional channels gathered by S_UpdateSounds for a batched update.
+//
+static int *batch_cnum;
+static fixed_t *batch_dx;
+static fixed_t *batch_dy;
+static fixed_t *batch_dist;
+
+//
+// Listener state at the last update; channels are only recomputed when
+// the listener or their origin has moved, or the volume has changed.
+//
+static const mobj_t *last_listener;
+static fixed_t last_listener_x;
+static fixed_t last_listener_y;
+static angle_t last_listener_angle;
+static bool sound_params_dirty;
+
 //
 // Maximum volume of a sound effect.
 // Internal default is max out of 0-15.
@@ -112,6 +161,84 @@ static musicinfo_t *mus_playing = NULL;
 //
 int snd_channels = 8;
 
+//
+// If non-zero, a new sound takes the lowest numbered channel playing a
+// sound that is not more important, as in Vanilla. Otherwise it takes
+// the least important channel, and the oldest one among equals.
+//
+int vanilla_sound_channels = 1;
+
+static bool S_FreeBefore(int a, int b) {
+    return a < b;
+}
+
+static bool S_BusyBefore(int a, int b) {
+    int priority_a = channels[a].sfxinfo->priority;
+    int priority_b = channels[b].sfxinfo->priority;
+    if (priority_a != priority_b) {
+        return priority_a > priority_b;
+    }
+    return channels[a].sequence - channels[b].sequence > UINT_MAX / 2;
+}
+
+static void S_HeapSwap(channel_heap_t *heap, int i, int j) {
+    int a = heap->items[i];
+    int b = heap->items[j];
+    heap->items[i] = b;
+    heap->items[j] = a;
+    channels[b].heap_pos = i;
+    channels[a].heap_pos = j;
+}
+
+static void S_HeapUp(channel_heap_t *heap, int i) {
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (!heap->before(heap->items[i], heap->items[parent])) {
+            break;
+        }
+        S_HeapSwap(heap, i, parent);
+        i = parent;
+    }
+}
+
+static void S_HeapDown(channel_heap_t *heap, int i) {
+    while (true) {
+        int best = i;
+        int left = 2 * i + 1;
+        int right = left + 1;
+        if (left < heap->count
+            && heap->before(heap->items[left], heap->items[best])) {
+            best = left;
+        }
+        if (right < heap->count
+            && heap->before(heap->items[right], heap->items[best])) {
+            best = right;
+        }
+        if (best == i) {
+            break;
+        }
+        S_HeapSwap(heap, i, best);
+        i = best;
+    }
+}
+
+static void S_HeapPush(channel_heap_t *heap, int cnum) {
+    heap->items[heap->count] = cnum;
+    channels[cnum].heap_pos = heap->count;
+    heap->count++;
+    S_HeapUp(heap, heap->count - 1);
+}
+
+static void S_HeapRemove(channel_heap_t *heap, int cnum) {
+    int i = channels[cnum].heap_pos;
+    heap->count--;
+    if (i != heap->count) {
+        S_HeapSwap(heap, i, heap->count);
+        S_HeapDown(heap, i);
+        S_HeapUp(heap, i);
+    }
+}
+
 
 //
 // Allocating the internal channels for mixing (the maximum numer of sounds
@@ -121,9 +248,23 @@ static void S_AllocChannels() {
     size_t size = snd_channels * sizeof(channel_t);
     channels = Z_Malloc((int) size, PU_STATIC, 0);
 
+    size = snd_channels * sizeof(int);
+    free_channels.items = Z_Malloc((int) size, PU_STATIC, 0);
+    free_channels.before = S_FreeBefore;
+    busy_channels.items = Z_Malloc((int) size, PU_STATIC, 0);
+    busy_channels.before = S_BusyBefore;
+
+    batch_cnum = Z_Malloc((int) size, PU_STATIC, 0);
+    size = snd_channels * sizeof(fixed_t);
+    batch_dx = Z_Malloc((int) size, PU_STATIC, 0);
+    batch_dy = Z_Malloc((int) size, PU_STATIC, 0);
+    batch_dist = Z_Malloc((int) size, PU_STATIC, 0);
+
     // Free all channels for use
+    free_channels.count = busy_channels.count = 0;
     for (int i = 0; i < snd_channels; i++) {
         channels[i].sfxinfo = 0;
+        S_HeapPush(&free_channels, i);
     }
 }
 
@@ -182,8 +323,10 @@ static void S_StopChannel(int cnum) {
     }
     // degrade usefulness of sound data
     channel->sfxinfo->usefulness--;
+    S_HeapRemove(&busy_channels, cnum);
     channel->sfxinfo = NULL;
     channel->origin = NULL;
+    S_HeapPush(&free_channels, cnum);
 }
 
 static int S_GetLevelMusic() {
@@ -248,60 +391,54 @@ void S_StopSound(const mobj_t *origin) {
 }
 
 //
-// S_GetChannel :
-//   If none available, return -1.  Otherwise channel #.
+// S_StealChannel :
+//   Picks a playing channel to make way for a new sound, or -1 if all
+//   of them are more important.
 //
-
-static int S_GetChannel(mobj_t *origin, sfxinfo_t *sfxinfo)
-{
-    // channel number to use
-    int                cnum;
-
-    channel_t*        c;
-
-    // Find an open channel
-    for (cnum=0 ; cnum<snd_channels ; cnum++)
-    {
-        if (!channels[cnum].sfxinfo)
-        {
-            break;
-        }
-        else if (origin && channels[cnum].origin == origin)
-        {
-            S_StopChannel(cnum);
-            break;
-        }
-    }
-
-    // None available
-    if (cnum == snd_channels)
-    {
+static int S_StealChannel(const sfxinfo_t *sfxinfo) {
+    if (vanilla_sound_channels) {
         // Look for lower priority
-        for (cnum=0 ; cnum<snd_channels ; cnum++)
-        {
-            if (channels[cnum].sfxinfo->priority >= sfxinfo->priority)
-            {
-                break;
+        for (int cnum = 0; cnum < snd_channels; cnum++) {
+            if (channels[cnum].sfxinfo->priority >= sfxinfo->priority) {
+                return cnum;
             }
         }
+        return -1;
+    }
 
-        if (cnum == snd_channels)
-        {
-            // FUCK!  No lower priority.  Sorry, Charlie.
+    int cnum = busy_channels.items[0];
+    if (channels[cnum].sfxinfo->priority >= sfxinfo->priority) {
+        return cnum;
+    }
+    return -1;
+}
+
+//
+// S_GetChannel :
+//   If none available, return -1.  Otherwise channel #.
+//   S_StartSound has already stopped any sound from the same origin.
+//
+static int S_GetChannel(mobj_t *origin, sfxinfo_t *sfxinfo) {
+    if (free_channels.count == 0) {
+        int cnum = S_StealChannel(sfxinfo);
+        if (cnum < 0) {
+            // No lower priority.  Sorry, Charlie.
             return -1;
         }
-        else
-        {
-            // Otherwise, kick out lower priority.
-            S_StopChannel(cnum);
-        }
+        // Otherwise, kick out lower priority.
+        S_StopChannel(cnum);
     }
 
-    c = &channels[cnum];
+    // Take the lowest numbered free channel.
+    int cnum = free_channels.items[0];
+    channel_t* c = &channels[cnum];
+    S_HeapRemove(&free_channels, cnum);
 
     // channel is decided to be cnum.
     c->sfxinfo = sfxinfo;
     c->origin = origin;
+    c->sequence = channel_sequence++;
+    S_HeapPush(&busy_channels, cnum);
 
     return cnum;
 }
@@ -355,20 +492,32 @@ static fixed_t S_DistanceToSound(const mobj_t *listener, const mobj_t *source) {
 // the norm of a sound effect to be played.
 // If the sound is not audible, returns a 0.
 // Otherwise, modifies parameters and returns 1.
+// Inaudible sounds are rejected before the angle to them is computed.
 //
-static bool S_AdjustSoundParams(const mobj_t* listener, const mobj_t* source,
-                                   int* vol, int* sep)
+static bool S_AdjustSoundParamsAt(const mobj_t* listener,
+                                  const mobj_t* source,
+                                  fixed_t approx_dist, int* vol, int* sep)
 {
-    fixed_t approx_dist = S_DistanceToSound(listener, source);
-
     if (gamemap != 8 && approx_dist > S_CLIPPING_DIST) {
         return false;
     }
 
-    S_AdjustStereoSeparation(listener, source, sep);
     S_AdjustVolume(approx_dist, vol);
+    if (*vol <= 0) {
+        return false;
+    }
+
+    S_AdjustStereoSeparation(listener, source, sep);
+
+    return true;
+}
 
-    return *vol > 0;
+static bool S_AdjustSoundParams(const mobj_t* listener, const mobj_t* source,
+                                   int* vol, int* sep)
+{
+    return S_AdjustSoundParamsAt(listener, source,
+                                 S_DistanceToSound(listener, source),
+                                 vol, sep);
 }
 
 //
@@ -458,9 +607,15 @@ void S_StartSound(void *origin_p, int sfx_id) {
         sfx->lumpnum = I_GetSfxLumpNum(sfx);
     }
 
-    channels[cnum].pitch = pitch;
-    channels[cnum].handle =
-        I_StartSound(sfx, cnum, volume, sep, channels[cnum].pitch);
+    channel_t* c = &channels[cnum];
+    c->pitch = pitch;
+    c->volume = volume;
+    c->sep = sep;
+    if (origin) {
+        c->origin_x = origin->x;
+        c->origin_y = origin->y;
+    }
+    c->handle = I_StartSound(sfx, cnum, volume, sep, c->pitch);
 }
 
 //
@@ -480,33 +635,57 @@ void S_ResumeSound(void) {
     }
 }
 
-static void S_UpdatePlayingSound(const mobj_t* listener, int cnum) {
-    const channel_t* c = &channels[cnum];
-    const sfxinfo_t* sfx = c->sfxinfo;
+//
+// Applies the volume of linked sounds; returns false if the sound has
+// become inaudible.
+//
+static bool S_LinkedVolume(const sfxinfo_t* sfx, int* volume) {
+    if (sfx->link) {
+        *volume += sfx->volume;
+        if (*volume < 1) {
+            return false;
+        }
+        if (*volume > snd_SfxVolume) {
+            *volume = snd_SfxVolume;
+        }
+    }
+    return true;
+}
+
+static void S_UpdatePositionalSound(const mobj_t* listener, int cnum,
+                                    fixed_t approx_dist) {
+    channel_t* c = &channels[cnum];
 
     // Initialize parameters.
     int volume = snd_SfxVolume;
     int sep = NORM_SEP;
-    if (sfx->link) {
-        volume += sfx->volume;
-        if (volume < 1) {
-            S_StopChannel(cnum);
-            return;
-        }
-        if (volume > snd_SfxVolume) {
-            volume = snd_SfxVolume;
-        }
+    if (!S_LinkedVolume(c->sfxinfo, &volume)
+        || !S_AdjustSoundParamsAt(listener, c->origin, approx_dist,
+                                  &volume, &sep)) {
+        S_StopChannel(cnum);
+        return;
     }
 
-    // Check non-local sounds for distance clipping or modify their params.
-    if (c->origin && c->origin != listener) {
-        bool audible =
-            S_AdjustSoundParams(listener, c->origin, &volume, &sep);
-        if (audible) {
-            I_UpdateSoundParams(c->handle, volume, sep);
-        } else {
-            S_StopChannel(cnum);
-        }
+    c->origin_x = c->origin->x;
+    c->origin_y = c->origin->y;
+
+    if (volume != c->volume || sep != c->sep) {
+        c->volume = volume;
+        c->sep = sep;
+        I_UpdateSoundParams(c->handle, volume, sep);
+    }
+}
+
+//
+// Approximate distances from the listener to the batched origins,
+// from _GG1_ p.428. The loop has no data dependent branches, so the
+// compiler can vectorize it.
+//
+static void S_BatchDistances(int count) {
+    for (int i = 0; i < count; i++) {
+        fixed_t adx = abs(batch_dx[i]);
+        fixed_t ady = abs(batch_dy[i]);
+        batch_dist[i] = adx + ady - ((adx < ady ? adx : ady) >> 1);
     }
 }
 
@@ -516,18 +695,57 @@ static void S_UpdatePlayingSound(const mobj_t* listener, int cnum) {
 void S_UpdateSounds(const mobj_t* listener) {
     I_UpdateSound();
 
+    // Positions only change once per tic, but this runs every frame.
+    bool listener_moved = listener != last_listener;
+    if (listener != NULL) {
+        listener_moved |= listener->x != last_listener_x
+                          || listener->y != last_listener_y
+                          || listener->angle != last_listener_angle;
+        last_listener_x = listener->x;
+        last_listener_y = listener->y;
+        last_listener_angle = listener->angle;
+    }
+    last_listener = listener;
+
+    int count = 0;
+
     for (int cnum = 0; cnum < snd_channels; cnum++) {
         const channel_t* c = &channels[cnum];
         if (c->sfxinfo == NULL) {
             continue;
         }
-        if (I_SoundIsPlaying(c->handle)) {
-            S_UpdatePlayingSound(listener, cnum);
-        } else {
+        if (!I_SoundIsPlaying(c->handle)) {
             // If channel is allocated but sound has stopped, free it.
             S_StopChannel(cnum);
+            continue;
+        }
+
+        if (c->origin && c->origin != listener) {
+            // Check non-local sounds for distance clipping or modify
+            // their params.
+            if (listener_moved || sound_params_dirty
+                || c->origin->x != c->origin_x
+                || c->origin->y != c->origin_y) {
+                batch_cnum[count] = cnum;
+                batch_dx[count] = listener->x - c->origin->x;
+                batch_dy[count] = listener->y - c->origin->y;
+                count++;
+            }
+        } else if (sound_params_dirty) {
+            int volume = snd_SfxVolume;
+            if (!S_LinkedVolume(c->sfxinfo, &volume)) {
+                S_StopChannel(cnum);
+            }
         }
     }
+
+    S_BatchDistances(count);
+
+    for (int i = 0; i < count; i++) {
+        S_UpdatePositionalSound(listener, batch_cnum[i], batch_dist[i]);
+    }
+
+    sound_params_dirty = false;
 }
 
 void S_SetMusicVolume(int volume) {
@@ -542,6 +760,7 @@ void S_SetSfxVolume(int volume) {
         I_Error("Attempt to set sfx volume at %d", volume);
     }
     snd_SfxVolume = volume;
+    sound_params_dirty = true;
 }
 
 //
@@ -591,7 +810,8 @@ void S_ChangeMusic(int musicnum, bool looping) {
         music->lumpnum = S_GetMusicLump(music->name);
     }
     music->data = W_CacheLumpNum(music->lumpnum, PU_STATIC);
-    music->handle = I_RegisterSong(music->data, W_LumpLength(music->lumpnum));
+    music->handle = I_RegisterSong(music->data, W_LumpLength(music->lumpnum),
+                                   music->lumpnum);
 
     I_PlaySong(music->handle, looping);
 
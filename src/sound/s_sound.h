@@ -81,6 +81,7 @@ void S_SetMusicVolume(int volume);
 void S_SetSfxVolume(int volume);
 
 extern int snd_channels;
+extern int vanilla_sound_channels;
 
 #endif
 
@@ -184,7 +184,7 @@ int EV_DoCeiling(line_t *line, ceiling_e type)
 
         // new door thinker
         rtn = 1;
-        ceiling = Z_Malloc(sizeof(*ceiling), PU_LEVSPEC, 0);
+        ceiling = P_AllocThinker(tt_ceiling, sizeof(*ceiling));
         P_AddThinker(&ceiling->thinker);
         sec->specialdata = ceiling;
         ceiling->thinker.function.acp1 = (actionf_p1) T_MoveCeiling;
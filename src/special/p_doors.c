@@ -258,7 +258,7 @@ int EV_DoLockedDoor(const line_t* line, vldoor_e type, mobj_t* thing) {
 }
 
 static void EV_AddNewDoor(sector_t* sec, vldoor_e type) {
-    vldoor_t* door = Z_Malloc(sizeof(*door), PU_LEVSPEC, NULL);
+    vldoor_t* door = P_AllocThinker(tt_door, sizeof(*door));
 
     P_AddThinker(&door->thinker);
     sec->specialdata = door;
@@ -326,7 +326,7 @@ bool EV_DoDoor(const line_t* line, vldoor_e type) {
 }
 
 static void EV_AddDoorThinker(line_t* line, sector_t* sec) {
-    vldoor_t *door = Z_Malloc(sizeof(*door), PU_LEVSPEC, NULL);
+    vldoor_t *door = P_AllocThinker(tt_door, sizeof(*door));
     sec->specialdata = door;
 
     P_AddThinker(&door->thinker);
@@ -506,7 +506,7 @@ void EV_VerticalDoor(line_t* line, mobj_t* thing) {
 // Spawn a door that closes after 30 seconds
 //
 void P_SpawnDoorCloseIn30(sector_t* sec) {
-    vldoor_t *door = Z_Malloc(sizeof(*door), PU_LEVSPEC, NULL);
+    vldoor_t *door = P_AllocThinker(tt_door, sizeof(*door));
 
     P_AddThinker(&door->thinker);
 
@@ -527,7 +527,7 @@ void P_SpawnDoorCloseIn30(sector_t* sec) {
 void P_SpawnDoorRaiseIn5Mins(sector_t* sec) {
     vldoor_t *door;
 
-    door = Z_Malloc(sizeof(*door), PU_LEVSPEC, 0);
+    door = P_AllocThinker(tt_door, sizeof(*door));
 
     P_AddThinker(&door->thinker);
 
@@ -267,7 +267,7 @@ EV_DoFloor
 	
 	// new floor thinker
 	rtn = 1;
-	floor = Z_Malloc (sizeof(*floor), PU_LEVSPEC, 0);
+	floor = P_AllocThinker(tt_floor, sizeof(*floor));
 	P_AddThinker (&floor->thinker);
 	sec->specialdata = floor;
 	floor->thinker.function.acp1 = (actionf_p1) T_MoveFloor;
@@ -468,7 +468,7 @@ int EV_BuildStairs(const line_t *line, stair_e type) {
 
         // new floor thinker
         rtn = 1;
-        floor = Z_Malloc(sizeof(*floor), PU_LEVSPEC, 0);
+        floor = P_AllocThinker(tt_floor, sizeof(*floor));
         P_AddThinker(&floor->thinker);
         sec->specialdata = floor;
         floor->thinker.function.acp1 = (actionf_p1) T_MoveFloor;
@@ -527,7 +527,7 @@ int EV_BuildStairs(const line_t *line, stair_e type) {
 
                 sec = tsec;
                 secnum = newsecnum;
-                floor = Z_Malloc(sizeof(*floor), PU_LEVSPEC, 0);
+                floor = P_AllocThinker(tt_floor, sizeof(*floor));
 
                 P_AddThinker(&floor->thinker);
 
@@ -58,7 +58,7 @@ void P_SpawnFireFlicker(sector_t* sector) {
     // Nothing special about it during gameplay.
     sector->special = 0;
 
-    fireflicker_t* flick = Z_Malloc(sizeof(*flick), PU_LEVSPEC, NULL);
+    fireflicker_t* flick = P_AllocThinker(tt_fireflicker, sizeof(*flick));
 
     P_AddThinker(&flick->thinker);
 
@@ -104,7 +104,7 @@ void P_SpawnLightFlash(sector_t* sector) {
     // Nothing special about it during gameplay.
     sector->special = 0;
 
-    lightflash_t *flash = Z_Malloc(sizeof(*flash), PU_LEVSPEC, NULL);
+    lightflash_t *flash = P_AllocThinker(tt_flash, sizeof(*flash));
 
     P_AddThinker(&flash->thinker);
 
@@ -147,7 +147,7 @@ void T_StrobeFlash(strobe_t *flash) {
 // for specials that spawn thinkers
 //
 void P_SpawnStrobeFlash(sector_t* sector, int fastOrSlow, int inSync) {
-    strobe_t* flash = Z_Malloc(sizeof(*flash), PU_LEVSPEC, NULL);
+    strobe_t* flash = P_AllocThinker(tt_strobe, sizeof(*flash));
 
     P_AddThinker(&flash->thinker);
 
@@ -261,7 +261,7 @@ void T_Glow(glow_t* g) {
 
 
 void P_SpawnGlowingLight(sector_t* sector) {
-    glow_t* g = Z_Malloc(sizeof(*g), PU_LEVSPEC, NULL);
+    glow_t* g = P_AllocThinker(tt_glow, sizeof(*g));
 
     P_AddThinker(&g->thinker);
 
@@ -78,6 +78,7 @@ void P_SpawnFireFlicker(sector_t* sector);
 void P_SpawnGlowingLight(sector_t* sector);
 void P_SpawnLightFlash(sector_t* sector);
 void P_SpawnStrobeFlash(sector_t* sector, int fastOrSlow, int inSync);
+void T_FireFlicker(fireflicker_t* flick);
 void T_Glow(glow_t* g);
 void T_LightFlash(lightflash_t* flash);
 void T_StrobeFlash(strobe_t* flash);
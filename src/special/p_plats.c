@@ -211,7 +211,7 @@ static void EV_InitPlatTypeData(plat_t* plat, sector_t* sec, const line_t *line,
 static void EV_AddNewPlat(sector_t* sec, const line_t* line, plattype_e type,
                           int amount)
 {
-    plat_t* plat = Z_Malloc(sizeof(*plat), PU_LEVSPEC, NULL);
+    plat_t* plat = P_AllocThinker(tt_plat, sizeof(*plat));
 
     plat->type = type;
     plat->sector = sec;
@@ -1041,6 +1041,7 @@ void ST_Stop(void) {
 
 void ST_Init(void) {
     ST_loadData();
-    int size_screen = ST_WIDTH * ST_HEIGHT * sizeof(*st_backing_screen);
+    int size_screen = SCREENWIDTH * ST_HEIGHT * render_scale
+                      * sizeof(*st_backing_screen);
     st_backing_screen = (pixel_t *) Z_Malloc(size_screen, PU_STATIC, 0);
 }
@@ -30,8 +30,8 @@
 // Now sensitive for scaling.
 #define ST_MSGWIDTH     52
 #define ST_HEIGHT	32
-#define ST_WIDTH	SCREENWIDTH
-#define ST_Y		(SCREENHEIGHT - ST_HEIGHT)
+#define ST_WIDTH	ORIGWIDTH
+#define ST_Y		(ORIGHEIGHT - ST_HEIGHT)
 
 
 // Called by main loop.
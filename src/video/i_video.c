@@ -22,6 +22,10 @@
 #include "SDL.h"
 #include "SDL_opengl.h"
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 #ifdef _WIN32
 #ifndef WIN32_LEAN_AND_MEAN
 #define WIN32_LEAN_AND_MEAN
@@ -42,6 +46,7 @@
 #include "m_config.h"
 #include "m_misc.h"
 #include "tables.h"
+#include "v_capture.h"
 #include "v_icon.h"
 #include "v_diskicon.h"
 #include "v_video.h"
@@ -62,24 +67,17 @@ static const char *window_title = "";
 // (i.e. the one that holds I_VideoBuffer).
 static SDL_Surface *screenbuffer = NULL;
 
-// The 320x200x32 RGBA intermediate buffer that we blit the screenbuffer to.
-static SDL_Surface *argbbuffer = NULL;
-
-// The intermediate 320x200 texture that we load the RGBA buffer to
-// and that we render into texture_upscaled.
+// The intermediate 320x200 streaming texture that the screenbuffer is
+// expanded into and that we render into texture_upscaled.
 static SDL_Texture *texture = NULL;
 
 // The texture which is upscaled by an integer factor UPSCALE using "nearest"
 // scaling and which in turn is finally rendered to screen using "linear"
-// scaling.
+// scaling. With cpu_upscaling this is a streaming texture that the
+// screenbuffer is expanded into directly, already upscaled.
 static SDL_Texture *texture_upscaled = NULL;
-
-static SDL_Rect blit_rect = {
-    0,
-    0,
-    SCREENWIDTH,
-    SCREENHEIGHT
-};
+static int texture_w_upscale = 1;
+static int texture_h_upscale = 1;
 
 static uint32_t pixel_format;
 
@@ -88,6 +86,14 @@ static uint32_t pixel_format;
 static SDL_Color palette[256];
 static bool palette_to_set;
 
+// The palette mapped to pixel_format, used to expand the screenbuffer.
+
+static uint32_t palette_lut[256];
+
+// Copy of the last frame that was sent to the screen. Frames that are
+// identical to it (menus, intermission, pause) are not uploaded again.
+static pixel_t *presented_frame = NULL;
+
 // display has been set up?
 
 static bool initialized = false;
@@ -121,10 +127,19 @@ int window_height = 600;
 // Fullscreen mode, 0x0 for SDL_WINDOW_FULLSCREEN_DESKTOP.
 int fullscreen_width = 0, fullscreen_height = 0;
 
+// Internal resolution, as a multiple of 320x200.
+
+int render_scale = 1;
+
 // Maximum number of pixels to use for intermediate scale buffer.
 
 static int max_scaling_buffer_pixels = 16000000;
 
+// Do the integer upscale on the CPU while expanding the palette, instead
+// of rendering the intermediate texture into the upscaled one on the GPU.
+
+int cpu_upscaling = false;
+
 // Run in full screen mode?  (int type for config code)
 
 int fullscreen = true;
@@ -163,6 +178,19 @@ pixel_t *I_VideoBuffer = NULL;
 // If true, game is running as a screensaver
 bool screensaver_mode = false;
 
+// If true, SDL video is never initialized: the game renders into
+// I_VideoBuffer as usual, and frames are optionally written to a file.
+bool headless_mode = false;
+
+// Frame dump for headless mode: raw RGB24 frames, or a YUV4MPEG2 stream
+// if the file name ends in .y4m.
+
+static char *framedump_filename = NULL;
+static FILE *framedump = NULL;
+static bool framedump_y4m;
+static byte framedump_lut[256][3];
+static byte *framedump_frame = NULL;
+
 // Flag indicating whether the screen is currently visible:
 // when the screen isnt visible, don't render the screen
 bool screenvisible = true;
@@ -244,9 +272,16 @@ static void I_SetShowCursor(bool show) {
     }
 }
 
+static void I_CloseFrameDump(void);
+
 void I_ShutdownGraphics(void)
 {
-    if (initialized)
+    if (initialized && headless_mode)
+    {
+        I_CloseFrameDump();
+        initialized = false;
+    }
+    else if (initialized)
     {
         I_SetShowCursor(true);
 
@@ -348,6 +383,9 @@ static void I_ToggleFullScreen(void) {
         I_AdjustWindowSize();
         SDL_SetWindowSize(screen, window_width, window_height);
     }
+
+    // Redraw even if the frame has not changed.
+    palette_to_set = true;
 }
 
 static void I_DoQuit() {
@@ -409,7 +447,7 @@ static void I_GetEvent(void) {
 // I_StartTic
 //
 void I_StartTic(void) {
-    if (!initialized) {
+    if (!initialized || headless_mode) {
         return;
     }
     I_GetEvent();
@@ -590,47 +628,158 @@ static void I_CreateUpscaledTexture(bool force) {
     // job at downscaling from the upscaled texture to screen.
     SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "linear");
 
+    int access = cpu_upscaling ? SDL_TEXTUREACCESS_STREAMING
+                               : SDL_TEXTUREACCESS_TARGET;
     SDL_Texture* new_texture = SDL_CreateTexture(renderer,
                                 pixel_format,
-                                SDL_TEXTUREACCESS_TARGET,
+                                access,
                                 w_upscale*SCREENWIDTH,
                                 h_upscale*SCREENHEIGHT);
 
     SDL_Texture* old_texture = texture_upscaled;
     texture_upscaled = new_texture;
+    texture_w_upscale = w_upscale;
+    texture_h_upscale = h_upscale;
 
     if (old_texture != NULL) {
         SDL_DestroyTexture(old_texture);
     }
 }
 
+//
+// Expand one row of the 8-bit screen buffer through palette_lut, repeating
+// each pixel w_scale times.
+//
+static void I_ExpandRow(uint32_t* dest, const pixel_t* src, int w_scale) {
+    int x = 0;
+
+    if (w_scale == 1) {
+#ifdef __SSE2__
+        // There is no SSE2 gather, so look the colours up one at a time and
+        // store them four pixels per write.
+        for (; x + 4 <= SCREENWIDTH; x += 4) {
+            __m128i v = _mm_set_epi32((int) palette_lut[src[x + 3]],
+                                      (int) palette_lut[src[x + 2]],
+                                      (int) palette_lut[src[x + 1]],
+                                      (int) palette_lut[src[x]]);
+            _mm_storeu_si128((__m128i*) (dest + x), v);
+        }
+#else
+        for (; x + 4 <= SCREENWIDTH; x += 4) {
+            dest[x] = palette_lut[src[x]];
+            dest[x + 1] = palette_lut[src[x + 1]];
+            dest[x + 2] = palette_lut[src[x + 2]];
+            dest[x + 3] = palette_lut[src[x + 3]];
+        }
+#endif
+        for (; x < SCREENWIDTH; x++) {
+            dest[x] = palette_lut[src[x]];
+        }
+        return;
+    }
+
+#ifdef __SSE2__
+    if (w_scale == 2) {
+        for (; x + 4 <= SCREENWIDTH; x += 4) {
+            __m128i v = _mm_set_epi32((int) palette_lut[src[x + 3]],
+                                      (int) palette_lut[src[x + 2]],
+                                      (int) palette_lut[src[x + 1]],
+                                      (int) palette_lut[src[x]]);
+            _mm_storeu_si128((__m128i*) (dest + x * 2),
+                             _mm_unpacklo_epi32(v, v));
+            _mm_storeu_si128((__m128i*) (dest + x * 2 + 4),
+                             _mm_unpackhi_epi32(v, v));
+        }
+        dest += x * 2;
+    }
+#endif
+
+    for (; x < SCREENWIDTH; x++) {
+        uint32_t c = palette_lut[src[x]];
+        for (int i = 0; i < w_scale; i++) {
+            *dest++ = c;
+        }
+    }
+}
+
+//
+// Expand the whole screen buffer into locked texture memory. Rows that are
+// repeated for the vertical upscale are copied from the first expansion.
+//
+static void I_ExpandScreen(void* pixels, int pitch, int w_scale, int h_scale) {
+    const pixel_t* src = I_VideoBuffer;
+    byte* dest = pixels;
+    size_t row_bytes = (size_t) SCREENWIDTH * w_scale * sizeof(uint32_t);
+
+    for (int y = 0; y < SCREENHEIGHT; y++) {
+        byte* first = dest;
+        I_ExpandRow((uint32_t*) first, src, w_scale);
+        dest += pitch;
+
+        for (int i = 1; i < h_scale; i++) {
+            memcpy(dest, first, row_bytes);
+            dest += pitch;
+        }
+        src += SCREENWIDTH;
+    }
+}
+
 static void I_UpdateScreen() {
-    // Blit from the paletted 8-bit screen buffer to the intermediate
-    // 32-bit RGBA buffer that we can load into the texture.
-    SDL_LowerBlit(screenbuffer, &blit_rect, argbbuffer, &blit_rect);
+    SDL_Texture* target = texture;
+    int w_scale = 1;
+    int h_scale = 1;
+    void* pixels;
+    int pitch;
 
-    // Update the intermediate texture with the contents of the RGBA buffer.
-    SDL_UpdateTexture(texture, NULL, argbbuffer->pixels, argbbuffer->pitch);
+    if (cpu_upscaling) {
+        target = texture_upscaled;
+        w_scale = texture_w_upscale;
+        h_scale = texture_h_upscale;
+    }
+
+    // Expand the paletted 8-bit screen buffer straight into the streaming
+    // texture's memory.
+    if (SDL_LockTexture(target, NULL, &pixels, &pitch) == 0) {
+        I_ExpandScreen(pixels, pitch, w_scale, h_scale);
+        SDL_UnlockTexture(target);
+    }
 
     // Make sure the pillarboxes are kept clear each frame.
     SDL_RenderClear(renderer);
 
-    // Render this intermediate texture into the upscaled texture
-    // using "nearest" integer scaling.
-    SDL_SetRenderTarget(renderer, texture_upscaled);
-    SDL_RenderCopy(renderer, texture, NULL, NULL);
+    if (!cpu_upscaling) {
+        // Render this intermediate texture into the upscaled texture
+        // using "nearest" integer scaling.
+        SDL_SetRenderTarget(renderer, texture_upscaled);
+        SDL_RenderCopy(renderer, texture, NULL, NULL);
+        SDL_SetRenderTarget(renderer, NULL);
+    }
 
     // Finally, render this upscaled texture to screen using linear scaling.
-    SDL_SetRenderTarget(renderer, NULL);
     SDL_RenderCopy(renderer, texture_upscaled, NULL, NULL);
 
     // Draw!
     SDL_RenderPresent(renderer);
 }
 
+//
+// Map the palette to the texture pixel format.
+//
+static void I_UpdatePaletteLUT() {
+    SDL_PixelFormat* format = SDL_AllocFormat(pixel_format);
+    if (format == NULL) {
+        I_Error("I_UpdatePaletteLUT: SDL_AllocFormat() failed: %s", SDL_GetError());
+    }
+
+    for (int i = 0; i < 256; i++) {
+        palette_lut[i] = SDL_MapRGB(format, palette[i].r, palette[i].g, palette[i].b);
+    }
+
+    SDL_FreeFormat(format);
+}
+
 static void I_UpdatePalette() {
-    SDL_Palette* sdl_palette = screenbuffer->format->palette;
-    SDL_SetPaletteColors(sdl_palette, palette, 0, 256);
+    I_UpdatePaletteLUT();
     palette_to_set = false;
 
     if (vga_porch_flash) {
@@ -688,6 +837,26 @@ static void I_ResizeWindow() {
     palette_to_set = true;
 }
 
+//
+// Compare the screen buffer against the last presented frame, and keep
+// a copy of it if it has changed.
+//
+static bool I_FrameChanged() {
+    size_t size = SCREENWIDTH * SCREENHEIGHT * sizeof(*I_VideoBuffer);
+
+    if (presented_frame == NULL) {
+        presented_frame = malloc(size);
+        if (presented_frame == NULL) {
+            return true;
+        }
+    } else if (memcmp(presented_frame, I_VideoBuffer, size) == 0) {
+        return false;
+    }
+
+    memcpy(presented_frame, I_VideoBuffer, size);
+    return true;
+}
+
 static bool I_IsReadyResizeWindow() {
     return SDL_GetTicks() > last_resize_time + RESIZE_DELAY;
 }
@@ -702,10 +871,114 @@ static bool I_CanUpdateScreen() {
     return true;
 }
 
+//
+// Open the headless frame dump and write the stream header.
+//
+static void I_OpenFrameDump(void) {
+    framedump = M_fopen(framedump_filename, "wb");
+    if (framedump == NULL) {
+        I_Error("I_OpenFrameDump: Failed to open %s", framedump_filename);
+    }
+
+    framedump_y4m = M_StringEndsWith(framedump_filename, ".y4m");
+    framedump_frame = malloc(SCREENWIDTH * SCREENHEIGHT * 3);
+
+    if (framedump_y4m) {
+        // With aspect ratio correction, the 16:10 frame is shown at 4:3,
+        // which makes each pixel 5:6.
+        fprintf(framedump, "YUV4MPEG2 W%d H%d F%d:1 Ip A%s C444\n",
+                SCREENWIDTH, SCREENHEIGHT, TICRATE,
+                aspect_ratio_correct ? "5:6" : "1:1");
+    }
+}
+
+static void I_CloseFrameDump(void) {
+    if (framedump != NULL) {
+        fclose(framedump);
+        framedump = NULL;
+    }
+    free(framedump_frame);
+    framedump_frame = NULL;
+}
+
+//
+// Map the palette to the frame dump colour space: RGB, or BT.601
+// limited range YUV for Y4M.
+//
+static void I_UpdateFrameDumpLUT(void) {
+    for (int i = 0; i < 256; i++) {
+        int r = palette[i].r;
+        int g = palette[i].g;
+        int b = palette[i].b;
+
+        if (framedump_y4m) {
+            framedump_lut[i][0] = (( 66 * r + 129 * g +  25 * b + 128) >> 8) + 16;
+            framedump_lut[i][1] = ((-38 * r -  74 * g + 112 * b + 128) >> 8) + 128;
+            framedump_lut[i][2] = ((112 * r -  94 * g -  18 * b + 128) >> 8) + 128;
+        } else {
+            framedump_lut[i][0] = r;
+            framedump_lut[i][1] = g;
+            framedump_lut[i][2] = b;
+        }
+    }
+}
+
+static void I_WriteFrameDump(void) {
+    const int size = SCREENWIDTH * SCREENHEIGHT;
+    byte* out = framedump_frame;
+
+    if (framedump_y4m) {
+        // C444 frames are planar: the whole Y plane, then U, then V.
+        for (int plane = 0; plane < 3; plane++) {
+            for (int i = 0; i < size; i++) {
+                *out++ = framedump_lut[I_VideoBuffer[i]][plane];
+            }
+        }
+        fputs("FRAME\n", framedump);
+    } else {
+        for (int i = 0; i < size; i++) {
+            const byte* c = framedump_lut[I_VideoBuffer[i]];
+            *out++ = c[0];
+            *out++ = c[1];
+            *out++ = c[2];
+        }
+    }
+
+    if (fwrite(framedump_frame, 3, size, framedump) != (size_t) size) {
+        I_Error("I_WriteFrameDump: Failed to write to %s", framedump_filename);
+    }
+}
+
+//
+// In headless mode the frame is complete once it is in I_VideoBuffer.
+// The disk icon is not drawn, so that dumped frames only depend on what
+// was rendered.
+//
+static void I_FinishHeadlessUpdate(void) {
+    if (!initialized || noblit) {
+        return;
+    }
+    if (display_fps_dots) {
+        I_DrawFpsDots();
+    }
+    V_CaptureFrame();
+    if (palette_to_set) {
+        I_UpdateFrameDumpLUT();
+        palette_to_set = false;
+    }
+    if (framedump != NULL) {
+        I_WriteFrameDump();
+    }
+}
+
 //
 // I_FinishUpdate
 //
 void I_FinishUpdate() {
+    if (headless_mode) {
+        I_FinishHeadlessUpdate();
+        return;
+    }
     if (!I_CanUpdateScreen()) {
         return;
     }
@@ -716,12 +989,19 @@ void I_FinishUpdate() {
     if (display_fps_dots) {
         I_DrawFpsDots();
     }
+    // Capture before the disk icon is drawn.
+    V_CaptureFrame();
     // Draw disk icon before blit, if necessary.
     V_DrawDiskIcon();
+    bool changed = I_FrameChanged();
     if (palette_to_set) {
         I_UpdatePalette();
+        changed = true;
+    }
+    // Skip the upload and present if nothing on screen changed.
+    if (changed) {
+        I_UpdateScreen();
     }
-    I_UpdateScreen();
     // Restore background and undo the disk indicator, if it was drawn.
     V_RestoreDiskBackground();
 }
@@ -761,6 +1041,18 @@ void I_SetPalette(const byte* doompalette) {
     palette_to_set = true;
 }
 
+//
+// I_ReadPalette
+// Copy the current palette, as shown on screen, as 256 RGB triples.
+//
+void I_ReadPalette(byte* rgb) {
+    for (int i = 0; i < 256; i++) {
+        rgb[i * 3] = palette[i].r;
+        rgb[i * 3 + 1] = palette[i].g;
+        rgb[i * 3 + 2] = palette[i].b;
+    }
+}
+
 //
 // Given an RGB value, find the closest matching palette index.
 //
@@ -827,8 +1119,8 @@ static void SetScaleFactor(int factor)
 {
     // Pick 320x200 or 320x240, depending on aspect ratio correct
 
-    window_width = factor * SCREENWIDTH;
-    window_height = factor * actualheight;
+    window_width = factor * ORIGWIDTH;
+    window_height = factor * actualheight / render_scale;
     fullscreen = false;
 }
 
@@ -845,6 +1137,34 @@ void I_GraphicsCheckCommandLine(void)
 
     noblit = M_CheckParm ("-noblit");
 
+    //!
+    // @category video
+    //
+    // Run without a window. SDL video is never initialized, but the game
+    // is rendered as usual. Useful for running demos on machines without
+    // a display.
+    //
+
+    headless_mode = M_ParmExists("-headless");
+
+    //!
+    // @category video
+    // @arg <file>
+    //
+    // Write every frame to the given file. If the file name ends in .y4m,
+    // a YUV4MPEG2 stream is written; otherwise frames are raw RGB24 at
+    // the internal resolution, 320x200 times the render scale (see
+    // -renderscale). Implies -headless.
+    //
+
+    i = M_CheckParmWithArgs("-framedump", 1);
+
+    if (i > 0)
+    {
+        framedump_filename = myargv[i + 1];
+        headless_mode = true;
+    }
+
     //!
     // @category video 
     //
@@ -990,6 +1310,34 @@ void I_GraphicsCheckCommandLine(void)
     }
 }
 
+void I_InitRenderScale(void)
+{
+    int i;
+
+    //!
+    // @category video
+    // @arg <n>
+    //
+    // Render at n times the original 320x200 resolution.
+    //
+
+    i = M_CheckParmWithArgs("-renderscale", 1);
+
+    if (i > 0)
+    {
+        render_scale = atoi(myargv[i + 1]);
+    }
+
+    if (render_scale < 1)
+    {
+        render_scale = 1;
+    }
+    else if (render_scale > MAXRENDERSCALE)
+    {
+        render_scale = MAXRENDERSCALE;
+    }
+}
+
 // Check if we have been invoked as a screensaver by xscreensaver.
 
 void I_CheckIsScreensaver(void)
@@ -1082,7 +1430,7 @@ static void I_SetDoomPalette() {
     const char* lump_name = DEH_String("PLAYPAL");
     const byte* doompal = W_CacheLumpName(lump_name, PU_CACHE);
     I_SetPalette(doompal);
-    SDL_SetPaletteColors(screenbuffer->format->palette, palette, 0, 256);
+    I_UpdatePaletteLUT();
 }
 
 #if defined(_WIN32)
@@ -1109,37 +1457,15 @@ static void I_CreateTexture() {
     // resembles software scaling pretty well.
     SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "nearest");
 
-    // Create the intermediate texture that the RGBA surface gets loaded into.
-    // The SDL_TEXTUREACCESS_STREAMING flag means that this texture's content
-    // is going to change frequently.
+    // Create the intermediate texture that the screenbuffer gets expanded
+    // into. The SDL_TEXTUREACCESS_STREAMING flag means that this texture's
+    // content is going to change frequently.
     int access = SDL_TEXTUREACCESS_STREAMING;
     int w = SCREENWIDTH;
     int h = SCREENHEIGHT;
     texture = SDL_CreateTexture(renderer, pixel_format, access, w, h);
 }
 
-//
-// Create the 32-bit RGBA surface. Format of argbbuffer must match the
-// screen pixel format because we import the surface data into the texture.
-//
-static void I_Create32BitSurface() {
-    if (argbbuffer != NULL) {
-        SDL_FreeSurface(argbbuffer);
-        argbbuffer = NULL;
-    }
-
-    if (argbbuffer == NULL) {
-        unsigned int rmask, gmask, bmask, amask;
-        int bpp;
-        int w = SCREENWIDTH;
-        int h = SCREENHEIGHT;
-        SDL_PixelFormatEnumToMasks(pixel_format, &bpp, &rmask, &gmask, &bmask, &amask);
-
-        argbbuffer = SDL_CreateRGBSurface(0, w, h, bpp, rmask, gmask, bmask, amask);
-        SDL_FillRect(argbbuffer, NULL, 0);
-    }
-}
-
 //
 // Create the 8-bit paletted surface.
 //
@@ -1292,7 +1618,13 @@ static void I_CreateWindow() {
         I_Error("Error creating window for video startup: %s", SDL_GetError());
     }
     pixel_format = SDL_GetWindowPixelFormat(screen);
-    SDL_SetWindowMinimumSize(screen, SCREENWIDTH, actualheight);
+
+    // The screenbuffer is expanded into 32-bit pixels; let SDL convert if
+    // the window uses anything else.
+    if (SDL_BYTESPERPIXEL(pixel_format) != 4) {
+        pixel_format = SDL_PIXELFORMAT_ARGB8888;
+    }
+    SDL_SetWindowMinimumSize(screen, ORIGWIDTH, actualheight / render_scale);
 
     I_InitWindowTitle();
     I_InitWindowIcon();
@@ -1304,7 +1636,6 @@ static void I_SetVideoMode(void) {
     }
     I_CreateRender();
     I_Create8BitSurface();
-    I_Create32BitSurface();
     I_CreateTexture();
 #if defined(_WIN32)
     I_WorkaroundAltTabBug();
@@ -1328,9 +1659,40 @@ static void I_EmbedIntoXScreenSaverWindow(char *env) {
     putenv(winenv);
 }
 
+//
+// Set up the screen buffer and palette without initializing SDL video.
+//
+static void I_InitHeadless(void) {
+    if (aspect_ratio_correct == 1) {
+        actualheight = SCREENHEIGHT_4_3;
+    } else {
+        actualheight = SCREENHEIGHT;
+    }
+
+    I_Create8BitSurface();
+    I_SetPalette(W_CacheLumpName(DEH_String("PLAYPAL"), PU_CACHE));
+
+    if (framedump_filename != NULL) {
+        I_OpenFrameDump();
+    }
+
+    I_VideoBuffer = screenbuffer->pixels;
+    V_RestoreBuffer();
+    memset(I_VideoBuffer, 0, SCREENWIDTH * SCREENHEIGHT * sizeof(*I_VideoBuffer));
+
+    initialized = true;
+
+    I_AtExit(I_ShutdownGraphics, true);
+}
+
 void I_InitGraphics(void) {
     SDL_Event dummy;
 
+    if (headless_mode) {
+        I_InitHeadless();
+        return;
+    }
+
     char *env = getenv("XSCREENSAVER_WINDOW");
     if (env) {
         I_EmbedIntoXScreenSaverWindow(env);
@@ -1377,9 +1739,9 @@ void I_InitGraphics(void) {
     }
 
     // The actual 320x200 canvas that we draw to. This is the pixel buffer of
-    // the 8-bit paletted screen buffer that gets blit on an intermediate
-    // 32-bit RGBA screen buffer that gets loaded into a texture that gets
-    // finally rendered into our window or full screen in I_FinishUpdate().
+    // the 8-bit paletted screen buffer that gets expanded through the palette
+    // into a streaming texture that gets finally rendered into our window or
+    // full screen in I_FinishUpdate().
     I_VideoBuffer = screenbuffer->pixels;
     V_RestoreBuffer();
 
@@ -1410,6 +1772,8 @@ void I_BindVideoVariables(void)
     M_BindIntVariable("fullscreen_height",         &fullscreen_height);
     M_BindIntVariable("force_software_renderer",   &force_software_renderer);
     M_BindIntVariable("max_scaling_buffer_pixels", &max_scaling_buffer_pixels);
+    M_BindIntVariable("cpu_upscaling",             &cpu_upscaling);
+    M_BindIntVariable("render_scale",              &render_scale);
     M_BindIntVariable("window_width",              &window_width);
     M_BindIntVariable("window_height",             &window_height);
     M_BindIntVariable("grabmouse",                 &grabmouse);
@@ -22,14 +22,28 @@
 
 #include "doomtype.h"
 
+// Screen width and height of the original game. Game logic, the status
+// bar, menus and everything else drawn through v_video.c use these
+// coordinates.
+
+#define ORIGWIDTH  320
+#define ORIGHEIGHT 200
+
+// The framebuffer is render_scale times the original resolution in each
+// direction; the 3D view is rendered at the full framebuffer resolution.
+
+#define MAXRENDERSCALE 8
+
+extern int render_scale;
+
 // Screen width and height.
 
-#define SCREENWIDTH  320
-#define SCREENHEIGHT 200
+#define SCREENWIDTH  (ORIGWIDTH * render_scale)
+#define SCREENHEIGHT (ORIGHEIGHT * render_scale)
 
 // Screen height used when aspect_ratio_correct=true.
 
-#define SCREENHEIGHT_4_3 240
+#define SCREENHEIGHT_4_3 (240 * render_scale)
 
 typedef bool (*grabmouse_callback_t)(void);
 
@@ -40,6 +54,10 @@ void I_InitGraphics (void);
 
 void I_GraphicsCheckCommandLine(void);
 
+// Settle render_scale from the configuration and command line. Must be
+// called before anything allocates screen-sized buffers.
+void I_InitRenderScale(void);
+
 void I_ShutdownGraphics(void);
 
 // Takes full 8 bit values.
@@ -50,6 +68,8 @@ void I_FinishUpdate (void);
 
 void I_ReadScreen (pixel_t* scr);
 
+void I_ReadPalette (byte* rgb);
+
 
 void I_SetWindowTitle(const char *title);
 
@@ -72,6 +92,7 @@ extern bool screenvisible;
 
 extern int vanilla_keyboard_mapping;
 extern bool screensaver_mode;
+extern bool headless_mode;
 extern int usegamma;
 extern pixel_t *I_VideoBuffer;
 
@@ -82,6 +103,7 @@ extern int aspect_ratio_correct;
 extern int integer_scaling;
 extern int vga_porch_flash;
 extern int force_software_renderer;
+extern int cpu_upscaling;
 
 extern int png_screenshots;
 
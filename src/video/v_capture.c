@@ -0,0 +1,676 @@
+//
+// Copyright(C) 1993-1996 Id Software, Inc.
+// Copyright(C) 1993-2008 Raven Software
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	Screenshot and frame capture. Frames are copied into a ring of
+//	jobs on the game thread and encoded on a background thread, so
+//	that compressing a PNG or feeding an encoder does not stall the
+//	game loop.
+//
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "SDL.h"
+
+#include "config.h"
+#include "d_loop.h"
+#include "doomtype.h"
+#include "i_swap.h"
+#include "i_system.h"
+#include "i_timer.h"
+#include "i_video.h"
+#include "m_argv.h"
+#include "m_misc.h"
+#include "v_capture.h"
+
+#ifdef HAVE_LIBPNG
+#include <png.h>
+#endif
+
+#ifdef _WIN32
+#define popen _popen
+#define pclose _pclose
+#define PIPE_MODE "wb"
+#else
+#define PIPE_MODE "w"
+#endif
+
+typedef enum
+{
+    CAPTURE_PCX,
+    CAPTURE_PNG,
+    CAPTURE_RAW,
+} capture_format_t;
+
+typedef struct
+{
+    capture_format_t format;
+
+    // The file to write to. If NULL, filename is opened instead.
+    // handle is closed after writing unless it is the capture pipe.
+    FILE *handle;
+    char *filename;
+
+    // Scale up 5x6 to accommodate aspect ratio correction (PNG only).
+    bool aspect_correct;
+
+    // SCREENWIDTH * SCREENHEIGHT pixels, allocated by StartCapture.
+    pixel_t *screen;
+    byte palette[256 * 3];
+} capture_job_t;
+
+// Jobs are produced only by the game thread and consumed only by the
+// capture thread. The slot at capture_head is filled without holding
+// the lock, because the capture thread does not look at it until
+// capture_head has moved past it.
+
+#define CAPTURE_RING_SIZE 16
+
+static capture_job_t *capture_ring = NULL;
+static unsigned int capture_head;
+static unsigned int capture_tail;
+static bool capture_quit;
+
+static SDL_mutex *capture_mutex = NULL;
+static SDL_cond *capture_cond = NULL;
+static SDL_Thread *capture_thread = NULL;
+
+// Continuous capture: either a numbered frame sequence or a pipe to an
+// external encoder that is fed raw RGB24 frames.
+
+static char *capture_prefix = NULL;
+static FILE *capture_pipe = NULL;
+static int capture_frame;
+static int capture_last_tic;
+static int capture_dropped;
+
+//
+// SCREEN SHOTS
+//
+
+typedef PACKED_STRUCT({
+    char manufacturer;
+    char version;
+    char encoding;
+    char bits_per_pixel;
+
+    unsigned short xmin;
+    unsigned short ymin;
+    unsigned short xmax;
+    unsigned short ymax;
+
+    unsigned short hres;
+    unsigned short vres;
+
+    unsigned char palette[48];
+
+    char reserved;
+    char color_planes;
+    unsigned short bytes_per_line;
+    unsigned short palette_type;
+
+    char filler[58];
+    unsigned char data; // unbounded
+}) pcx_t;
+
+
+//
+// WritePCXfile
+//
+
+static void WritePCXfile(FILE *handle, const pixel_t *data,
+                  int width, int height,
+                  const byte *palette)
+{
+    int		i;
+    int		length;
+    pcx_t*	pcx;
+    byte*	pack;
+
+    // This runs on the capture thread, so it can't use the zone.
+    pcx = malloc(width*height*2+1000);
+    if (!pcx)
+    {
+        return;
+    }
+
+    pcx->manufacturer = 0x0a;		// PCX id
+    pcx->version = 5;			// 256 color
+    pcx->encoding = 1;			// uncompressed
+    pcx->bits_per_pixel = 8;		// 256 color
+    pcx->xmin = 0;
+    pcx->ymin = 0;
+    pcx->xmax = SHORT(width-1);
+    pcx->ymax = SHORT(height-1);
+    pcx->hres = SHORT(1);
+    pcx->vres = SHORT(1);
+    memset (pcx->palette,0,sizeof(pcx->palette));
+    pcx->reserved = 0;                  // PCX spec: reserved byte must be zero
+    pcx->color_planes = 1;		// chunky image
+    pcx->bytes_per_line = SHORT(width);
+    pcx->palette_type = SHORT(2);	// not a grey scale
+    memset (pcx->filler,0,sizeof(pcx->filler));
+
+    // pack the image
+    pack = &pcx->data;
+
+    for (i=0 ; i<width*height ; i++)
+    {
+	if ( (*data & 0xc0) != 0xc0)
+	    *pack++ = *data++;
+	else
+	{
+	    *pack++ = 0xc1;
+	    *pack++ = *data++;
+	}
+    }
+
+    // write the palette
+    *pack++ = 0x0c;	// palette ID byte
+    for (i=0 ; i<768 ; i++)
+	*pack++ = *palette++;
+
+    // write output file
+    length = pack - (byte *)pcx;
+    fwrite(pcx, 1, length, handle);
+
+    free(pcx);
+}
+
+#ifdef HAVE_LIBPNG
+//
+// WritePNGfile
+//
+
+static void error_fn(png_structp p, png_const_charp s)
+{
+    printf("libpng error: %s\n", s);
+}
+
+static void warning_fn(png_structp p, png_const_charp s)
+{
+    printf("libpng warning: %s\n", s);
+}
+
+static void WritePNGfile(FILE *handle, const pixel_t *data,
+                  int width, int height,
+                  const byte *palette, bool aspect_correct)
+{
+    png_structp ppng;
+    png_infop pinfo;
+    png_colorp pcolor;
+    int i, j;
+    int w_factor, h_factor;
+    byte *rowbuf;
+
+    if (aspect_correct)
+    {
+        // scale up to accommodate aspect ratio correction
+        w_factor = 5;
+        h_factor = 6;
+
+        width *= w_factor;
+        height *= h_factor;
+    }
+    else
+    {
+        w_factor = 1;
+        h_factor = 1;
+    }
+
+    ppng = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL,
+                                   error_fn, warning_fn);
+    if (!ppng)
+    {
+        return;
+    }
+
+    pinfo = png_create_info_struct(ppng);
+    if (!pinfo)
+    {
+        png_destroy_write_struct(&ppng, NULL);
+        return;
+    }
+
+    png_init_io(ppng, handle);
+
+    png_set_IHDR(ppng, pinfo, width, height,
+                 8, PNG_COLOR_TYPE_PALETTE, PNG_INTERLACE_NONE,
+                 PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+
+    pcolor = malloc(sizeof(*pcolor) * 256);
+    if (!pcolor)
+    {
+        png_destroy_write_struct(&ppng, &pinfo);
+        return;
+    }
+
+    for (i = 0; i < 256; i++)
+    {
+        pcolor[i].red   = *(palette + 3 * i);
+        pcolor[i].green = *(palette + 3 * i + 1);
+        pcolor[i].blue  = *(palette + 3 * i + 2);
+    }
+
+    png_set_PLTE(ppng, pinfo, pcolor, 256);
+    free(pcolor);
+
+    png_write_info(ppng, pinfo);
+
+    rowbuf = malloc(width);
+
+    if (rowbuf)
+    {
+        for (i = 0; i < SCREENHEIGHT; i++)
+        {
+            // expand the row 5x
+            for (j = 0; j < SCREENWIDTH; j++)
+            {
+                memset(rowbuf + j * w_factor, *(data + i*SCREENWIDTH + j), w_factor);
+            }
+
+            // write the row 6 times
+            for (j = 0; j < h_factor; j++)
+            {
+                png_write_row(ppng, rowbuf);
+            }
+        }
+
+        free(rowbuf);
+    }
+
+    png_write_end(ppng, pinfo);
+    png_destroy_write_struct(&ppng, &pinfo);
+}
+#endif
+
+//
+// Write a frame as raw RGB24, for an external encoder.
+//
+static void WriteRawFrame(FILE *handle, const pixel_t *data,
+                          const byte *palette)
+{
+    size_t row_size = SCREENWIDTH * 3;
+    byte *row = malloc(row_size);
+
+    if (row == NULL)
+    {
+        return;
+    }
+
+    for (int y = 0; y < SCREENHEIGHT; y++)
+    {
+        byte *out = row;
+
+        for (int x = 0; x < SCREENWIDTH; x++)
+        {
+            const byte *c = palette + *data++ * 3;
+            *out++ = c[0];
+            *out++ = c[1];
+            *out++ = c[2];
+        }
+
+        fwrite(row, 1, row_size, handle);
+    }
+
+    free(row);
+}
+
+static void WriteCaptureJob(capture_job_t *job)
+{
+    FILE *handle = job->handle;
+
+    if (handle == NULL)
+    {
+        handle = M_fopen(job->filename, "wb");
+        if (handle == NULL)
+        {
+            fprintf(stderr, "WriteCaptureJob: Failed to open %s\n",
+                    job->filename);
+        }
+    }
+
+    if (handle != NULL)
+    {
+        switch (job->format)
+        {
+            case CAPTURE_PCX:
+                WritePCXfile(handle, job->screen, SCREENWIDTH, SCREENHEIGHT,
+                             job->palette);
+                break;
+#ifdef HAVE_LIBPNG
+            case CAPTURE_PNG:
+                WritePNGfile(handle, job->screen, SCREENWIDTH, SCREENHEIGHT,
+                             job->palette, job->aspect_correct);
+                break;
+#endif
+            case CAPTURE_RAW:
+                WriteRawFrame(handle, job->screen, job->palette);
+                break;
+            default:
+                break;
+        }
+
+        if (handle != capture_pipe)
+        {
+            fclose(handle);
+        }
+    }
+
+    free(job->filename);
+    job->filename = NULL;
+}
+
+static int CaptureThread(void *unused)
+{
+    SDL_LockMutex(capture_mutex);
+
+    for (;;)
+    {
+        while (capture_head == capture_tail && !capture_quit)
+        {
+            SDL_CondWait(capture_cond, capture_mutex);
+        }
+
+        // Only quit once everything queued has been written.
+        if (capture_head == capture_tail)
+        {
+            break;
+        }
+
+        capture_job_t *job = &capture_ring[capture_tail % CAPTURE_RING_SIZE];
+
+        SDL_UnlockMutex(capture_mutex);
+        WriteCaptureJob(job);
+        SDL_LockMutex(capture_mutex);
+
+        ++capture_tail;
+        SDL_CondBroadcast(capture_cond);
+    }
+
+    SDL_UnlockMutex(capture_mutex);
+
+    return 0;
+}
+
+static void ShutdownCapture(void)
+{
+    if (capture_thread != NULL)
+    {
+        SDL_LockMutex(capture_mutex);
+        capture_quit = true;
+        SDL_CondBroadcast(capture_cond);
+        SDL_UnlockMutex(capture_mutex);
+
+        SDL_WaitThread(capture_thread, NULL);
+        capture_thread = NULL;
+    }
+
+    if (capture_pipe != NULL)
+    {
+        pclose(capture_pipe);
+        capture_pipe = NULL;
+    }
+
+    if (capture_dropped > 0)
+    {
+        printf("ShutdownCapture: %d of %d frames were dropped because "
+               "encoding fell behind.\n", capture_dropped, capture_frame);
+    }
+}
+
+//
+// Start the capture thread the first time something is queued. If the
+// thread can't be created, jobs are written synchronously instead.
+//
+static void StartCapture(void)
+{
+    if (capture_ring != NULL)
+    {
+        return;
+    }
+
+    capture_ring = calloc(CAPTURE_RING_SIZE, sizeof(*capture_ring));
+    if (capture_ring == NULL)
+    {
+        I_Error("StartCapture: Out of memory");
+    }
+
+    for (int i = 0; i < CAPTURE_RING_SIZE; i++)
+    {
+        capture_ring[i].screen =
+            malloc(SCREENWIDTH * SCREENHEIGHT * sizeof(pixel_t));
+        if (capture_ring[i].screen == NULL)
+        {
+            I_Error("StartCapture: Out of memory");
+        }
+    }
+
+    capture_mutex = SDL_CreateMutex();
+    capture_cond = SDL_CreateCond();
+
+    if (capture_mutex != NULL && capture_cond != NULL)
+    {
+        capture_thread = SDL_CreateThread(CaptureThread, "capture", NULL);
+    }
+
+    if (capture_thread == NULL)
+    {
+        fprintf(stderr, "StartCapture: Failed to create capture thread, "
+                        "frames will be written synchronously.\n");
+    }
+
+    // Queued screenshots are still written on a clean exit.
+    I_AtExit(ShutdownCapture, false);
+}
+
+//
+// Get the next free job. If the ring is full, either wait for the
+// capture thread to catch up or give up and return NULL.
+//
+static capture_job_t *BeginJob(bool wait)
+{
+    capture_job_t *job;
+
+    StartCapture();
+
+    if (capture_thread == NULL)
+    {
+        return &capture_ring[0];
+    }
+
+    SDL_LockMutex(capture_mutex);
+
+    while (capture_head - capture_tail == CAPTURE_RING_SIZE)
+    {
+        if (!wait)
+        {
+            SDL_UnlockMutex(capture_mutex);
+            return NULL;
+        }
+
+        SDL_CondWait(capture_cond, capture_mutex);
+    }
+
+    job = &capture_ring[capture_head % CAPTURE_RING_SIZE];
+
+    SDL_UnlockMutex(capture_mutex);
+
+    return job;
+}
+
+static void CommitJob(capture_job_t *job)
+{
+    if (capture_thread == NULL)
+    {
+        WriteCaptureJob(job);
+        return;
+    }
+
+    SDL_LockMutex(capture_mutex);
+    ++capture_head;
+    SDL_CondBroadcast(capture_cond);
+    SDL_UnlockMutex(capture_mutex);
+}
+
+void V_QueueScreenShot(FILE *handle, const pixel_t *screen,
+                       const byte *palette, bool png)
+{
+    // Screenshots are never dropped.
+    capture_job_t *job = BeginJob(true);
+
+    job->format = png ? CAPTURE_PNG : CAPTURE_PCX;
+    job->handle = handle;
+    job->filename = NULL;
+    job->aspect_correct = aspect_ratio_correct == 1;
+    memcpy(job->screen, screen,
+           SCREENWIDTH * SCREENHEIGHT * sizeof(*job->screen));
+    memcpy(job->palette, palette, sizeof(job->palette));
+
+    CommitJob(job);
+}
+
+void V_InitCapture(void)
+{
+    int i;
+
+    //!
+    // @category video
+    // @arg <prefix>
+    //
+    // Capture every frame to a numbered sequence of lossless images
+    // named <prefix>000000.png (or .pcx without PNG support), at the game
+    // tic rate.
+    //
+
+    i = M_CheckParmWithArgs("-capture", 1);
+
+    if (i > 0)
+    {
+        capture_prefix = myargv[i + 1];
+    }
+
+    //!
+    // @category video
+    // @arg <command>
+    //
+    // Pipe every frame to the standard input of the given command as
+    // raw RGB24 video at 35 frames per second. Frames are 320x200 times
+    // the render scale (see -renderscale), e.g. for ffmpeg at scale 1:
+    // "ffmpeg -f rawvideo -pixel_format rgb24 -video_size 320x200
+    // -framerate 35 -i - out.mkv".
+    //
+
+    i = M_CheckParmWithArgs("-capturepipe", 1);
+
+    if (i > 0)
+    {
+        capture_pipe = popen(myargv[i + 1], PIPE_MODE);
+        if (capture_pipe == NULL)
+        {
+            I_Error("V_InitCapture: Failed to run '%s'", myargv[i + 1]);
+        }
+    }
+
+    if (capture_prefix != NULL || capture_pipe != NULL)
+    {
+        StartCapture();
+    }
+}
+
+static void QueueCaptureFrame(void)
+{
+    capture_job_t *job;
+
+    // Never stall the game for continuous capture: if the encoder is
+    // behind, drop the frame.
+    job = BeginJob(false);
+    if (job == NULL)
+    {
+        ++capture_dropped;
+        ++capture_frame;
+        return;
+    }
+
+    if (capture_pipe != NULL)
+    {
+        job->format = CAPTURE_RAW;
+        job->handle = capture_pipe;
+        job->filename = NULL;
+    }
+    else
+    {
+#ifdef HAVE_LIBPNG
+        job->format = CAPTURE_PNG;
+#else
+        job->format = CAPTURE_PCX;
+#endif
+        size_t len = strlen(capture_prefix) + 16;
+
+        job->handle = NULL;
+        job->filename = malloc(len);
+        M_snprintf(job->filename, len, "%s%06d.%s", capture_prefix,
+                   capture_frame, job->format == CAPTURE_PNG ? "png" : "pcx");
+    }
+
+    job->aspect_correct = false;
+    memcpy(job->screen, I_VideoBuffer,
+           SCREENWIDTH * SCREENHEIGHT * sizeof(*job->screen));
+    I_ReadPalette(job->palette);
+
+    CommitJob(job);
+    ++capture_frame;
+}
+
+void V_CaptureFrame(void)
+{
+    int tic, tics;
+
+    if (capture_prefix == NULL && capture_pipe == NULL)
+    {
+        return;
+    }
+
+    // Capture at the game's frame rate: one frame per tic, repeating the
+    // frame if tics were skipped. With -timedemo and friends every frame
+    // is a tic.
+    if (singletics)
+    {
+        QueueCaptureFrame();
+        return;
+    }
+
+    tic = I_GetTime();
+
+    if (capture_frame == 0)
+    {
+        capture_last_tic = tic - 1;
+    }
+
+    tics = tic - capture_last_tic;
+    capture_last_tic = tic;
+
+    // Don't fill the ring with copies of one frame after a long stall.
+    if (tics > TICRATE)
+    {
+        tics = TICRATE;
+    }
+
+    while (tics-- > 0)
+    {
+        QueueCaptureFrame();
+    }
+}
@@ -0,0 +1,44 @@
+//
+// Copyright(C) 1993-1996 Id Software, Inc.
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	Screenshot and frame capture, encoded on a background thread.
+//
+
+#ifndef __V_CAPTURE__
+#define __V_CAPTURE__
+
+#include <stdio.h>
+
+#include "doomtype.h"
+
+//
+// Queue a copy of the screen and palette to be written as a PCX or PNG
+// screenshot to an already opened file, which is closed once written.
+//
+void V_QueueScreenShot(FILE* handle, const pixel_t* screen,
+                       const byte* palette, bool png);
+
+//
+// Check the command line for continuous capture and start it.
+//
+void V_InitCapture(void);
+
+//
+// Called for every finished frame. Queues the frame for continuous
+// capture, once per game tic.
+//
+void V_CaptureFrame(void);
+
+#endif
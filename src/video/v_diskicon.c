@@ -17,7 +17,10 @@
 //
 
 
+#include <stdlib.h>
+
 #include "doomtype.h"
+#include "i_system.h"
 #include "i_video.h"
 #include "v_video.h"
 #include "w_wad.h"
@@ -36,9 +39,13 @@ static const int diskicon_threshold = 20*1024;
 static pixel_t *disk_data;
 static pixel_t *saved_background;
 
+// Position of the disk on the screen, and its size, in screen pixels.
 static int loading_disk_xoffs = 0;
 static int loading_disk_yoffs = 0;
 
+#define DISK_W (LOADING_DISK_W * render_scale)
+#define DISK_H (LOADING_DISK_H * render_scale)
+
 // Number of bytes read since the last call to V_DrawDiskIcon().
 static size_t recent_bytes_read = 0;
 static bool disk_drawn;
@@ -61,8 +68,8 @@ static void SaveDiskData(const char *disk_lump, int xoffs, int yoffs)
     patch_t *disk;
 
     // Allocate a complete temporary screen where we'll draw the patch.
-    tmpscreen = Z_Malloc(SCREENWIDTH * SCREENHEIGHT * sizeof(*tmpscreen),
-                         PU_STATIC, NULL);
+    // It grows with render_scale, so it is kept out of the zone.
+    tmpscreen = I_Realloc(NULL, SCREENWIDTH * SCREENHEIGHT * sizeof(*tmpscreen));
     memset(tmpscreen, 0, SCREENWIDTH * SCREENHEIGHT * sizeof(*tmpscreen));
     V_UseBuffer(tmpscreen);
 
@@ -74,25 +81,26 @@ static void SaveDiskData(const char *disk_lump, int xoffs, int yoffs)
         disk_data = NULL;
     }
 
-    disk_data = Z_Malloc(LOADING_DISK_W * LOADING_DISK_H * sizeof(*disk_data),
+    disk_data = Z_Malloc(DISK_W * DISK_H * sizeof(*disk_data),
                          PU_STATIC, NULL);
 
     // Draw the patch and save the result to disk_data.
     disk = W_CacheLumpName(disk_lump, PU_STATIC);
-    V_DrawPatch(loading_disk_xoffs, loading_disk_yoffs, disk);
-    CopyRegion(disk_data, LOADING_DISK_W,
-               tmpscreen + yoffs * SCREENWIDTH + xoffs, SCREENWIDTH,
-               LOADING_DISK_W, LOADING_DISK_H);
+    V_DrawPatch(xoffs, yoffs, disk);
+    CopyRegion(disk_data, DISK_W,
+               tmpscreen + loading_disk_yoffs * SCREENWIDTH
+                         + loading_disk_xoffs, SCREENWIDTH,
+               DISK_W, DISK_H);
     W_ReleaseLumpName(disk_lump);
 
     V_RestoreBuffer();
-    Z_Free(tmpscreen);
+    free(tmpscreen);
 }
 
 void V_EnableLoadingDisk(const char *lump_name, int xoffs, int yoffs)
 {
-    loading_disk_xoffs = xoffs;
-    loading_disk_yoffs = yoffs;
+    loading_disk_xoffs = xoffs * render_scale;
+    loading_disk_yoffs = yoffs * render_scale;
 
     if (saved_background != NULL)
     {
@@ -100,7 +108,7 @@ void V_EnableLoadingDisk(const char *lump_name, int xoffs, int yoffs)
         saved_background = NULL;
     }
 
-    saved_background = Z_Malloc(LOADING_DISK_W * LOADING_DISK_H
+    saved_background = Z_Malloc(DISK_W * DISK_H
                                  * sizeof(*saved_background),
                                 PU_STATIC, NULL);
     SaveDiskData(lump_name, xoffs, yoffs);
@@ -121,14 +129,14 @@ static pixel_t *DiskRegionPointer(void)
 void V_DrawDiskIcon(void) {
     if (disk_data != NULL && recent_bytes_read > diskicon_threshold) {
         // Save the background behind the disk before we draw it.
-        CopyRegion(saved_background, LOADING_DISK_W,
+        CopyRegion(saved_background, DISK_W,
                    DiskRegionPointer(), SCREENWIDTH,
-                   LOADING_DISK_W, LOADING_DISK_H);
+                   DISK_W, DISK_H);
 
         // Write the disk to the screen buffer.
         CopyRegion(DiskRegionPointer(), SCREENWIDTH,
-                   disk_data, LOADING_DISK_W,
-                   LOADING_DISK_W, LOADING_DISK_H);
+                   disk_data, DISK_W,
+                   DISK_W, DISK_H);
         disk_drawn = true;
     }
 
@@ -141,9 +149,9 @@ void V_RestoreDiskBackground(void) {
         pixel_t* dest = DiskRegionPointer();
         pixel_t* src = saved_background;
         int dest_pitch = SCREENWIDTH;
-        int src_pitch = LOADING_DISK_W;
-        int w = LOADING_DISK_W;
-        int h = LOADING_DISK_H;
+        int src_pitch = DISK_W;
+        int w = DISK_W;
+        int h = DISK_H;
         CopyRegion(dest, dest_pitch, src, src_pitch, w, h);
 
         disk_drawn = false;
@@ -36,9 +36,7 @@
 #include "z_zone.h"
 
 #include "config.h"
-#ifdef HAVE_LIBPNG
-#include <png.h>
-#endif
+#include "v_capture.h"
 
 // TODO: There are separate RANGECHECK defines for different games, but this
 // is common code. Fix this.
@@ -51,9 +49,29 @@
 static pixel_t *dest_screen = NULL;
 
 
+//
+// Fill the render_scale x render_scale block of pixels that the original
+// resolution pixel at (x, y) covers.
+//
+static void V_FillScaledRect(pixel_t* dest, int x, int y, int w, int h,
+                             pixel_t color)
+{
+    pixel_t* buf = dest + (y * render_scale) * SCREENWIDTH + x * render_scale;
+    int width = w * render_scale;
+
+    for (int y1 = 0; y1 < h * render_scale; y1++) {
+        memset(buf, color, width * sizeof(*buf));
+        buf += SCREENWIDTH;
+    }
+}
+
 static void V_DrawPixel(int x, int y, pixel_t color) {
-    int screen_spot = x + (y * SCREENWIDTH);
-    dest_screen[screen_spot] = color;
+    if (render_scale == 1) {
+        int screen_spot = x + (y * SCREENWIDTH);
+        dest_screen[screen_spot] = color;
+        return;
+    }
+    V_FillScaledRect(dest_screen, x, y, 1, 1, color);
 }
 
 
@@ -69,18 +87,25 @@ void V_CopyRect(int srcx, int srcy, pixel_t *source,
  
 #ifdef RANGECHECK 
     if (srcx < 0
-     || srcx + width > SCREENWIDTH
+     || srcx + width > ORIGWIDTH
      || srcy < 0
-     || srcy + height > SCREENHEIGHT 
+     || srcy + height > ORIGHEIGHT 
      || destx < 0
-     || destx + width > SCREENWIDTH
+     || destx + width > ORIGWIDTH
      || desty < 0
-     || desty + height > SCREENHEIGHT)
+     || desty + height > ORIGHEIGHT)
     {
         I_Error ("Bad V_CopyRect");
     }
 #endif
- 
+
+    srcx *= render_scale;
+    srcy *= render_scale;
+    destx *= render_scale;
+    desty *= render_scale;
+    width *= render_scale;
+    height *= render_scale;
+
     src = source + SCREENWIDTH * srcy + srcx; 
     dest = dest_screen + SCREENWIDTH * desty + destx; 
 
@@ -93,14 +118,32 @@ void V_CopyRect(int srcx, int srcy, pixel_t *source,
 }
 
 //
-// Step through the posts in a column.
+// Step through the posts in a column, moving a pointer down the screen
+// a row at a time.
 //
-static void V_DrawColumn(int x, int y, column_t* column) {
+static void V_DrawColumn(int x, int y, const column_t* column) {
+    int pitch = SCREENWIDTH * render_scale;
+    pixel_t* top = dest_screen + (y * pitch) + (x * render_scale);
+
     while (column->topdelta != END_COLUMN) {
-        for (int row = 0; row < column->length; row++) {
-            int screen_y = y + row + column->topdelta;
-            pixel_t color = column->data[row];
-            V_DrawPixel(x, screen_y, color);
+        pixel_t* dest = top + (column->topdelta * pitch);
+        const byte* src = column->data;
+        int count = column->length;
+
+        if (render_scale == 1) {
+            while (count--) {
+                *dest = *src++;
+                dest += SCREENWIDTH;
+            }
+        } else {
+            // Each source pixel covers a render_scale square.
+            while (count--) {
+                for (int i = 0; i < render_scale; i++) {
+                    memset(dest, *src, render_scale * sizeof(*dest));
+                    dest += SCREENWIDTH;
+                }
+                src++;
+            }
         }
 
         column = NEXT_COLUMN(column);
@@ -113,7 +156,7 @@ static void V_CheckPatch(int x, int y, const patch_t* patch) {
     int y1 = y;
     int y2 = y1 + SHORT(patch->height);
 
-    if (x1 < 0 || y1 < 0 || x2 > SCREENWIDTH || y2 > SCREENHEIGHT) {
+    if (x1 < 0 || y1 < 0 || x2 > ORIGWIDTH || y2 > ORIGHEIGHT) {
         I_Error("Bad V_DrawPatch");
     }
 }
@@ -155,57 +198,74 @@ void V_DrawPatchFlipped(int x, int y, patch_t* patch) {
     }
 }
 
+//
+// V_DrawPatchColumn
+// Draw a single column of a patch, unmasked by any offsets.
+//
+void V_DrawPatchColumn(int x, int y, patch_t* patch, int col) {
+    V_DrawColumn(x, y, GET_COLUMN(patch, col));
+}
+
 //
 // V_DrawBlock
 // Draw a linear block of pixels into the view buffer.
 //
 void V_DrawBlock(int x, int y, int width, int height, const  pixel_t *src) {
-    if (x < 0 || x + width > SCREENWIDTH || y < 0 || y + height > SCREENHEIGHT) {
+    if (x < 0 || x + width > ORIGWIDTH || y < 0 || y + height > ORIGHEIGHT) {
         I_Error("Bad V_DrawBlock");
     }
 
-    int spot = x + (y * SCREENWIDTH);
-    pixel_t* dest = &dest_screen[spot];
+    pixel_t* dest = &dest_screen[(y * SCREENWIDTH + x) * render_scale];
+
+    if (render_scale == 1) {
+        while (height--) {
+            memcpy(dest, src, width * sizeof(*dest));
+            src += width;
+            dest += SCREENWIDTH;
+        }
+        return;
+    }
 
+    // Widen each source row once, then copy it down the rest of the
+    // rows it covers.
+    int row_size = width * render_scale * sizeof(*dest);
     while (height--) {
-        memcpy(dest, src, width * sizeof(*dest));
-        src += width;
-        dest += SCREENWIDTH;
+        for (int x1 = 0; x1 < width; x1++) {
+            memset(&dest[x1 * render_scale], *src++, render_scale * sizeof(*dest));
+        }
+        for (int i = 1; i < render_scale; i++) {
+            memcpy(&dest[i * SCREENWIDTH], dest, row_size);
+        }
+        dest += SCREENWIDTH * render_scale;
     }
 }
 
-void V_DrawFilledBox(int x, int y, int w, int h, int c) {
-    int spot = x + (y * SCREENWIDTH);
-    pixel_t* buf = &I_VideoBuffer[spot];
-    for (int y1 = 0; y1 < h; y1++) {
-        pixel_t* buf1 = buf;
-        for (int x1 = 0; x1 < w; x1++) {
-            *buf1++ = (pixel_t) c;
+//
+// V_FillFlat
+// Tile a 64x64 flat over the top rows of the screen.
+//
+void V_FillFlat(int height, const byte* flat) {
+    pixel_t* dest = dest_screen;
+
+    for (int y = 0; y < height * render_scale; y++) {
+        const byte* src = flat + (((y / render_scale) & 63) << 6);
+        for (int x = 0; x < SCREENWIDTH; x++) {
+            *dest++ = src[(x / render_scale) & 63];
         }
-        buf += SCREENWIDTH;
     }
 }
 
+void V_DrawFilledBox(int x, int y, int w, int h, int c) {
+    V_FillScaledRect(I_VideoBuffer, x, y, w, h, (pixel_t) c);
+}
+
 void V_DrawHorizLine(int x, int y, int w, int c) {
-    int spot = x + (y * SCREENWIDTH);
-    pixel_t* buf = &I_VideoBuffer[spot];
-    for (int x1 = 0; x1 < w; x1++) {
-        *buf++ = (pixel_t) c;
-    }
+    V_FillScaledRect(I_VideoBuffer, x, y, w, 1, (pixel_t) c);
 }
 
 void V_DrawVertLine(int x, int y, int h, int c)
 {
-    pixel_t *buf;
-    int y1;
-
-    buf = I_VideoBuffer + SCREENWIDTH * y + x;
-
-    for (y1 = 0; y1 < h; ++y1)
-    {
-        *buf = c;
-        buf += SCREENWIDTH;
-    }
+    V_FillScaledRect(I_VideoBuffer, x, y, 1, h, (pixel_t) c);
 }
 
 void V_DrawBox(int x, int y, int w, int h, int c) {
@@ -239,212 +299,6 @@ void V_RestoreBuffer() {
     dest_screen = I_VideoBuffer;
 }
 
-//
-// SCREEN SHOTS
-//
-
-typedef PACKED_STRUCT({
-    char manufacturer;
-    char version;
-    char encoding;
-    char bits_per_pixel;
-
-    unsigned short xmin;
-    unsigned short ymin;
-    unsigned short xmax;
-    unsigned short ymax;
-
-    unsigned short hres;
-    unsigned short vres;
-
-    unsigned char palette[48];
-
-    char reserved;
-    char color_planes;
-    unsigned short bytes_per_line;
-    unsigned short palette_type;
-
-    char filler[58];
-    unsigned char data; // unbounded
-}) pcx_t;
-
-
-//
-// WritePCXfile
-//
-
-static void WritePCXfile(char *filename, pixel_t *data,
-                  int width, int height,
-                  byte *palette)
-{
-    int		i;
-    int		length;
-    pcx_t*	pcx;
-    byte*	pack;
-	
-    pcx = Z_Malloc (width*height*2+1000, PU_STATIC, NULL);
-
-    pcx->manufacturer = 0x0a;		// PCX id
-    pcx->version = 5;			// 256 color
-    pcx->encoding = 1;			// uncompressed
-    pcx->bits_per_pixel = 8;		// 256 color
-    pcx->xmin = 0;
-    pcx->ymin = 0;
-    pcx->xmax = SHORT(width-1);
-    pcx->ymax = SHORT(height-1);
-    pcx->hres = SHORT(1);
-    pcx->vres = SHORT(1);
-    memset (pcx->palette,0,sizeof(pcx->palette));
-    pcx->reserved = 0;                  // PCX spec: reserved byte must be zero
-    pcx->color_planes = 1;		// chunky image
-    pcx->bytes_per_line = SHORT(width);
-    pcx->palette_type = SHORT(2);	// not a grey scale
-    memset (pcx->filler,0,sizeof(pcx->filler));
-
-    // pack the image
-    pack = &pcx->data;
-	
-    for (i=0 ; i<width*height ; i++)
-    {
-	if ( (*data & 0xc0) != 0xc0)
-	    *pack++ = *data++;
-	else
-	{
-	    *pack++ = 0xc1;
-	    *pack++ = *data++;
-	}
-    }
-    
-    // write the palette
-    *pack++ = 0x0c;	// palette ID byte
-    for (i=0 ; i<768 ; i++)
-	*pack++ = *palette++;
-    
-    // write output file
-    length = pack - (byte *)pcx;
-    M_WriteFile (filename, pcx, length);
-
-    Z_Free (pcx);
-}
-
-#ifdef HAVE_LIBPNG
-//
-// WritePNGfile
-//
-
-static void error_fn(png_structp p, png_const_charp s)
-{
-    printf("libpng error: %s\n", s);
-}
-
-static void warning_fn(png_structp p, png_const_charp s)
-{
-    printf("libpng warning: %s\n", s);
-}
-
-void WritePNGfile(char *filename, pixel_t *data,
-                  int width, int height,
-                  byte *palette)
-{
-    png_structp ppng;
-    png_infop pinfo;
-    png_colorp pcolor;
-    FILE *handle;
-    int i, j;
-    int w_factor, h_factor;
-    byte *rowbuf;
-
-    if (aspect_ratio_correct == 1)
-    {
-        // scale up to accommodate aspect ratio correction
-        w_factor = 5;
-        h_factor = 6;
-
-        width *= w_factor;
-        height *= h_factor;
-    }
-    else
-    {
-        w_factor = 1;
-        h_factor = 1;
-    }
-
-    handle = M_fopen(filename, "wb");
-    if (!handle)
-    {
-        return;
-    }
-
-    ppng = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL,
-                                   error_fn, warning_fn);
-    if (!ppng)
-    {
-        fclose(handle);
-        return;
-    }
-
-    pinfo = png_create_info_struct(ppng);
-    if (!pinfo)
-    {
-        fclose(handle);
-        png_destroy_write_struct(&ppng, NULL);
-        return;
-    }
-
-    png_init_io(ppng, handle);
-
-    png_set_IHDR(ppng, pinfo, width, height,
-                 8, PNG_COLOR_TYPE_PALETTE, PNG_INTERLACE_NONE,
-                 PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
-
-    pcolor = malloc(sizeof(*pcolor) * 256);
-    if (!pcolor)
-    {
-        fclose(handle);
-        png_destroy_write_struct(&ppng, &pinfo);
-        return;
-    }
-
-    for (i = 0; i < 256; i++)
-    {
-        pcolor[i].red   = *(palette + 3 * i);
-        pcolor[i].green = *(palette + 3 * i + 1);
-        pcolor[i].blue  = *(palette + 3 * i + 2);
-    }
-
-    png_set_PLTE(ppng, pinfo, pcolor, 256);
-    free(pcolor);
-
-    png_write_info(ppng, pinfo);
-
-    rowbuf = malloc(width);
-
-    if (rowbuf)
-    {
-        for (i = 0; i < SCREENHEIGHT; i++)
-        {
-            // expand the row 5x
-            for (j = 0; j < SCREENWIDTH; j++)
-            {
-                memset(rowbuf + j * w_factor, *(data + i*SCREENWIDTH + j), w_factor);
-            }
-
-            // write the row 6 times
-            for (j = 0; j < h_factor; j++)
-            {
-                png_write_row(ppng, rowbuf);
-            }
-        }
-
-        free(rowbuf);
-    }
-
-    png_write_end(ppng, pinfo);
-    png_destroy_write_struct(&ppng, &pinfo);
-    fclose(handle);
-}
-#endif
-
 //
 // V_ScreenShot
 //
@@ -454,6 +308,7 @@ void V_ScreenShot(const char *format)
     int i;
     char lbmname[16]; // haleyjd 20110213: BUG FIX - 12 is too small!
     const char *ext;
+    FILE *handle;
     
     // find a file name to save it to
 
@@ -492,26 +347,22 @@ void V_ScreenShot(const char *format)
         }
     }
 
-#ifdef HAVE_LIBPNG
-    if (png_screenshots)
-    {
-    WritePNGfile(lbmname, I_VideoBuffer,
-                 SCREENWIDTH, SCREENHEIGHT,
-                 W_CacheLumpName (DEH_String("PLAYPAL"), PU_CACHE));
-    }
-    else
-#endif
+    // Create the file now, so that the name is taken before the
+    // screenshot is written in the background.
+    handle = M_fopen(lbmname, "wb");
+    if (handle == NULL)
     {
-    // save the pcx file
-    WritePCXfile(lbmname, I_VideoBuffer,
-                 SCREENWIDTH, SCREENHEIGHT,
-                 W_CacheLumpName (DEH_String("PLAYPAL"), PU_CACHE));
+        return;
     }
+
+    V_QueueScreenShot(handle, I_VideoBuffer,
+                      W_CacheLumpName(DEH_String("PLAYPAL"), PU_CACHE),
+                      strcmp(ext, "png") == 0);
 }
 
 #define MOUSE_SPEED_BOX_WIDTH  120
 #define MOUSE_SPEED_BOX_HEIGHT 9
-#define MOUSE_SPEED_BOX_X (SCREENWIDTH - MOUSE_SPEED_BOX_WIDTH - 10)
+#define MOUSE_SPEED_BOX_X (ORIGWIDTH - MOUSE_SPEED_BOX_WIDTH - 10)
 #define MOUSE_SPEED_BOX_Y 15
 
 //
@@ -46,12 +46,18 @@ void V_CopyRect(int srcx, int srcy, pixel_t *source, int width, int height,
 
 void V_DrawPatch(int x, int y, patch_t* patch);
 void V_DrawPatchFlipped(int x, int y, patch_t* patch);
+void V_DrawPatchColumn(int x, int y, patch_t* patch, int col);
 
 //
 // Draw a linear block of pixels into the view buffer.
 //
 void V_DrawBlock(int x, int y, int width, int height, const pixel_t* src);
 
+//
+// Tile a 64x64 flat over the top height rows of the screen.
+//
+void V_FillFlat(int height, const byte* flat);
+
 void V_DrawFilledBox(int x, int y, int w, int h, int c);
 void V_DrawHorizLine(int x, int y, int w, int c);
 void V_DrawVertLine(int x, int y, int h, int c);